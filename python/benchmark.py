@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""
+Benchmark: frames/s of the batch API versus one call per frame (ctypes, the previous way of using librenard from Python)
+
+Usage: python3 benchmark.py [frames] [threads]
+The per-call path needs a shared library build of librenard, e.g.:
+	cc -shared -fPIC -O2 -Isrc src/*.c -o librenard.so
+and is skipped if LIBRENARD_SO (default: ../librenard.so) does not exist.
+"""
+import ctypes
+import os
+import sys
+import time
+
+import numpy as np
+
+import librenard
+
+frames = int(sys.argv[1]) if len(sys.argv) > 1 else 100000
+threads = int(sys.argv[2]) if len(sys.argv) > 2 else os.cpu_count()
+
+def report(name, count, seconds):
+	print("%-40s %10.0f frames/s" % (name, count / seconds))
+
+def timed(function, *args, **kwargs):
+	start = time.perf_counter()
+	result = function(*args, **kwargs)
+	return result, time.perf_counter() - start
+
+"""
+Random uplinks / downlinks
+"""
+rng = np.random.default_rng(1)
+
+common = np.zeros(frames, librenard.commoninfo)
+common["devid"] = rng.integers(0, 2**32, frames, dtype = np.uint32)
+common["seqnum"] = rng.integers(0, 4096, frames, dtype = np.uint16)
+common["key"] = rng.integers(0, 256, (frames, 16), dtype = np.uint8)
+
+ul = np.zeros(frames, librenard.ul_plain)
+ul["payloadlen"] = rng.integers(1, librenard.UL_MAX_PAYLOADLEN + 1, frames)
+ul["payload"] = rng.integers(0, 256, (frames, librenard.UL_MAX_PAYLOADLEN), dtype = np.uint8)
+ul["replicas"] = True
+ul_valid = np.arange(librenard.UL_MAX_PAYLOADLEN) < ul["payloadlen"][:, None]
+
+dl = np.zeros(frames, librenard.dl_plain)
+dl["payload"] = rng.integers(0, 256, (frames, librenard.DL_PAYLOADLEN), dtype = np.uint8)
+
+"""
+Batch API
+"""
+for t in sorted(set([1, threads])):
+	(ul_encoded, errors), seconds = timed(librenard.uplink_encode, ul, common, threads = t)
+	assert (errors == librenard.ULE_ERR_NONE).all()
+	report("batch uplink_encode, %d thread(s)" % t, frames, seconds)
+
+	(ul_decoded, ul_common, errors), seconds = timed(librenard.uplink_decode, ul_encoded, common.copy(), check_mac = True, threads = t)
+	assert (errors == librenard.ULD_ERR_NONE).all() and (ul_decoded["payload"][ul_valid] == ul["payload"][ul_valid]).all()
+	report("batch uplink_decode, %d thread(s)" % t, frames, seconds)
+
+	dl_encoded, seconds = timed(librenard.downlink_encode, dl, common, threads = t)
+	report("batch downlink_encode, %d thread(s)" % t, frames, seconds)
+
+	dl_decoded, seconds = timed(librenard.downlink_decode, dl_encoded, common, threads = t)
+	assert dl_decoded["crc_ok"].all() and dl_decoded["mac_ok"].all() and (dl_decoded["payload"] == dl["payload"]).all()
+	report("batch downlink_decode, %d thread(s)" % t, frames, seconds)
+
+"""
+Per-call path via ctypes, structs are passed by value
+"""
+sofile = os.environ.get("LIBRENARD_SO", os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "librenard.so"))
+if not os.path.exists(sofile):
+	print("%s not found, skipping per-call benchmark" % sofile)
+	sys.exit(0)
+
+lib = ctypes.CDLL(sofile)
+
+def ctype(dtype):
+	return type(str(dtype), (ctypes.Structure,), { "_fields_": [("raw", ctypes.c_uint8 * dtype.itemsize)] })
+
+CommonInfo, UlPlain, UlEncoded, DlPlain, DlEncoded = map(ctype, (librenard.commoninfo, librenard.ul_plain, librenard.ul_encoded, librenard.dl_plain, librenard.dl_encoded))
+
+lib.sfx_uplink_encode.argtypes = [UlPlain, CommonInfo, ctypes.POINTER(UlEncoded)]
+lib.sfx_uplink_decode.argtypes = [UlEncoded, ctypes.POINTER(UlPlain), ctypes.POINTER(CommonInfo), ctypes.c_bool]
+lib.sfx_downlink_encode.argtypes = [DlPlain, CommonInfo, ctypes.POINTER(DlEncoded)]
+lib.sfx_downlink_decode.argtypes = [DlEncoded, CommonInfo, ctypes.POINTER(DlPlain)]
+
+def percall_uplink_encode():
+	out = UlEncoded()
+	for i in range(frames):
+		lib.sfx_uplink_encode(UlPlain.from_buffer_copy(ul[i].tobytes()), CommonInfo.from_buffer_copy(common[i].tobytes()), ctypes.byref(out))
+		ul_encoded[i] = np.frombuffer(bytes(out), librenard.ul_encoded)[0]
+
+def percall_uplink_decode():
+	plain, info = UlPlain(), CommonInfo()
+	for i in range(frames):
+		info = CommonInfo.from_buffer_copy(common[i].tobytes())
+		lib.sfx_uplink_decode(UlEncoded.from_buffer_copy(ul_encoded[i].tobytes()), ctypes.byref(plain), ctypes.byref(info), True)
+		ul_decoded[i] = np.frombuffer(bytes(plain), librenard.ul_plain)[0]
+
+def percall_downlink_encode():
+	out = DlEncoded()
+	for i in range(frames):
+		lib.sfx_downlink_encode(DlPlain.from_buffer_copy(dl[i].tobytes()), CommonInfo.from_buffer_copy(common[i].tobytes()), ctypes.byref(out))
+		dl_encoded[i] = np.frombuffer(bytes(out), librenard.dl_encoded)[0]
+
+def percall_downlink_decode():
+	plain = DlPlain()
+	for i in range(frames):
+		lib.sfx_downlink_decode(DlEncoded.from_buffer_copy(dl_encoded[i].tobytes()), CommonInfo.from_buffer_copy(common[i].tobytes()), ctypes.byref(plain))
+		dl_decoded[i] = np.frombuffer(bytes(plain), librenard.dl_plain)[0]
+
+for name, function in [("uplink_encode", percall_uplink_encode), ("uplink_decode", percall_uplink_decode),
+		("downlink_encode", percall_downlink_encode), ("downlink_decode", percall_downlink_decode)]:
+	_, seconds = timed(function)
+	report("per-call (ctypes) %s" % name, frames, seconds)
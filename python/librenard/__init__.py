@@ -0,0 +1,109 @@
+"""
+Batch Sigfox frame encoding / decoding with librenard
+
+The functions of the _librenard extension operate on NumPy arrays whose dtypes match librenard's C structs,
+see the dtypes below. Outputs are written into caller-provided arrays without copying, the convenience
+wrappers in this module allocate them if they are not given.
+"""
+import numpy as np
+
+from . import _librenard
+
+# Frame and field lengths, see uplink.h / downlink.h
+UL_MAX_FRAMELEN = 24
+UL_MAX_PAYLOADLEN = 12
+DL_FRAMELEN = 15
+DL_PAYLOADLEN = 8
+
+# sfx_ul_plain
+ul_plain = np.dtype([
+	("payload", np.uint8, (UL_MAX_PAYLOADLEN,)),
+	("payloadlen", np.uint8),
+	("request_downlink", np.bool_),
+	("singlebit", np.bool_),
+	("replicas", np.bool_)
+], align=True)
+
+# sfx_ul_encoded
+ul_encoded = np.dtype([
+	("frame", np.uint8, (3, UL_MAX_FRAMELEN)),
+	("framelen_nibbles", np.uint8)
+], align=True)
+
+# sfx_dl_plain
+dl_plain = np.dtype([
+	("payload", np.uint8, (DL_PAYLOADLEN,)),
+	("crc_ok", np.bool_),
+	("mac_ok", np.bool_),
+	("fec_corrected", np.bool_)
+], align=True)
+
+# sfx_dl_encoded
+dl_encoded = np.dtype([
+	("frame", np.uint8, (DL_FRAMELEN,))
+], align=True)
+
+# sfx_commoninfo
+commoninfo = np.dtype([
+	("seqnum", np.uint16),
+	("devid", np.uint32),
+	("key", np.uint8, (16,))
+], align=True)
+
+assert ul_plain.itemsize == _librenard.UL_PLAIN_SIZE
+assert ul_encoded.itemsize == _librenard.UL_ENCODED_SIZE
+assert dl_plain.itemsize == _librenard.DL_PLAIN_SIZE
+assert dl_encoded.itemsize == _librenard.DL_ENCODED_SIZE
+assert commoninfo.itemsize == _librenard.COMMONINFO_SIZE
+
+# sfx_ule_err / sfx_uld_err values
+ULE_ERR_NONE = 0
+ULD_ERR_NONE = 0
+
+def _check(array, dtype, name):
+	if array.dtype != dtype or not array.flags.c_contiguous:
+		raise TypeError("%s must be a C-contiguous array of dtype librenard.%s" % (name, name))
+
+def uplink_encode(plain, common, encoded = None, errors = None, threads = 1):
+	"""
+	Encode uplinks, returns (encoded, errors): arrays of dtype ul_encoded and uint8 (sfx_ule_err).
+	"""
+	_check(plain, ul_plain, "ul_plain")
+	_check(common, commoninfo, "commoninfo")
+	encoded = np.empty(len(plain), ul_encoded) if encoded is None else encoded
+	errors = np.empty(len(plain), np.uint8) if errors is None else errors
+	_librenard.uplink_encode(plain, common, encoded, errors, threads)
+	return encoded, errors
+
+def uplink_decode(encoded, common = None, check_mac = False, plain = None, errors = None, threads = 1):
+	"""
+	Decode uplinks, returns (plain, common, errors): arrays of dtype ul_plain, commoninfo and uint8 (sfx_uld_err).
+	If check_mac is set, `common` must contain the NAK of every frame's device. Device ID and sequence number
+	are written to `common`, which is allocated if not given.
+	"""
+	_check(encoded, ul_encoded, "ul_encoded")
+	common = np.zeros(len(encoded), commoninfo) if common is None else common
+	plain = np.empty(len(encoded), ul_plain) if plain is None else plain
+	errors = np.empty(len(encoded), np.uint8) if errors is None else errors
+	_librenard.uplink_decode(encoded, plain, common, errors, check_mac, threads)
+	return plain, common, errors
+
+def downlink_encode(plain, common, encoded = None, threads = 1):
+	"""
+	Encode downlinks, returns array of dtype dl_encoded.
+	"""
+	_check(plain, dl_plain, "dl_plain")
+	_check(common, commoninfo, "commoninfo")
+	encoded = np.empty(len(plain), dl_encoded) if encoded is None else encoded
+	_librenard.downlink_encode(plain, common, encoded, threads)
+	return encoded
+
+def downlink_decode(encoded, common, plain = None, threads = 1):
+	"""
+	Decode downlinks, returns array of dtype dl_plain.
+	"""
+	_check(encoded, dl_encoded, "dl_encoded")
+	_check(common, commoninfo, "commoninfo")
+	plain = np.empty(len(encoded), dl_plain) if plain is None else plain
+	_librenard.downlink_decode(encoded, common, plain, threads)
+	return plain
@@ -0,0 +1,293 @@
+/*
+ * CPython extension with batch versions of librenard's frame encoding / decoding functions
+ *
+ * All functions operate on contiguous buffers (buffer protocol, e.g. NumPy arrays) that hold arrays of librenard's
+ * C structs (sfx_ul_plain, sfx_ul_encoded, sfx_dl_plain, sfx_dl_encoded, sfx_commoninfo). Outputs are written into
+ * caller-provided writable buffers, so that no data is copied between Python and C. The GIL is released while
+ * frames are processed and batches can be split across multiple threads. NumPy dtypes that match the struct layouts
+ * are defined in __init__.py.
+ */
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "uplink.h"
+#include "downlink.h"
+#include "common.h"
+
+#define MAX_THREADS 256
+
+typedef enum {
+	JOB_UPLINK_ENCODE,
+	JOB_UPLINK_DECODE,
+	JOB_DOWNLINK_ENCODE,
+	JOB_DOWNLINK_DECODE
+} job_type;
+
+/**
+ * @brief batch job: process items [first, last) of the given arrays
+ */
+typedef struct {
+	job_type type;
+	Py_ssize_t first;
+	Py_ssize_t last;
+	bool check_mac;
+	void *plain;
+	void *encoded;
+	sfx_commoninfo *common;
+	uint8_t *errors;
+} job;
+
+static void *job_run(void *arg)
+{
+	job *j = arg;
+
+	for (Py_ssize_t i = j->first; i < j->last; ++i) {
+		switch (j->type) {
+		case JOB_UPLINK_ENCODE: {
+			sfx_ule_err err = sfx_uplink_encode(((sfx_ul_plain *)j->plain)[i], j->common[i], &((sfx_ul_encoded *)j->encoded)[i]);
+			if (j->errors)
+				j->errors[i] = err;
+			break;
+		}
+		case JOB_UPLINK_DECODE: {
+			sfx_uld_err err = sfx_uplink_decode(((sfx_ul_encoded *)j->encoded)[i], &((sfx_ul_plain *)j->plain)[i], &j->common[i], j->check_mac);
+			if (j->errors)
+				j->errors[i] = err;
+			break;
+		}
+		case JOB_DOWNLINK_ENCODE:
+			sfx_downlink_encode(((sfx_dl_plain *)j->plain)[i], j->common[i], &((sfx_dl_encoded *)j->encoded)[i]);
+			break;
+		case JOB_DOWNLINK_DECODE:
+			sfx_downlink_decode(((sfx_dl_encoded *)j->encoded)[i], j->common[i], &((sfx_dl_plain *)j->plain)[i]);
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief run batch job with GIL released, split into `threads` equally sized jobs
+ * @return false if a thread could not be created
+ */
+static bool batch_run(job *j, Py_ssize_t count, int threads)
+{
+	pthread_t handles[MAX_THREADS];
+	job jobs[MAX_THREADS];
+	bool success = true;
+	int started = 0;
+
+	if (threads > count)
+		threads = count > 0 ? count : 1;
+
+	Py_BEGIN_ALLOW_THREADS
+	for (int t = 0; t < threads; ++t) {
+		jobs[t] = *j;
+		jobs[t].first = count * t / threads;
+		jobs[t].last = count * (t + 1) / threads;
+
+		// last chunk is processed by calling thread
+		if (t == threads - 1) {
+			job_run(&jobs[t]);
+		} else if (pthread_create(&handles[t], NULL, job_run, &jobs[t]) == 0) {
+			started++;
+		} else {
+			job_run(&jobs[t]);
+			success = false;
+		}
+	}
+
+	for (int t = 0; t < started; ++t)
+		pthread_join(handles[t], NULL);
+	Py_END_ALLOW_THREADS
+
+	return success;
+}
+
+/**
+ * @brief get contiguous buffer that holds an array of structs of the given size
+ * @param obj object that supports the buffer protocol
+ * @param view output, buffer view, release with PyBuffer_Release
+ * @param itemsize size of a single struct in bytes
+ * @param writable whether buffer must be writable (output)
+ * @param name argument name for error messages
+ * @return number of structs in buffer, -1 if buffer is not suitable (exception is set)
+ */
+static Py_ssize_t get_array(PyObject *obj, Py_buffer *view, size_t itemsize, bool writable, const char *name)
+{
+	if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | (writable ? PyBUF_WRITABLE : 0)) != 0)
+		return -1;
+
+	if (view->len % itemsize != 0) {
+		PyErr_Format(PyExc_ValueError, "%s: buffer size %zd is not a multiple of item size %zu", name, view->len, itemsize);
+		PyBuffer_Release(view);
+		return -1;
+	}
+
+	return view->len / itemsize;
+}
+
+static int clamp_threads(int threads)
+{
+	if (threads < 1)
+		return 1;
+
+	return threads > MAX_THREADS ? MAX_THREADS : threads;
+}
+
+/**
+ * @brief common implementation of all batch functions
+ * @param type batch job type
+ * @param plain_obj plain frame contents, input for encoding / output for decoding
+ * @param common_obj common information, per frame
+ * @param encoded_obj encoded frames, output for encoding / input for decoding
+ * @param errors_obj error codes, output, may be Py_None
+ * @param check_mac uplink decoding only: whether to check MACs
+ * @param threads number of threads
+ */
+static PyObject *batch(job_type type, PyObject *plain_obj, PyObject *common_obj, PyObject *encoded_obj, PyObject *errors_obj, bool check_mac, int threads)
+{
+	bool uplink = type == JOB_UPLINK_ENCODE || type == JOB_UPLINK_DECODE;
+	bool encode = type == JOB_UPLINK_ENCODE || type == JOB_DOWNLINK_ENCODE;
+	Py_buffer plain, common, encoded, errors;
+	PyObject *result = NULL;
+	job j;
+
+	Py_ssize_t count = get_array(plain_obj, &plain, uplink ? sizeof(sfx_ul_plain) : sizeof(sfx_dl_plain), !encode, "plain");
+	if (count < 0)
+		return NULL;
+
+	// uplink decoding writes device ID and sequence number to common
+	Py_ssize_t common_count = get_array(common_obj, &common, sizeof(sfx_commoninfo), type == JOB_UPLINK_DECODE, "common");
+	if (common_count < 0)
+		goto release_plain;
+
+	Py_ssize_t encoded_count = get_array(encoded_obj, &encoded, uplink ? sizeof(sfx_ul_encoded) : sizeof(sfx_dl_encoded), encode, "encoded");
+	if (encoded_count < 0)
+		goto release_common;
+
+	Py_ssize_t errors_count = count;
+	if (errors_obj != Py_None && (errors_count = get_array(errors_obj, &errors, 1, true, "errors")) < 0)
+		goto release_encoded;
+
+	if (common_count != count || encoded_count != count || errors_count != count) {
+		PyErr_Format(PyExc_ValueError, "array lengths differ: plain %zd, common %zd, encoded %zd, errors %zd", count, common_count, encoded_count, errors_count);
+		goto release_errors;
+	}
+
+	j.type = type;
+	j.check_mac = check_mac;
+	j.plain = plain.buf;
+	j.encoded = encoded.buf;
+	j.common = common.buf;
+	j.errors = errors_obj != Py_None ? errors.buf : NULL;
+
+	if (!batch_run(&j, count, clamp_threads(threads)))
+		PyErr_WarnEx(PyExc_RuntimeWarning, "could not create all threads, batch was processed with fewer threads", 1);
+
+	result = PyLong_FromSsize_t(count);
+
+release_errors:
+	if (errors_obj != Py_None)
+		PyBuffer_Release(&errors);
+release_encoded:
+	PyBuffer_Release(&encoded);
+release_common:
+	PyBuffer_Release(&common);
+release_plain:
+	PyBuffer_Release(&plain);
+
+	return result;
+}
+
+static PyObject *uplink_encode(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = { "plain", "common", "encoded", "errors", "threads", NULL };
+	PyObject *plain, *common, *encoded, *errors = Py_None;
+	int threads = 1;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO|Oi", keywords, &plain, &common, &encoded, &errors, &threads))
+		return NULL;
+
+	return batch(JOB_UPLINK_ENCODE, plain, common, encoded, errors, false, threads);
+}
+
+static PyObject *uplink_decode(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = { "encoded", "plain", "common", "errors", "check_mac", "threads", NULL };
+	PyObject *plain, *common, *encoded, *errors = Py_None;
+	int check_mac = 0;
+	int threads = 1;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO|Opi", keywords, &encoded, &plain, &common, &errors, &check_mac, &threads))
+		return NULL;
+
+	return batch(JOB_UPLINK_DECODE, plain, common, encoded, errors, check_mac, threads);
+}
+
+static PyObject *downlink_encode(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = { "plain", "common", "encoded", "threads", NULL };
+	PyObject *plain, *common, *encoded;
+	int threads = 1;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO|i", keywords, &plain, &common, &encoded, &threads))
+		return NULL;
+
+	return batch(JOB_DOWNLINK_ENCODE, plain, common, encoded, Py_None, false, threads);
+}
+
+static PyObject *downlink_decode(PyObject *self, PyObject *args, PyObject *kwargs)
+{
+	static char *keywords[] = { "encoded", "common", "plain", "threads", NULL };
+	PyObject *plain, *common, *encoded;
+	int threads = 1;
+
+	if (!PyArg_ParseTupleAndKeywords(args, kwargs, "OOO|i", keywords, &encoded, &common, &plain, &threads))
+		return NULL;
+
+	return batch(JOB_DOWNLINK_DECODE, plain, common, encoded, Py_None, false, threads);
+}
+
+static PyMethodDef methods[] = {
+	{ "uplink_encode", (PyCFunction)(void (*)(void))uplink_encode, METH_VARARGS | METH_KEYWORDS,
+		"uplink_encode(plain, common, encoded, errors=None, threads=1)\n"
+		"Encode arrays of sfx_ul_plain / sfx_commoninfo into writable array of sfx_ul_encoded, "
+		"optionally store sfx_ule_err codes in writable uint8 array. Returns number of frames." },
+	{ "uplink_decode", (PyCFunction)(void (*)(void))uplink_decode, METH_VARARGS | METH_KEYWORDS,
+		"uplink_decode(encoded, plain, common, errors=None, check_mac=False, threads=1)\n"
+		"Decode array of sfx_ul_encoded into writable arrays of sfx_ul_plain / sfx_commoninfo (NAK is input if check_mac is set), "
+		"optionally store sfx_uld_err codes in writable uint8 array. Returns number of frames." },
+	{ "downlink_encode", (PyCFunction)(void (*)(void))downlink_encode, METH_VARARGS | METH_KEYWORDS,
+		"downlink_encode(plain, common, encoded, threads=1)\n"
+		"Encode arrays of sfx_dl_plain / sfx_commoninfo into writable array of sfx_dl_encoded. Returns number of frames." },
+	{ "downlink_decode", (PyCFunction)(void (*)(void))downlink_decode, METH_VARARGS | METH_KEYWORDS,
+		"downlink_decode(encoded, common, plain, threads=1)\n"
+		"Decode arrays of sfx_dl_encoded / sfx_commoninfo into writable array of sfx_dl_plain. Returns number of frames." },
+	{ NULL, NULL, 0, NULL }
+};
+
+static struct PyModuleDef module = {
+	PyModuleDef_HEAD_INIT, "_librenard", "Batch Sigfox frame encoding / decoding with librenard", -1, methods
+};
+
+PyMODINIT_FUNC PyInit__librenard(void)
+{
+	PyObject *m = PyModule_Create(&module);
+	if (!m)
+		return NULL;
+
+	// struct sizes, used to check that NumPy dtypes match the C struct layout
+	PyModule_AddIntConstant(m, "UL_PLAIN_SIZE", sizeof(sfx_ul_plain));
+	PyModule_AddIntConstant(m, "UL_ENCODED_SIZE", sizeof(sfx_ul_encoded));
+	PyModule_AddIntConstant(m, "DL_PLAIN_SIZE", sizeof(sfx_dl_plain));
+	PyModule_AddIntConstant(m, "DL_ENCODED_SIZE", sizeof(sfx_dl_encoded));
+	PyModule_AddIntConstant(m, "COMMONINFO_SIZE", sizeof(sfx_commoninfo));
+
+	return m;
+}
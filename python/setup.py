@@ -0,0 +1,29 @@
+"""
+Build / install the librenard Python bindings:
+	pip install ./python
+The library sources from ../src are compiled into the extension module.
+"""
+import glob
+import os
+
+from setuptools import setup, Extension
+
+here = os.path.dirname(os.path.abspath(__file__))
+src = os.path.relpath(os.path.join(here, "..", "src"), here)
+
+extension = Extension(
+	"librenard._librenard",
+	sources = ["librenard/_librenard.c"] + sorted(glob.glob(os.path.join(src, "*.c"))),
+	include_dirs = [src],
+	extra_compile_args = ["-std=c99", "-O2"],
+	extra_link_args = ["-pthread"]
+)
+
+setup(
+	name = "librenard",
+	version = "0.1.0",
+	description = "Batch Sigfox frame encoding / decoding with librenard",
+	packages = ["librenard"],
+	ext_modules = [extension],
+	install_requires = ["numpy"]
+)
@@ -0,0 +1,306 @@
+#define _GNU_SOURCE
+
+#include <string.h>
+
+#include "workspace.h"
+#include "async.h"
+
+#if defined(__linux__) && defined(__GNUC__)
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+
+/*
+ * Asynchronous interface
+ * Every accepted request is guaranteed a slot in the completion ring: submission only accepts as many requests as
+ * there are free completion slots (`inflight` counts submitted requests until their completions are reaped), so that
+ * workers never have to wait for the caller. Workers sleep on a semaphore that is posted once per submission; a
+ * worker that takes a full batch posts it again, so that further workers join in while the backlog lasts.
+ */
+
+/**
+ * @brief NAK cache of a single batch, so that every device is only looked up once per batch
+ */
+typedef struct {
+	uint32_t devid[SFX_ASYNC_BATCH];
+	uint8_t key[SFX_ASYNC_BATCH][16];
+	bool found[SFX_ASYNC_BATCH];
+	uint8_t count;
+} sfx_async_keycache;
+
+static bool sfx_async_lookup(sfx_async *ctx, sfx_async_keycache *cache, uint32_t devid, uint8_t *key)
+{
+	uint8_t i;
+
+	for (i = 0; i < cache->count; ++i) {
+		if (cache->devid[i] == devid) {
+			memcpy(key, cache->key[i], 16);
+			return cache->found[i];
+		}
+	}
+
+	bool found = ctx->lookup && ctx->lookup(ctx->context, devid, key);
+
+	if (cache->count < SFX_ASYNC_BATCH) {
+		cache->devid[cache->count] = devid;
+		cache->found[cache->count] = found;
+		memcpy(cache->key[cache->count], key, 16);
+		cache->count++;
+	}
+
+	return found;
+}
+
+/**
+ * @brief uplink decoding requests of a batch, decoded together (see ::sfx_uplink_decode_batch) before MACs are checked
+ */
+typedef struct {
+	const sfx_ul_encoded *encoded[SFX_ASYNC_BATCH];
+	sfx_ul_plain plain[SFX_ASYNC_BATCH];
+	sfx_commoninfo common[SFX_ASYNC_BATCH];
+	sfx_ul_packet packets[SFX_ASYNC_BATCH];
+	sfx_uld_err status[SFX_ASYNC_BATCH];
+
+	/// index into the arrays above for every request of the batch
+	uint8_t slot[SFX_ASYNC_BATCH];
+	uint8_t count;
+
+	/// scratch memory of MAC checks
+	sfx_workspace workspace;
+} sfx_async_uplinks;
+
+static void sfx_async_decode_uplinks(sfx_async_uplinks *uplinks, const sfx_async_request *requests, uint32_t count)
+{
+	uint32_t i;
+
+	uplinks->count = 0;
+	for (i = 0; i < count; ++i) {
+		if (requests[i].opcode == SFX_ASYNC_UPLINK_DECODE) {
+			uplinks->slot[i] = uplinks->count;
+			uplinks->encoded[uplinks->count++] = &requests[i].in.ul_encoded;
+		}
+	}
+
+	sfx_uplink_decode_batch(uplinks->encoded, uplinks->count, uplinks->plain, uplinks->common, uplinks->packets, uplinks->status);
+}
+
+static void sfx_async_process(sfx_async *ctx, const sfx_async_request *request, sfx_async_completion *completion, sfx_async_keycache *cache, sfx_async_uplinks *uplinks, uint8_t index)
+{
+	sfx_commoninfo common = request->common;
+
+	memset(completion, 0, sizeof(*completion));
+	completion->user_data = request->user_data;
+	completion->opcode = request->opcode;
+
+	switch (request->opcode) {
+	case SFX_ASYNC_UPLINK_DECODE: {
+		// already decoded without MAC check, only the MAC is left once the NAK is known
+		uint8_t slot = uplinks->slot[index];
+		completion->status = uplinks->status[slot];
+		completion->out.ul_plain = uplinks->plain[slot];
+		common.devid = uplinks->common[slot].devid;
+		common.seqnum = uplinks->common[slot].seqnum;
+
+		if (request->flags & SFX_ASYNC_FLAG_LOOKUP_KEY)
+			completion->mac_checked = completion->status == SFX_ULD_ERR_NONE && sfx_async_lookup(ctx, cache, common.devid, common.key);
+		else
+			completion->mac_checked = (request->flags & SFX_ASYNC_FLAG_CHECK_MAC) != 0;
+
+		if (completion->mac_checked && completion->status == SFX_ULD_ERR_NONE)
+			completion->status = sfx_uplink_check_mac_ws(&uplinks->packets[slot], &completion->out.ul_plain, common.key, &uplinks->workspace);
+#ifdef RENARD_CONSTANT_TIME
+		// as in ::sfx_uplink_decode, the MAC is also computed if the CRC is invalid
+		else if (completion->mac_checked && completion->status == SFX_ULD_ERR_CRC_INVALID)
+			sfx_uplink_check_mac_ws(&uplinks->packets[slot], &completion->out.ul_plain, common.key, &uplinks->workspace);
+#endif
+		break;
+	}
+	case SFX_ASYNC_UPLINK_ENCODE:
+		completion->status = sfx_uplink_encode(request->in.ul_plain, common, &completion->out.ul_encoded);
+		break;
+	case SFX_ASYNC_DOWNLINK_DECODE:
+		// without a known NAK, sfx_dl_plain::mac_ok is meaningless
+		completion->mac_checked = !(request->flags & SFX_ASYNC_FLAG_LOOKUP_KEY) || sfx_async_lookup(ctx, cache, common.devid, common.key);
+		sfx_downlink_decode(request->in.dl_encoded, common, &completion->out.dl_plain);
+		break;
+	case SFX_ASYNC_DOWNLINK_ENCODE:
+		sfx_downlink_encode(request->in.dl_plain, common, &completion->out.dl_encoded);
+		break;
+	}
+
+	completion->devid = common.devid;
+	completion->seqnum = common.seqnum;
+}
+
+static void *sfx_async_worker(void *arg)
+{
+	sfx_async *ctx = arg;
+	sfx_async_request requests[SFX_ASYNC_BATCH];
+	sfx_async_completion completions[SFX_ASYNC_BATCH];
+	sfx_async_uplinks uplinks;
+	sfx_async_keycache cache;
+	uint32_t count, i;
+
+	while (true) {
+		while (sem_wait(&ctx->doorbell) != 0 && errno == EINTR);
+
+		if (__atomic_load_n(&ctx->stop, __ATOMIC_ACQUIRE))
+			break;
+
+		while ((count = renard_mpmc_pop(&ctx->sq, requests, SFX_ASYNC_BATCH)) > 0) {
+			// more requests may be waiting, wake up another worker
+			if (count == SFX_ASYNC_BATCH)
+				sem_post(&ctx->doorbell);
+
+			sfx_async_decode_uplinks(&uplinks, requests, count);
+
+			cache.count = 0;
+			for (i = 0; i < count; ++i)
+				sfx_async_process(ctx, &requests[i], &completions[i], &cache, &uplinks, i);
+
+			// completion slots are reserved on submission, a concurrent reaper may only delay the push
+			for (i = 0; i < count; i += renard_mpmc_push(&ctx->cq, &completions[i], count - i));
+
+			// can only fail if the eventfd counter overflows, completions can be polled anyway
+			uint64_t one = 1;
+			ssize_t written = write(ctx->eventfd, &one, sizeof(one));
+			(void)written;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief initialize asynchronous processing context and start worker threads
+ * @param ctx context to initialize
+ * @param sq_buffer submission ring memory, ::SFX_ASYNC_SQ_BUFSIZE(sq_capacity) bytes
+ * @param sq_capacity number of submission ring slots, must be a power of two
+ * @param cq_buffer completion ring memory, ::SFX_ASYNC_CQ_BUFSIZE(cq_capacity) bytes
+ * @param cq_capacity number of completion ring slots, must be a power of two; at most this many requests can be in flight
+ * @param workers number of worker threads, between 1 and ::SFX_ASYNC_MAX_WORKERS
+ * @param lookup NAK lookup for decoding requests with ::SFX_ASYNC_FLAG_LOOKUP_KEY, may be NULL; called from worker threads
+ * @param context context pointer passed to `lookup`
+ * @return false if a capacity or the number of workers is invalid or if eventfd / threads could not be created
+ */
+bool sfx_async_init(sfx_async *ctx, void *sq_buffer, uint32_t sq_capacity, void *cq_buffer, uint32_t cq_capacity, uint8_t workers, sfx_ul_keylookup lookup, void *context)
+{
+	memset(ctx, 0, sizeof(*ctx));
+
+	if (workers < 1 || workers > SFX_ASYNC_MAX_WORKERS)
+		return false;
+
+	if (!renard_mpmc_init(&ctx->sq, sq_buffer, sq_capacity, sizeof(sfx_async_request)))
+		return false;
+
+	if (!renard_mpmc_init(&ctx->cq, cq_buffer, cq_capacity, sizeof(sfx_async_completion)))
+		return false;
+
+	ctx->cq_capacity = cq_capacity;
+	ctx->lookup = lookup;
+	ctx->context = context;
+
+	ctx->eventfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (ctx->eventfd < 0)
+		return false;
+
+	if (sem_init(&ctx->doorbell, 0, 0) != 0) {
+		close(ctx->eventfd);
+		return false;
+	}
+
+	for (ctx->workers = 0; ctx->workers < workers; ++ctx->workers) {
+		if (pthread_create(&ctx->threads[ctx->workers], NULL, sfx_async_worker, ctx) != 0) {
+			sfx_async_destroy(ctx);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/**
+ * @brief stop worker threads (after their current batch) and release resources; requests that have not been
+ * processed yet are dropped
+ * @param ctx asynchronous processing context
+ */
+void sfx_async_destroy(sfx_async *ctx)
+{
+	uint8_t i;
+
+	__atomic_store_n(&ctx->stop, true, __ATOMIC_RELEASE);
+
+	for (i = 0; i < ctx->workers; ++i)
+		sem_post(&ctx->doorbell);
+
+	for (i = 0; i < ctx->workers; ++i)
+		pthread_join(ctx->threads[i], NULL);
+
+	ctx->workers = 0;
+	sem_destroy(&ctx->doorbell);
+	close(ctx->eventfd);
+}
+
+/**
+ * @brief submit requests, thread-safe
+ * @param ctx asynchronous processing context
+ * @param requests array of requests
+ * @param count number of requests
+ * @return number of accepted requests, less than `count` if the submission ring is full or if as many requests are
+ * in flight as the completion ring can hold (reap completions and submit the remaining requests again)
+ */
+uint32_t sfx_async_submit(sfx_async *ctx, const sfx_async_request *requests, uint32_t count)
+{
+	uint32_t inflight = __atomic_load_n(&ctx->inflight, __ATOMIC_RELAXED);
+	uint32_t accepted;
+
+	// reserve completion slots
+	do {
+		accepted = ctx->cq_capacity - inflight;
+		if (accepted > count)
+			accepted = count;
+		if (accepted == 0)
+			return 0;
+	} while (!__atomic_compare_exchange_n(&ctx->inflight, &inflight, inflight + accepted, true, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+	uint32_t pushed = renard_mpmc_push(&ctx->sq, requests, accepted);
+
+	if (pushed < accepted)
+		__atomic_sub_fetch(&ctx->inflight, accepted - pushed, __ATOMIC_ACQ_REL);
+
+	if (pushed > 0)
+		sem_post(&ctx->doorbell);
+
+	return pushed;
+}
+
+/**
+ * @brief poll completion ring, thread-safe; completions are not in submission order
+ * @param ctx asynchronous processing context
+ * @param completions output, space for `count` completions
+ * @param count maximum number of completions
+ * @return number of completions
+ */
+uint32_t sfx_async_reap(sfx_async *ctx, sfx_async_completion *completions, uint32_t count)
+{
+	uint32_t reaped = renard_mpmc_pop(&ctx->cq, completions, count);
+
+	if (reaped > 0)
+		__atomic_sub_fetch(&ctx->inflight, reaped, __ATOMIC_ACQ_REL);
+
+	return reaped;
+}
+
+/**
+ * @brief get eventfd that becomes readable when completions are available, e.g. for epoll; read it (8 bytes) to
+ * reset it before reaping. The eventfd is non-blocking.
+ * @param ctx asynchronous processing context
+ * @return file descriptor
+ */
+int sfx_async_eventfd(const sfx_async *ctx)
+{
+	return ctx->eventfd;
+}
+
+#endif
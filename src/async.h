@@ -0,0 +1,155 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "uplink.h"
+#include "downlink.h"
+#include "uplink_sched.h"
+#include "ring.h"
+#include "common.h"
+
+#ifndef _ASYNC_H
+#define _ASYNC_H
+
+/*
+ * Asynchronous interface (Linux only): requests are pushed into a submission ring, a pool of worker threads owned by
+ * the context processes them in batches and pushes the results into a completion ring. Completions can be polled
+ * or waited for using an eventfd, e.g. from an event loop. Ring memory is provided by the caller.
+ */
+#if defined(__linux__) && defined(__GNUC__)
+
+#include <pthread.h>
+#include <semaphore.h>
+
+/// maximum number of worker threads of ::sfx_async
+#define SFX_ASYNC_MAX_WORKERS 64
+
+/// maximum number of requests a worker takes from the submission ring at once
+#define SFX_ASYNC_BATCH 32
+
+/// request flag: check MAC using the NAK in sfx_async_request::common
+#define SFX_ASYNC_FLAG_CHECK_MAC 0x01
+
+/// request flag: use the NAK from the lookup function of the context (see ::sfx_async_init) instead of sfx_async_request::common, uplinks: MAC is checked if the NAK is known
+#define SFX_ASYNC_FLAG_LOOKUP_KEY 0x02
+
+/**
+ * @brief operation of asynchronous request
+ */
+typedef enum {
+	/// ::sfx_uplink_decode, input: `ul_encoded`, output: `ul_plain`, device ID and sequence number
+	SFX_ASYNC_UPLINK_DECODE = 0,
+
+	/// ::sfx_uplink_encode, input: `ul_plain`, output: `ul_encoded`
+	SFX_ASYNC_UPLINK_ENCODE = 1,
+
+	/// ::sfx_downlink_decode, input: `dl_encoded`, output: `dl_plain`
+	SFX_ASYNC_DOWNLINK_DECODE = 2,
+
+	/// ::sfx_downlink_encode, input: `dl_plain`, output: `dl_encoded`
+	SFX_ASYNC_DOWNLINK_ENCODE = 3
+} sfx_async_opcode;
+
+/**
+ * @brief frame contents, input of a request / output of a completion depending on the operation
+ */
+typedef union _u_sfx_async_data {
+	sfx_ul_plain ul_plain;
+	sfx_ul_encoded ul_encoded;
+	sfx_dl_plain dl_plain;
+	sfx_dl_encoded dl_encoded;
+} sfx_async_data;
+
+/**
+ * @brief entry of submission ring
+ */
+typedef struct _s_sfx_async_request {
+	/// caller-defined value, copied to completion
+	uint64_t user_data;
+
+	/// operation, see ::sfx_async_opcode
+	uint8_t opcode;
+
+	/// combination of SFX_ASYNC_FLAG_* values (decoding only, ::SFX_ASYNC_FLAG_CHECK_MAC for uplinks only)
+	uint8_t flags;
+
+	/// device ID, sequence number and NAK (encoding, downlink decoding), NAK (uplink decoding with MAC check)
+	sfx_commoninfo common;
+
+	/// input frame contents
+	sfx_async_data in;
+} sfx_async_request;
+
+/**
+ * @brief entry of completion ring
+ */
+typedef struct _s_sfx_async_completion {
+	/// value of sfx_async_request::user_data
+	uint64_t user_data;
+
+	/// operation, see ::sfx_async_opcode
+	uint8_t opcode;
+
+	/// uplink decoding: ::sfx_uld_err, uplink encoding: ::sfx_ule_err, downlink: 0
+	uint8_t status;
+
+	/// decoding: indicates whether MAC was checked, false if the NAK of ::SFX_ASYNC_FLAG_LOOKUP_KEY is not known
+	/// (downlinks: sfx_dl_plain::mac_ok is meaningless then)
+	bool mac_checked;
+
+	/// uplink decoding: decoded device ID and sequence number, otherwise copied from request (without NAK)
+	uint32_t devid;
+	uint16_t seqnum;
+
+	/// output frame contents
+	sfx_async_data out;
+} sfx_async_completion;
+
+/// size of submission ring buffer for ::sfx_async_init, in bytes
+#define SFX_ASYNC_SQ_BUFSIZE(capacity) RENARD_MPMC_BUFSIZE(capacity, sizeof(sfx_async_request))
+
+/// size of completion ring buffer for ::sfx_async_init, in bytes
+#define SFX_ASYNC_CQ_BUFSIZE(capacity) RENARD_MPMC_BUFSIZE(capacity, sizeof(sfx_async_completion))
+
+/**
+ * @brief asynchronous processing context, see ::sfx_async_init
+ */
+typedef struct _s_sfx_async {
+	/// submission ring
+	renard_mpmc_ring sq;
+
+	/// completion ring
+	renard_mpmc_ring cq;
+
+	/// capacity of completion ring, at most this many requests are in flight
+	uint32_t cq_capacity;
+
+	/// number of submitted requests whose completions have not yet been reaped
+	uint32_t inflight;
+
+	/// eventfd that is signalled when completions are available
+	int eventfd;
+
+	/// wakes up sleeping workers when requests are submitted
+	sem_t doorbell;
+
+	/// set on shutdown
+	bool stop;
+
+	/// NAK lookup for ::SFX_ASYNC_FLAG_LOOKUP_KEY, may be NULL
+	sfx_ul_keylookup lookup;
+	void *context;
+
+	/// worker threads
+	uint8_t workers;
+	pthread_t threads[SFX_ASYNC_MAX_WORKERS];
+} sfx_async;
+
+bool sfx_async_init(sfx_async *ctx, void *sq_buffer, uint32_t sq_capacity, void *cq_buffer, uint32_t cq_capacity, uint8_t workers, sfx_ul_keylookup lookup, void *context);
+void sfx_async_destroy(sfx_async *ctx);
+uint32_t sfx_async_submit(sfx_async *ctx, const sfx_async_request *requests, uint32_t count);
+uint32_t sfx_async_reap(sfx_async *ctx, sfx_async_completion *completions, uint32_t count);
+int sfx_async_eventfd(const sfx_async *ctx);
+
+#endif
+
+#endif
@@ -0,0 +1,104 @@
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "ti_aes_128.h"
+#include "sigfox_crc.h"
+#include "renard_config.h"
+#include "thumb_kernels.h"
+#include "backend.h"
+
+/*
+ * Software implementations of all primitives, used unless another backend is selected
+ */
+#if !defined(RENARD_THUMB_KERNELS) || defined(RENARD_CONSTANT_TIME)
+static void renard_aes_128_encrypt_software(uint8_t *block, const uint8_t *key)
+{
+	renard_aes_enc_dec(block, key, 0);
+}
+#endif
+
+/**
+ * @brief software implementation of AES, CRC-16 and CRC-8
+ */
+const renard_backend renard_backend_software = {
+#if defined(RENARD_THUMB_KERNELS) && !defined(RENARD_CONSTANT_TIME)
+	.aes_128_encrypt = renard_aes_128_encrypt_thumb,
+#else
+	.aes_128_encrypt = renard_aes_128_encrypt_software,
+#endif
+	.aes_128_cbc_encrypt = NULL,
+#ifdef RENARD_THUMB_KERNELS
+	.crc16 = renard_crc16_thumb,
+#else
+	.crc16 = renard_crc16_software,
+#endif
+	.crc8 = renard_crc8_software
+};
+
+#ifndef RENARD_NO_COUNTING_BACKEND
+
+/*
+ * Stand-in for hardware backends: Software backend that counts calls, so that backend
+ * dispatching can be verified on any host
+ */
+renard_backend_counters renard_backend_counting_stats;
+
+static void renard_aes_128_encrypt_counting(uint8_t *block, const uint8_t *key)
+{
+	renard_backend_counting_stats.aes_blocks++;
+	renard_backend_software.aes_128_encrypt(block, key);
+}
+
+static uint16_t renard_crc16_counting(uint8_t const data[], uint8_t length)
+{
+	renard_backend_counting_stats.crc16++;
+	return renard_backend_software.crc16(data, length);
+}
+
+static uint8_t renard_crc8_counting(uint8_t const data[], uint8_t length)
+{
+	renard_backend_counting_stats.crc8++;
+	return renard_backend_software.crc8(data, length);
+}
+
+/**
+ * @brief software implementation (same primitives as ::renard_backend_software) that counts calls in ::renard_backend_counting_stats
+ */
+const renard_backend renard_backend_counting = {
+	.aes_128_encrypt = renard_aes_128_encrypt_counting,
+	.aes_128_cbc_encrypt = NULL,
+	.crc16 = renard_crc16_counting,
+	.crc8 = renard_crc8_counting
+};
+
+#endif
+
+/*
+ * Backend selection at link time: Compile with -DRENARD_BACKEND=<name of renard_backend variable>
+ * to use a backend provided by the application without calling ::renard_backend_set.
+ */
+#ifdef RENARD_BACKEND
+extern const renard_backend RENARD_BACKEND;
+static const renard_backend *current_backend = &RENARD_BACKEND;
+#else
+static const renard_backend *current_backend = &renard_backend_software;
+#endif
+
+/**
+ * @brief select implementation of cryptographic and CRC primitives, call before any encoding / decoding
+ * @param backend backend to use, must remain valid while it is selected; NULL selects ::renard_backend_software
+ * @attention Not thread-safe, select backend during initialization only. `aes_128_encrypt`, `crc16` and `crc8` must all be provided.
+ */
+void renard_backend_set(const renard_backend *backend)
+{
+	current_backend = backend ? backend : &renard_backend_software;
+}
+
+/**
+ * @brief get currently selected backend
+ * @return currently selected backend
+ */
+const renard_backend *renard_backend_get(void)
+{
+	return current_backend;
+}
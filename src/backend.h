@@ -0,0 +1,48 @@
+#include <inttypes.h>
+
+#include "renard_config.h"
+
+#ifndef _BACKEND_H
+#define _BACKEND_H
+
+/**
+ * @brief implementations of cryptographic and CRC primitives used by librenard, e.g. drivers for hardware AES / CRC peripherals
+ */
+typedef struct _s_renard_backend {
+	/// encrypt a single 16-byte block in place with AES-128 using the given 16-byte key
+	void (*aes_128_encrypt)(uint8_t *block, const uint8_t *key);
+
+	/// optional: AES-128 CBC encryption with zero IV of `data_len` bytes (multiple of 16), e.g. for peripherals with hardware CBC chaining; if NULL, CBC chaining is done in software using `aes_128_encrypt`
+	void (*aes_128_cbc_encrypt)(uint8_t *encrypted_data, const uint8_t *data_to_encrypt, uint8_t data_len, const uint8_t *key);
+
+	/// CRC-16-CCITT (polynomial 0x1021, initial value 0, no reflection) of `length` bytes, 0 for empty input
+	uint16_t (*crc16)(uint8_t const data[], uint8_t length);
+
+	/// CRC-8 (polynomial 0x2f, initial value 0, no reflection) of `length` bytes, 0 for empty input
+	uint8_t (*crc8)(uint8_t const data[], uint8_t length);
+} renard_backend;
+
+/**
+ * @brief number of calls to each primitive of ::renard_backend_counting
+ */
+typedef struct _s_renard_backend_counters {
+	/// number of encrypted AES blocks
+	uint32_t aes_blocks;
+
+	/// number of CRC-16 calculations
+	uint32_t crc16;
+
+	/// number of CRC-8 calculations
+	uint32_t crc8;
+} renard_backend_counters;
+
+extern const renard_backend renard_backend_software;
+#ifndef RENARD_NO_COUNTING_BACKEND
+extern const renard_backend renard_backend_counting;
+extern renard_backend_counters renard_backend_counting_stats;
+#endif
+
+void renard_backend_set(const renard_backend *backend);
+const renard_backend *renard_backend_get(void);
+
+#endif
@@ -0,0 +1,42 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "renard_config.h"
+
+#ifndef _CONSTANT_TIME_H
+#define _CONSTANT_TIME_H
+
+/*
+ * Branch-free helpers for code paths whose timing must not depend on (secret or attacker-controlled) data,
+ * see RENARD_CONSTANT_TIME in renard_config.h
+ */
+
+/**
+ * @brief compare two buffers in constant time (no early exit), e.g. received and computed MAC
+ * @param a first buffer
+ * @param b second buffer
+ * @param length number of bytes to compare
+ * @return true if buffers are equal
+ */
+static inline bool renard_ct_equal(const uint8_t *a, const uint8_t *b, uint8_t length)
+{
+	uint8_t diff = 0;
+	uint8_t i;
+
+	for (i = 0; i < length; ++i)
+		diff |= a[i] ^ b[i];
+
+	// 0 - 1 sets all bits only if diff is zero
+	return (((uint32_t)diff - 1) >> 31) & 1;
+}
+
+/**
+ * @brief all-ones mask if a < b, zero otherwise, without branching
+ */
+static inline uint32_t renard_ct_lt_mask(uint32_t a, uint32_t b)
+{
+	// a, b < 2^31: sign bit of a - b is set iff a < b
+	return 0 - ((a - b) >> 31);
+}
+
+#endif
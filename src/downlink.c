@@ -3,13 +3,14 @@
 #include "sigfox_mac.h"
 #include "sigfox_crc.h"
 #include "bch_15_11.h"
+#include "workspace.h"
 #include "downlink.h"
 #include "common.h"
 
 /**
  * @brief content of Sigfox's 13-byte (::SFX_DL_PREAMBLELEN) downlink preamble
  */
-uint8_t SFX_DL_PREAMBLE[] = {
+const uint8_t SFX_DL_PREAMBLE[] = {
 	0x2a, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
 	0xaa, 0xaa, 0xaa, 0xaa, 0xb2, 0x27
 };
@@ -38,12 +39,12 @@ uint32_t extractLowerBits(uint32_t value, uint8_t bitcount)
 	return ((1 << bitcount) - 1) & value;
 }
 
-void sfx_downlink_frame_scramble(uint8_t *payloadbuf, sfx_commoninfo common)
+void sfx_downlink_frame_scramble(uint8_t *payloadbuf, const sfx_commoninfo *common)
 {
 	/*
 	 * Initialize LFSR with seed value derived from device ID and uplink SN (for descrambling)
 	 */
-	uint16_t state = (common.seqnum * common.devid) & 0x1ff;
+	uint16_t state = (common->seqnum * common->devid) & 0x1ff;
 
 	if (state == 0)
 		state = 0x1ff;
@@ -74,20 +75,20 @@ void sfx_downlink_frame_scramble(uint8_t *payloadbuf, sfx_commoninfo common)
  * See section 3.3 of Bachelor's Thesis
  * "Reverse Engineering of the Sigfox Radio Protocol and Implementation of an Alternative Sigfox Network Stack"
  */
-uint16_t sfx_downlink_get_mac(uint8_t *message, sfx_commoninfo common) {
-	uint8_t encrypted_data[16];
-	uint8_t data_to_encrypt[16];
-	data_to_encrypt[0] = (common.devid & 0x000000ff) >> 0;
-	data_to_encrypt[1] = (common.devid & 0x0000ff00) >> 8;
-	data_to_encrypt[2] = (common.devid & 0x00ff0000) >> 16;
-	data_to_encrypt[3] = (common.devid & 0xff000000) >> 24;
-	data_to_encrypt[4] = (common.seqnum & 0x00ff) >> 0;
-	data_to_encrypt[5] = (common.seqnum & 0xff00) >> 8;
+uint16_t sfx_downlink_get_mac(const uint8_t *message, const sfx_commoninfo *common, sfx_mac_workspace *workspace) {
+	uint8_t *encrypted_data = workspace->output;
+	uint8_t *data_to_encrypt = workspace->input;
+	data_to_encrypt[0] = (common->devid & 0x000000ff) >> 0;
+	data_to_encrypt[1] = (common->devid & 0x0000ff00) >> 8;
+	data_to_encrypt[2] = (common->devid & 0x00ff0000) >> 16;
+	data_to_encrypt[3] = (common->devid & 0xff000000) >> 24;
+	data_to_encrypt[4] = (common->seqnum & 0x00ff) >> 0;
+	data_to_encrypt[5] = (common->seqnum & 0xff00) >> 8;
 	memcpy(&data_to_encrypt[6], message, SFX_DL_PAYLOADLEN);
-	data_to_encrypt[14] = (common.devid & 0x000000ff) >> 0;
-	data_to_encrypt[15] = (common.devid & 0x0000ff00) >> 8;
+	data_to_encrypt[14] = (common->devid & 0x000000ff) >> 0;
+	data_to_encrypt[15] = (common->devid & 0x0000ff00) >> 8;
 
-	renard_aes_128_cbc_encrypt(encrypted_data, data_to_encrypt, 16, common.key);
+	renard_aes_128_cbc_encrypt(encrypted_data, data_to_encrypt, 16, common->key);
 
 	return (encrypted_data[0] << 8) | encrypted_data[1];
 }
@@ -100,6 +101,19 @@ uint16_t sfx_downlink_get_mac(uint8_t *message, sfx_commoninfo common) {
  * @attention This function applies Forward Error Correction (FEC). If FEC has occurred during decoding, sfx_dl_plain::fec_corrected will be set to true in the output.
  */
 void sfx_downlink_decode(sfx_dl_encoded to_decode, sfx_commoninfo common, sfx_dl_plain *decoded)
+{
+	sfx_workspace workspace;
+	sfx_downlink_decode_ws(&to_decode, &common, decoded, &workspace);
+}
+
+/**
+ * @brief retrieve contents of Sigfox downlink from given raw frame, see ::sfx_downlink_decode, using caller-provided scratch memory
+ * @param to_decode the raw contents of the Sigfox downlink frame to decode
+ * @param common general information about the Sigfox object and its state, see ::sfx_downlink_decode
+ * @param decoded output, contents of Sigfox frame and whether MAC / CRC match
+ * @param workspace scratch memory, see workspace.h
+ */
+void sfx_downlink_decode_ws(const sfx_dl_encoded *to_decode, const sfx_commoninfo *common, sfx_dl_plain *decoded, sfx_workspace *workspace)
 {
 	decoded->crc_ok = false;
 	decoded->mac_ok = false;
@@ -107,8 +121,8 @@ void sfx_downlink_decode(sfx_dl_encoded to_decode, sfx_commoninfo common, sfx_dl
 	/*
 	 * Descramble frame (scrambler / descrambler are identical)
 	 */
-	uint8_t frame[SFX_DL_FRAMELEN];
-	memcpy(frame, to_decode.frame, sizeof(frame));
+	uint8_t *frame = workspace->frame;
+	memcpy(frame, to_decode->frame, SFX_DL_FRAMELEN);
 	sfx_downlink_frame_scramble(frame, common);
 
 	/*
@@ -155,8 +169,221 @@ void sfx_downlink_decode(sfx_dl_encoded to_decode, sfx_commoninfo common, sfx_dl
 	/*
 	 * Check MAC
 	 */
-	uint16_t mac = sfx_downlink_get_mac(decoded->payload, common);
-	decoded->mac_ok = ((mac & 0xff00) >> 8 == frame[SFX_DL_MACOFFSET] && (mac & 0xff) == frame[SFX_DL_MACOFFSET + 1]);
+	uint16_t mac = sfx_downlink_get_mac(decoded->payload, common, &workspace->aes);
+	decoded->mac_ok = (mac == ((frame[SFX_DL_MACOFFSET] << 8) | frame[SFX_DL_MACOFFSET + 1]));
+}
+
+/*
+ * Soft-decision decoding
+ * Chase-II decoding of every interleaved BCH(15,11) codeword: the SFX_DL_SOFT_CHASE_BITS least reliable bits are
+ * flipped in all combinations and every test pattern is corrected by the hard decoder. Distinct results are ranked
+ * by their soft metric (sum of reliabilities of bits that differ from the hard decision). Complete frames are then
+ * assembled from the best candidate of every codeword and from combinations that replace one or two codewords
+ * with their next best candidates, in order of increasing metric. CRC-8 and MAC select the first valid frame.
+ */
+static void soft_insert_combination(sfx_dl_soft_combination *list, uint8_t *count, uint8_t capacity, uint16_t delta, uint8_t first, uint8_t second)
+{
+	uint8_t i;
+
+	if (*count == capacity && list[capacity - 1].delta <= delta)
+		return;
+
+	i = *count < capacity ? (*count)++ : capacity - 1;
+	for (; i > 0 && list[i - 1].delta > delta; --i)
+		list[i] = list[i - 1];
+
+	list[i].delta = delta;
+	list[i].replaced[0] = first;
+	list[i].replaced[1] = second;
+}
+
+static void soft_assemble(const sfx_dl_soft_candidate candidates[][SFX_DL_SOFT_CANDIDATES], const sfx_dl_soft_combination *combination, uint8_t *frame)
+{
+	uint8_t choice[8] = { 0 };
+	uint8_t bitoffset, byte, i;
+
+	for (i = 0; i < 2; ++i)
+		if (combination->replaced[i] != 0xff)
+			choice[combination->replaced[i] / SFX_DL_SOFT_CANDIDATES] = combination->replaced[i] % SFX_DL_SOFT_CANDIDATES;
+
+	// "interleave": write codeword bits to frame bytes
+	memset(frame, 0, SFX_DL_FRAMELEN);
+	for (bitoffset = 0; bitoffset < 8; ++bitoffset)
+		for (byte = 0; byte < 15; ++byte)
+			if (candidates[bitoffset][choice[bitoffset]].code & (1 << (14 - byte)))
+				frame[byte] |= 1 << (7 - bitoffset);
+}
+
+// CRC-8 first, MAC (AES) only for frames with valid CRC
+static bool soft_check(const uint8_t *frame, const sfx_commoninfo *common, sfx_dl_plain *decoded, sfx_mac_workspace *workspace)
+{
+	decoded->crc_ok = renard_crc8(&frame[SFX_DL_PAYLOADOFFSET], SFX_DL_PAYLOADLEN + SFX_DL_MACLEN) == frame[SFX_DL_CRCOFFSET];
+	decoded->mac_ok = false;
+
+	if (decoded->crc_ok) {
+		uint16_t mac = sfx_downlink_get_mac(&frame[SFX_DL_PAYLOADOFFSET], common, workspace);
+		decoded->mac_ok = (mac == ((frame[SFX_DL_MACOFFSET] << 8) | frame[SFX_DL_MACOFFSET + 1]));
+	}
+
+	return decoded->crc_ok && decoded->mac_ok;
+}
+
+/**
+ * @brief retrieve contents of Sigfox downlink from per-bit soft values, correcting more bit errors than ::sfx_downlink_decode
+ * @param softbits ::SFX_DL_SOFTBITS soft values of the raw frame bits (MSB of first frame byte first), positive values for 1, negative values for 0, magnitude indicates reliability
+ * @param common general information about the Sigfox object and its state, NAK is required for choosing the right candidate
+ * @param decoded output, contents of Sigfox frame and whether MAC / CRC match; sfx_dl_plain::fec_corrected is set if the result differs from the hard decisions
+ * @param budget maximum number of candidate frames to check (CRC-8, and MAC if CRC is valid), between 1 and ::SFX_DL_SOFT_MAX_BUDGET, bounds decoding time
+ * @return number of checked candidate frames
+ * @attention If no candidate has a valid CRC and MAC, the most likely candidate is returned with sfx_dl_plain::crc_ok / sfx_dl_plain::mac_ok indicating which checks failed.
+ */
+uint8_t sfx_downlink_decode_soft(const int8_t *softbits, sfx_commoninfo common, sfx_dl_plain *decoded, uint8_t budget)
+{
+	sfx_dl_soft_workspace workspace;
+	return sfx_downlink_decode_soft_ws(softbits, &common, decoded, budget, &workspace);
+}
+
+/**
+ * @brief retrieve contents of Sigfox downlink from per-bit soft values, see ::sfx_downlink_decode_soft, using caller-provided scratch memory
+ * @param softbits ::SFX_DL_SOFTBITS soft values of the raw frame bits, see ::sfx_downlink_decode_soft
+ * @param common general information about the Sigfox object and its state, NAK is required for choosing the right candidate
+ * @param decoded output, contents of Sigfox frame and whether MAC / CRC match
+ * @param budget maximum number of candidate frames to check, between 1 and ::SFX_DL_SOFT_MAX_BUDGET
+ * @param workspace scratch memory of soft-decision decoding, see workspace.h
+ * @return number of checked candidate frames
+ */
+uint8_t sfx_downlink_decode_soft_ws(const int8_t *softbits, const sfx_commoninfo *common, sfx_dl_plain *decoded, uint8_t budget, sfx_dl_soft_workspace *workspace)
+{
+	uint8_t *hard = workspace->hard;
+	uint8_t *frame = workspace->frame;
+	sfx_dl_soft_candidate (*candidates)[SFX_DL_SOFT_CANDIDATES] = workspace->candidates;
+	uint8_t *candidate_count = workspace->candidate_count;
+	sfx_dl_soft_combination *combinations = workspace->combinations;
+	uint8_t combination_count = 0;
+	uint8_t bitoffset, byte, i, j;
+
+	if (budget < 1)
+		budget = 1;
+	if (budget > SFX_DL_SOFT_MAX_BUDGET)
+		budget = SFX_DL_SOFT_MAX_BUDGET;
+
+	/*
+	 * Hard decisions, descramble (reliabilities are not affected by scrambling)
+	 */
+	memset(hard, 0, SFX_DL_FRAMELEN);
+	for (i = 0; i < SFX_DL_SOFTBITS; ++i)
+		if (softbits[i] > 0)
+			hard[i / 8] |= 0x80 >> (i % 8);
+
+	sfx_downlink_frame_scramble(hard, common);
+
+	/*
+	 * Chase decoding of every codeword
+	 */
+	for (bitoffset = 0; bitoffset < 8; ++bitoffset) {
+		uint16_t code = 0x0000;
+		uint8_t reliability[15];
+		uint8_t weakest[SFX_DL_SOFT_CHASE_BITS];
+
+		// "deinterleave": combine bits from frame bytes to single codeword, codeword bit 14 - byte belongs to frame byte `byte`
+		for (byte = 0; byte < 15; ++byte) {
+			int8_t soft = softbits[byte * 8 + bitoffset];
+			reliability[byte] = soft == -128 ? 127 : (soft < 0 ? -soft : soft);
+			code |= ((hard[byte] & (1 << (7 - bitoffset))) ? 1 : 0) << (14 - byte);
+		}
+
+		// select least reliable bits
+		for (i = 0; i < SFX_DL_SOFT_CHASE_BITS; ++i) {
+			weakest[i] = 0xff;
+			for (byte = 0; byte < 15; ++byte) {
+				bool used = false;
+				for (j = 0; j < i; ++j)
+					used |= weakest[j] == byte;
+				if (!used && (weakest[i] == 0xff || reliability[byte] < reliability[weakest[i]]))
+					weakest[i] = byte;
+			}
+		}
+
+		// test patterns, keep distinct results sorted by metric
+		candidate_count[bitoffset] = 0;
+		for (uint8_t pattern = 0; pattern < (1 << SFX_DL_SOFT_CHASE_BITS); ++pattern) {
+			uint16_t test = code;
+			bool changed;
+
+			for (i = 0; i < SFX_DL_SOFT_CHASE_BITS; ++i)
+				if (pattern & (1 << i))
+					test ^= 1 << (14 - weakest[i]);
+
+			test = bch_15_11_correct(test, &changed);
+
+			uint16_t metric = 0;
+			for (byte = 0; byte < 15; ++byte)
+				if ((test ^ code) & (1 << (14 - byte)))
+					metric += reliability[byte];
+
+			sfx_dl_soft_candidate *list = candidates[bitoffset];
+			uint8_t *count = &candidate_count[bitoffset];
+			bool duplicate = false;
+
+			for (i = 0; i < *count; ++i)
+				duplicate |= list[i].code == test;
+			if (duplicate || (*count == SFX_DL_SOFT_CANDIDATES && list[*count - 1].metric <= metric))
+				continue;
+
+			i = *count < SFX_DL_SOFT_CANDIDATES ? (*count)++ : SFX_DL_SOFT_CANDIDATES - 1;
+			for (; i > 0 && list[i - 1].metric > metric; --i)
+				list[i] = list[i - 1];
+			list[i].code = test;
+			list[i].metric = metric;
+		}
+	}
+
+	/*
+	 * Rank frame candidates: best candidates of all codewords, then replacements of one or two codewords
+	 */
+	soft_insert_combination(combinations, &combination_count, budget, 0, 0xff, 0xff);
+
+	for (i = 0; i < 8 * SFX_DL_SOFT_CANDIDATES; ++i) {
+		uint8_t cw1 = i / SFX_DL_SOFT_CANDIDATES, k1 = i % SFX_DL_SOFT_CANDIDATES;
+		if (k1 == 0 || k1 >= candidate_count[cw1])
+			continue;
+
+		uint16_t delta1 = candidates[cw1][k1].metric - candidates[cw1][0].metric;
+		soft_insert_combination(combinations, &combination_count, budget, delta1, i, 0xff);
+
+		for (j = (cw1 + 1) * SFX_DL_SOFT_CANDIDATES; j < 8 * SFX_DL_SOFT_CANDIDATES; ++j) {
+			uint8_t cw2 = j / SFX_DL_SOFT_CANDIDATES, k2 = j % SFX_DL_SOFT_CANDIDATES;
+			if (k2 == 0 || k2 >= candidate_count[cw2])
+				continue;
+
+			uint16_t delta2 = candidates[cw2][k2].metric - candidates[cw2][0].metric;
+			soft_insert_combination(combinations, &combination_count, budget, delta1 + delta2, i, j);
+		}
+	}
+
+	/*
+	 * Check candidates in order, fall back to most likely candidate if no candidate within budget is valid
+	 */
+	uint8_t checked;
+	bool valid = false;
+
+	for (checked = 0; checked < combination_count && !valid; ++checked) {
+		soft_assemble(candidates, &combinations[checked], frame);
+		valid = soft_check(frame, common, decoded, &workspace->aes);
+	}
+
+	if (!valid) {
+		soft_assemble(candidates, &combinations[0], frame);
+		soft_check(frame, common, decoded, &workspace->aes);
+	}
+
+	/*
+	 * Extract payload from frame
+	 */
+	memcpy(decoded->payload, &frame[SFX_DL_PAYLOADOFFSET], SFX_DL_PAYLOADLEN);
+	decoded->fec_corrected = memcmp(frame, hard, SFX_DL_FRAMELEN) != 0;
+
+	return checked;
 }
 
 /**
@@ -167,25 +394,59 @@ void sfx_downlink_decode(sfx_dl_encoded to_decode, sfx_commoninfo common, sfx_dl
  */
 void sfx_downlink_encode(sfx_dl_plain to_encode, sfx_commoninfo common, sfx_dl_encoded *encoded)
 {
+	sfx_workspace workspace;
+	sfx_downlink_encode_ws(&to_encode, &common, encoded, &workspace);
+}
+
+/**
+ * @brief generate raw Sigfox downlink frame, see ::sfx_downlink_encode, using caller-provided scratch memory
+ * @param to_encode content of raw Sigfox frame, only sfx_dl_plain::payload has to be set
+ * @param common general information about the Sigfox object and its state
+ * @param encoded output, raw Sigfox downlink frame, excluding preamble
+ * @param workspace scratch memory, see workspace.h
+ */
+void sfx_downlink_encode_ws(const sfx_dl_plain *to_encode, const sfx_commoninfo *common, sfx_dl_encoded *encoded, sfx_workspace *workspace)
+{
+	sfx_downlink_encode_mac(to_encode->payload, common, encoded->frame, &workspace->aes);
+
 	/*
-	 * Calculate MAC
+	 * Calculate CRC
+	 * CRC is calculated for buffer comprised of payload and MAC
 	 */
-	uint16_t mac = sfx_downlink_get_mac(to_encode.payload, common);
-	encoded->frame[SFX_DL_MACOFFSET] = (mac & 0xff00) >> 8;
-	encoded->frame[SFX_DL_MACOFFSET + 1] = mac & 0xff;
+	encoded->frame[SFX_DL_CRCOFFSET] = renard_crc8(&encoded->frame[SFX_DL_PAYLOADOFFSET], SFX_DL_PAYLOADLEN + SFX_DL_MACLEN);
 
+	sfx_downlink_encode_fec(encoded->frame, common);
+}
+
+/**
+ * @brief first step of downlink encoding: write raw (no FEC, unscrambled) payload and MAC to frame
+ * @param payload ::SFX_DL_PAYLOADLEN bytes of downlink payload
+ * @param common general information about the Sigfox object and its state
+ * @param frame output, ::SFX_DL_FRAMELEN bytes, the CRC-8 of payload and MAC has to be stored at ::SFX_DL_CRCOFFSET before ::sfx_downlink_encode_fec
+ * @param workspace scratch memory of MAC computation
+ */
+void sfx_downlink_encode_mac(const uint8_t *payload, const sfx_commoninfo *common, uint8_t *frame, sfx_mac_workspace *workspace)
+{
 	/*
-	 * Copy raw (no FEC, unscrambled) payload to frame for CRC calculation
+	 * Calculate MAC
 	 */
-	memcpy(&encoded->frame[SFX_DL_PAYLOADOFFSET], to_encode.payload, SFX_DL_PAYLOADLEN);
+	uint16_t mac = sfx_downlink_get_mac(payload, common, workspace);
+	frame[SFX_DL_MACOFFSET] = (mac & 0xff00) >> 8;
+	frame[SFX_DL_MACOFFSET + 1] = mac & 0xff;
 
 	/*
-	 * Calculate CRC
-	 * CRC is calculated for buffer comprised of payload and MAC
+	 * Copy raw (no FEC, unscrambled) payload to frame for CRC calculation
 	 */
-	uint8_t crc8 = renard_crc8(&encoded->frame[SFX_DL_PAYLOADOFFSET], SFX_DL_PAYLOADLEN + SFX_DL_MACLEN);
-	encoded->frame[SFX_DL_CRCOFFSET] = crc8;
+	memcpy(&frame[SFX_DL_PAYLOADOFFSET], payload, SFX_DL_PAYLOADLEN);
+}
 
+/**
+ * @brief last step of downlink encoding: add FEC redundancy to a frame with payload, MAC and CRC and scramble it
+ * @param frame frame prepared by ::sfx_downlink_encode_mac, including CRC, encoded in place
+ * @param common general information about the Sigfox object and its state
+ */
+void sfx_downlink_encode_fec(uint8_t *frame, const sfx_commoninfo *common)
+{
 	/*
 	 * Add redundancy for FEC (and "interleaving")
 	 */
@@ -194,7 +455,7 @@ void sfx_downlink_encode(sfx_dl_plain to_encode, sfx_commoninfo common, sfx_dl_e
 
 		// "deinterleave": combine bits from payload bytes to single 11-bit payload value
 		for (uint8_t byte = 0; byte < 11; ++byte)
-			if (encoded->frame[SFX_DL_PAYLOADOFFSET + byte] & (1 << (7 - bitoffset)))
+			if (frame[SFX_DL_PAYLOADOFFSET + byte] & (1 << (7 - bitoffset)))
 				code |= 1 << (10 - byte);
 
 		code = bch_15_11_extend(code);
@@ -202,14 +463,227 @@ void sfx_downlink_encode(sfx_dl_plain to_encode, sfx_commoninfo common, sfx_dl_e
 		// "interleave": write back bits to frame bytes
 		for (uint8_t byte = 0; byte < 15; ++byte) {
 			if (code & (1 << (14 - byte)))
-				encoded->frame[byte] |= 1 << (7 - bitoffset);
+				frame[byte] |= 1 << (7 - bitoffset);
 			else
-				encoded->frame[byte] &= ~(1 << (7 - bitoffset));
+				frame[byte] &= ~(1 << (7 - bitoffset));
 		}
 	}
 
 	/*
 	 * Scramble frame (scrambler / descrambler are identical)
 	 */
-	sfx_downlink_frame_scramble(encoded->frame, common);
+	sfx_downlink_frame_scramble(frame, common);
+}
+
+/**
+ * @brief copy bytes to output buffer at arbitrary bit offset, bits of output buffer before and after the copied range are preserved
+ * @param outbuffer pointer to output buffer
+ * @param inbuffer pointer to input buffer
+ * @param length_bytes number of bytes to copy
+ * @param offset_bits offset at which to start writing to outbuffer, in bits (0 to 7)
+ */
+static void memcpy_bitoffset(uint8_t *outbuffer, const uint8_t *inbuffer, uint8_t length_bytes, uint8_t offset_bits)
+{
+	if (offset_bits == 0) {
+		memcpy(outbuffer, inbuffer, length_bytes);
+		return;
+	}
+
+	uint8_t keepmask = 0xff << (8 - offset_bits);
+	for (uint8_t i = 0; i < length_bytes; ++i) {
+		outbuffer[i] = (outbuffer[i] & keepmask) | (inbuffer[i] >> offset_bits);
+		outbuffer[i + 1] = (outbuffer[i + 1] & ~keepmask) | (inbuffer[i] << (8 - offset_bits));
+	}
+}
+
+/**
+ * @brief generate complete on-air downlink bitstream (preamble followed by raw Sigfox downlink frame) in a single buffer
+ * @param to_encode content of raw Sigfox frame, only sfx_dl_plain::payload has to be set, all other members of ::sfx_dl_plain are ignored
+ * @param common general information about the Sigfox object and its state
+ * @param onair output, ::SFX_DL_ONAIRLEN bytes long, plus one byte if `offset_bits` is not 0
+ * @param offset_bits bit position in first byte of `onair` (counted from MSB, 0 to 7) at which the preamble starts; bits before the preamble and after the end of the frame are left untouched
+ */
+void sfx_downlink_encode_onair(sfx_dl_plain to_encode, sfx_commoninfo common, uint8_t *onair, uint8_t offset_bits)
+{
+	sfx_workspace workspace;
+	sfx_downlink_encode_onair_ws(&to_encode, &common, onair, offset_bits, &workspace);
+}
+
+/**
+ * @brief generate complete on-air downlink bitstream, see ::sfx_downlink_encode_onair, using caller-provided scratch memory
+ * @param to_encode content of raw Sigfox frame, only sfx_dl_plain::payload has to be set
+ * @param common general information about the Sigfox object and its state
+ * @param onair output, see ::sfx_downlink_encode_onair
+ * @param offset_bits bit position in first byte of `onair` at which the preamble starts, see ::sfx_downlink_encode_onair
+ * @param workspace scratch memory, see workspace.h
+ */
+void sfx_downlink_encode_onair_ws(const sfx_dl_plain *to_encode, const sfx_commoninfo *common, uint8_t *onair, uint8_t offset_bits, sfx_workspace *workspace)
+{
+	sfx_dl_encoded encoded;
+	sfx_downlink_encode_ws(to_encode, common, &encoded, workspace);
+
+	offset_bits %= 8;
+	memcpy_bitoffset(onair, SFX_DL_PREAMBLE, SFX_DL_PREAMBLELEN, offset_bits);
+	memcpy_bitoffset(&onair[SFX_DL_PREAMBLELEN], encoded.frame, SFX_DL_FRAMELEN, offset_bits);
+}
+
+/**
+ * @brief generate on-air downlink bitstreams for many Sigfox objects at once, e.g. for all responses due in the same downlink window
+ * @param to_encode array of `count` downlink contents, see ::sfx_downlink_encode_onair
+ * @param common array of `count` Sigfox object descriptions (device ID, sequence number of corresponding uplink and NAK), one per downlink
+ * @param count number of downlinks to generate
+ * @param onair output, the n-th on-air bitstream is written to `onair + n * stride_bytes`
+ * @param stride_bytes distance between two consecutive bitstreams in `onair`, at least ::SFX_DL_ONAIRLEN (plus one if `offset_bits` is not 0)
+ * @param offset_bits bit alignment of every bitstream, see ::sfx_downlink_encode_onair
+ */
+void sfx_downlink_encode_batch(const sfx_dl_plain *to_encode, const sfx_commoninfo *common, uint16_t count, uint8_t *onair, uint16_t stride_bytes, uint8_t offset_bits)
+{
+	sfx_workspace workspace;
+	sfx_downlink_encode_batch_ws(to_encode, common, count, onair, stride_bytes, offset_bits, &workspace);
+}
+
+/**
+ * @brief generate on-air downlink bitstreams for many Sigfox objects at once, see ::sfx_downlink_encode_batch, using caller-provided scratch memory
+ * @param to_encode array of `count` downlink contents, see ::sfx_downlink_encode_onair
+ * @param common array of `count` Sigfox object descriptions, one per downlink
+ * @param count number of downlinks to generate
+ * @param onair output, the n-th on-air bitstream is written to `onair + n * stride_bytes`
+ * @param stride_bytes distance between two consecutive bitstreams in `onair`, see ::sfx_downlink_encode_batch
+ * @param offset_bits bit alignment of every bitstream, see ::sfx_downlink_encode_onair
+ * @param workspace scratch memory, see workspace.h
+ */
+void sfx_downlink_encode_batch_ws(const sfx_dl_plain *to_encode, const sfx_commoninfo *common, uint16_t count, uint8_t *onair, uint16_t stride_bytes, uint8_t offset_bits, sfx_workspace *workspace)
+{
+	sfx_dl_encoded frames[SFX_DL_BATCH_CRC_CHUNK];
+	uint8_t const *data[SFX_DL_BATCH_CRC_CHUNK];
+	uint8_t crcs[SFX_DL_BATCH_CRC_CHUNK];
+	uint16_t i, n;
+
+	offset_bits %= 8;
+
+	/*
+	 * MACs per frame, CRCs in chunks of up to SFX_DL_BATCH_CRC_CHUNK frames, then FEC and scrambling per frame
+	 */
+	for (i = 0; i < count; i += n) {
+		n = count - i < SFX_DL_BATCH_CRC_CHUNK ? count - i : SFX_DL_BATCH_CRC_CHUNK;
+
+		for (uint16_t j = 0; j < n; ++j) {
+			sfx_downlink_encode_mac(to_encode[i + j].payload, &common[i + j], frames[j].frame, &workspace->aes);
+			data[j] = &frames[j].frame[SFX_DL_PAYLOADOFFSET];
+		}
+
+		renard_crc8_multi(data, SFX_DL_PAYLOADLEN + SFX_DL_MACLEN, n, crcs);
+
+		for (uint16_t j = 0; j < n; ++j) {
+			uint8_t *out = onair + (uint32_t)(i + j) * stride_bytes;
+
+			frames[j].frame[SFX_DL_CRCOFFSET] = crcs[j];
+			sfx_downlink_encode_fec(frames[j].frame, &common[i + j]);
+
+			memcpy_bitoffset(out, SFX_DL_PREAMBLE, SFX_DL_PREAMBLELEN, offset_bits);
+			memcpy_bitoffset(&out[SFX_DL_PREAMBLELEN], frames[j].frame, SFX_DL_FRAMELEN, offset_bits);
+		}
+	}
+}
+
+/*
+ * Response cache
+ * The encoded downlink frame only depends on device ID, sequence number, payload and NAK, so responses with a static
+ * payload can be encoded in advance for the next expected sequence numbers. The valid frames form a contiguous range
+ * starting at `first`, so that lookups are O(1) and changing the payload invalidates all frames at once.
+ * The cache is not thread-safe, refilling and lookups for the same device must be serialized by the caller.
+ */
+
+/**
+ * @brief initialize downlink response cache, frames are encoded by ::sfx_downlink_cache_refill
+ * @param cache cache to initialize
+ * @param common device ID and NAK of Sigfox object
+ * @param payload plaintext downlink payload, ::SFX_DL_PAYLOADLEN bytes
+ * @param first sequence number of the next expected uplink with downlink request
+ * @param frames caller-provided memory for `capacity` encoded frames
+ * @param capacity number of frames in window, must be a power of two and at most ::SFX_DL_CACHE_MAX_WINDOW
+ * @return false if capacity is invalid
+ */
+bool sfx_downlink_cache_init(sfx_dl_cache *cache, const sfx_commoninfo *common, const uint8_t *payload, uint16_t first, sfx_dl_encoded *frames, uint16_t capacity)
+{
+	if (capacity == 0 || capacity > SFX_DL_CACHE_MAX_WINDOW || (capacity & (capacity - 1)) != 0)
+		return false;
+
+	cache->common = *common;
+	memcpy(cache->payload, payload, SFX_DL_PAYLOADLEN);
+	cache->first = first & 0xfff;
+	cache->ready = 0;
+	cache->mask = capacity - 1;
+	cache->frames = frames;
+
+	return true;
+}
+
+/**
+ * @brief encode missing frames of window, e.g. in the background or after ::sfx_downlink_cache_advance
+ * @param cache response cache
+ * @param budget maximum number of frames to encode in this call
+ * @return number of encoded frames, 0 if window is complete
+ */
+uint16_t sfx_downlink_cache_refill(sfx_dl_cache *cache, uint16_t budget)
+{
+	uint16_t encoded = 0;
+	sfx_dl_plain plain;
+	sfx_commoninfo common = cache->common;
+
+	memset(&plain, 0, sizeof(plain));
+	memcpy(plain.payload, cache->payload, SFX_DL_PAYLOADLEN);
+
+	while (encoded < budget && cache->ready <= cache->mask) {
+		common.seqnum = (cache->first + cache->ready) & 0xfff;
+		sfx_downlink_encode(plain, common, &cache->frames[common.seqnum & cache->mask]);
+		cache->ready++;
+		encoded++;
+	}
+
+	return encoded;
+}
+
+/**
+ * @brief slide window of response cache, frames that remain in the window stay valid
+ * @param cache response cache
+ * @param first new first sequence number of window, e.g. sequence number of last received uplink + 1
+ */
+void sfx_downlink_cache_advance(sfx_dl_cache *cache, uint16_t first)
+{
+	uint16_t distance = (first - cache->first) & 0xfff;
+
+	cache->ready = distance < cache->ready ? cache->ready - distance : 0;
+	cache->first = first & 0xfff;
+}
+
+/**
+ * @brief change payload of cached responses, all frames are invalidated if it differs from the current payload
+ * @param cache response cache
+ * @param payload new plaintext downlink payload, ::SFX_DL_PAYLOADLEN bytes
+ * @return true if payload was changed (frames need to be encoded again)
+ */
+bool sfx_downlink_cache_set_payload(sfx_dl_cache *cache, const uint8_t *payload)
+{
+	if (memcmp(cache->payload, payload, SFX_DL_PAYLOADLEN) == 0)
+		return false;
+
+	memcpy(cache->payload, payload, SFX_DL_PAYLOADLEN);
+	cache->ready = 0;
+
+	return true;
+}
+
+/**
+ * @brief get encoded downlink response for received uplink
+ * @param cache response cache
+ * @param seqnum 12-bit sequence number of uplink that requested the downlink
+ * @return encoded downlink frame, NULL if it is not cached (encode with ::sfx_downlink_encode instead)
+ */
+const sfx_dl_encoded *sfx_downlink_cache_get(const sfx_dl_cache *cache, uint16_t seqnum)
+{
+	if (((seqnum - cache->first) & 0xfff) >= cache->ready)
+		return NULL;
+
+	return &cache->frames[seqnum & cache->mask];
 }
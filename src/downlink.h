@@ -24,7 +24,7 @@
 /*
  * Public interface:
  */
-extern uint8_t SFX_DL_PREAMBLE[];
+extern const uint8_t SFX_DL_PREAMBLE[];
 
 /// length of Sigfox's downlink preamble, in bytes
 #define SFX_DL_PREAMBLELEN 13
@@ -57,4 +57,64 @@ typedef struct _s_sfx_dl_plain {
 void sfx_downlink_decode(sfx_dl_encoded encoded, sfx_commoninfo common, sfx_dl_plain *decoded);
 void sfx_downlink_encode(sfx_dl_plain to_encode, sfx_commoninfo common, sfx_dl_encoded *encoded);
 
+/*
+ * Soft-decision decoding, see ::sfx_downlink_decode_soft
+ */
+
+/// number of soft values per downlink frame, one per frame bit (MSB of first frame byte first)
+#define SFX_DL_SOFTBITS (SFX_DL_FRAMELEN * 8)
+
+/// number of least reliable bits per BCH codeword that are flipped during Chase decoding (2^n test patterns per codeword)
+#define SFX_DL_SOFT_CHASE_BITS 3
+
+/// maximum number of distinct candidates kept per BCH codeword
+#define SFX_DL_SOFT_CANDIDATES 4
+
+/// maximum candidate budget of ::sfx_downlink_decode_soft
+#define SFX_DL_SOFT_MAX_BUDGET 64
+
+uint8_t sfx_downlink_decode_soft(const int8_t *softbits, sfx_commoninfo common, sfx_dl_plain *decoded, uint8_t budget);
+
+/*
+ * Response cache, see ::sfx_downlink_cache_init
+ */
+
+/// maximum capacity of ::sfx_dl_cache, so that 12-bit sequence numbers in the window are unique
+#define SFX_DL_CACHE_MAX_WINDOW 4096
+
+/**
+ * @brief encoded downlink frames with a static payload for a window of upcoming sequence numbers of a single device
+ */
+typedef struct _s_sfx_dl_cache {
+	/// device ID and NAK of Sigfox object, sequence number is ignored
+	sfx_commoninfo common;
+
+	/// plaintext downlink payload of all cached frames
+	uint8_t payload[SFX_DL_PAYLOADLEN];
+
+	/// 12-bit sequence number of first frame in window
+	uint16_t first;
+
+	/// number of valid frames, frames for sequence numbers [first, first + ready) are valid
+	uint16_t ready;
+
+	/// capacity - 1
+	uint16_t mask;
+
+	/// caller-provided frame memory, frame for sequence number `s` is stored at index `s & mask`
+	sfx_dl_encoded *frames;
+} sfx_dl_cache;
+
+bool sfx_downlink_cache_init(sfx_dl_cache *cache, const sfx_commoninfo *common, const uint8_t *payload, uint16_t first, sfx_dl_encoded *frames, uint16_t capacity);
+uint16_t sfx_downlink_cache_refill(sfx_dl_cache *cache, uint16_t budget);
+void sfx_downlink_cache_advance(sfx_dl_cache *cache, uint16_t first);
+bool sfx_downlink_cache_set_payload(sfx_dl_cache *cache, const uint8_t *payload);
+const sfx_dl_encoded *sfx_downlink_cache_get(const sfx_dl_cache *cache, uint16_t seqnum);
+
+/// length of on-air downlink bitstream (preamble and frame), in bytes
+#define SFX_DL_ONAIRLEN (SFX_DL_PREAMBLELEN + SFX_DL_FRAMELEN)
+
+void sfx_downlink_encode_onair(sfx_dl_plain to_encode, sfx_commoninfo common, uint8_t *onair, uint8_t offset_bits);
+void sfx_downlink_encode_batch(const sfx_dl_plain *to_encode, const sfx_commoninfo *common, uint16_t count, uint8_t *onair, uint16_t stride_bytes, uint8_t offset_bits);
+
 #endif
@@ -0,0 +1,257 @@
+#include <string.h>
+
+#include "downlink_sched.h"
+#include "downlink.h"
+#include "workspace.h"
+#include "sigfox_crc.h"
+
+/*
+ * Downlink scheduler
+ * Responses expire at the tick at which they are encoded (deadline minus lead time) and are kept in a hierarchical
+ * timing wheel: level 0 has one slot per tick, a slot of level n covers SFX_DL_SCHED_SLOTS^n ticks. A response is
+ * inserted into the lowest level whose range covers its expiry, and whenever the slot index of a level wraps around,
+ * the responses of the current slot of the next higher level are redistributed to the lower levels ("cascade").
+ * Insertion is O(1), every response cascades at most SFX_DL_SCHED_LEVELS - 1 times. Responses of a level 0 slot all
+ * expire at the same tick and are encoded in batches of up to `batch_size` responses.
+ */
+
+/// slot index mask of a timing wheel level
+#define SFX_DL_SCHED_SLOT_MASK (SFX_DL_SCHED_SLOTS - 1)
+
+/**
+ * @brief initialize downlink scheduler
+ * @param sched scheduler to initialize
+ * @param entries caller-provided memory for `capacity` responses, i.e. the maximum number of pending responses
+ * @param capacity number of responses
+ * @param batch caller-provided memory for `batch_size` emitted responses
+ * @param batch_size maximum number of responses per call of the emit callback
+ * @param lead number of ticks before its deadline at which a response is encoded and emitted, at least 1, e.g. the
+ * time it takes to hand a frame to a base station
+ * @param now current tick, see ::sfx_downlink_sched_advance
+ * @param emit emit callback, may call ::sfx_downlink_sched_submit but must not call ::sfx_downlink_sched_advance
+ * @param context context pointer passed to `emit`
+ * @return false if a capacity or the lead time is invalid
+ */
+bool sfx_downlink_sched_init(sfx_dl_sched *sched, sfx_dl_sched_entry *entries, uint32_t capacity, sfx_dl_sched_response *batch, uint32_t batch_size, uint32_t lead, uint32_t now, sfx_dl_sched_emit emit, void *context)
+{
+	uint32_t i;
+
+	if (capacity == 0 || capacity == SFX_DL_SCHED_NONE || batch_size == 0)
+		return false;
+
+	if (lead == 0 || lead >= SFX_DL_SCHED_HORIZON)
+		return false;
+
+	memset(sched, 0, sizeof(*sched));
+	sched->entries = entries;
+	sched->capacity = capacity;
+	sched->batch = batch;
+	sched->batch_size = batch_size;
+	sched->now = now;
+	sched->lead = lead;
+	sched->emit = emit;
+	sched->context = context;
+
+	memset(sched->wheel, 0xff, sizeof(sched->wheel));
+
+	for (i = 0; i < capacity; ++i)
+		entries[i].next = i + 1 < capacity ? i + 1 : SFX_DL_SCHED_NONE;
+	sched->free = 0;
+
+	return true;
+}
+
+/**
+ * @brief insert response into the timing wheel slot of its expiry, relative to the current tick
+ */
+static void sfx_downlink_sched_insert(sfx_dl_sched *sched, uint32_t index)
+{
+	sfx_dl_sched_entry *entry = &sched->entries[index];
+	uint32_t ticks = entry->expires - sched->now;
+	uint8_t level = 0;
+
+	while (level < SFX_DL_SCHED_LEVELS - 1 && ticks >= (1UL << ((level + 1) * SFX_DL_SCHED_SLOT_BITS)))
+		level++;
+
+	uint32_t *slot = &sched->wheel[level][(entry->expires >> (level * SFX_DL_SCHED_SLOT_BITS)) & SFX_DL_SCHED_SLOT_MASK];
+	entry->next = *slot;
+	*slot = index;
+}
+
+/**
+ * @brief schedule a downlink response, it is encoded and emitted `lead` ticks before its deadline (see
+ * ::sfx_downlink_sched_init), or at the next tick if that is already later
+ * @param sched downlink scheduler
+ * @param common device ID, sequence number of corresponding uplink and NAK of Sigfox object
+ * @param payload plaintext downlink payload, ::SFX_DL_PAYLOADLEN bytes
+ * @param deadline tick by which the downlink has to be handed to the base station, e.g. the opening of the receive
+ * window of the device minus the transmission delay; ticks may wrap around
+ * @param tag caller-defined identifier of response, passed back in ::sfx_dl_sched_entry
+ * @return false if the response was not scheduled: its deadline is not later than the next tick, it is at least
+ * ::SFX_DL_SCHED_HORIZON ticks ahead, or response memory is exhausted (see ::sfx_dl_sched_stats)
+ */
+bool sfx_downlink_sched_submit(sfx_dl_sched *sched, const sfx_commoninfo *common, const uint8_t *payload, uint32_t deadline, uint32_t tag)
+{
+	sched->stats.submitted++;
+
+	if ((int32_t)(deadline - sched->now) <= 1) {
+		sched->stats.late++;
+		return false;
+	}
+
+	uint32_t expires = deadline - sched->lead;
+	if ((int32_t)(expires - sched->now) < 1)
+		expires = sched->now + 1;
+
+	if (expires - sched->now >= SFX_DL_SCHED_HORIZON || sched->free == SFX_DL_SCHED_NONE) {
+		sched->stats.dropped++;
+		return false;
+	}
+
+	uint32_t index = sched->free;
+	sfx_dl_sched_entry *entry = &sched->entries[index];
+	sched->free = entry->next;
+
+	entry->common = *common;
+	memcpy(entry->payload, payload, SFX_DL_PAYLOADLEN);
+	entry->deadline = deadline;
+	entry->expires = expires;
+	entry->tag = tag;
+
+	sfx_downlink_sched_insert(sched, index);
+	sched->pending++;
+
+	return true;
+}
+
+/**
+ * @brief return response to the free list
+ */
+static void sfx_downlink_sched_free(sfx_dl_sched *sched, const sfx_dl_sched_entry *entry)
+{
+	uint32_t index = entry - sched->entries;
+	sched->entries[index].next = sched->free;
+	sched->free = index;
+}
+
+/**
+ * @brief encode due responses of batch, call emit callback for due and missed responses and free their entries
+ */
+static void sfx_downlink_sched_flush(sfx_dl_sched *sched, uint32_t due, uint32_t missed)
+{
+	sfx_dl_sched_response *batch = sched->batch;
+	uint8_t const *data[SFX_DL_BATCH_CRC_CHUNK];
+	uint8_t crcs[SFX_DL_BATCH_CRC_CHUNK];
+	uint32_t i, j, n;
+
+	// MACs per response, CRCs of up to SFX_DL_BATCH_CRC_CHUNK responses at once, then FEC and scrambling in place
+	for (i = 0; i < due; i += n) {
+		n = due - i < SFX_DL_BATCH_CRC_CHUNK ? due - i : SFX_DL_BATCH_CRC_CHUNK;
+
+		for (j = 0; j < n; ++j) {
+			sfx_downlink_encode_mac(batch[i + j].entry->payload, &batch[i + j].entry->common, batch[i + j].frame.frame, &sched->workspace.aes);
+			data[j] = &batch[i + j].frame.frame[SFX_DL_PAYLOADOFFSET];
+		}
+
+		renard_crc8_multi(data, SFX_DL_PAYLOADLEN + SFX_DL_MACLEN, n, crcs);
+
+		for (j = 0; j < n; ++j) {
+			batch[i + j].frame.frame[SFX_DL_CRCOFFSET] = crcs[j];
+			sfx_downlink_encode_fec(batch[i + j].frame.frame, &batch[i + j].entry->common);
+		}
+	}
+
+	if (due > 0 && sched->emit)
+		sched->emit(sched->context, batch, due, SFX_DL_SCHED_EMIT_DUE);
+
+	if (missed > 0 && sched->emit)
+		sched->emit(sched->context, &batch[sched->batch_size - missed], missed, SFX_DL_SCHED_EMIT_MISSED);
+
+	sched->stats.encoded += due;
+	sched->stats.missed += missed;
+	sched->stats.batches += due > 0;
+
+	for (i = 0; i < due; ++i)
+		sfx_downlink_sched_free(sched, batch[i].entry);
+
+	for (i = sched->batch_size - missed; i < sched->batch_size; ++i)
+		sfx_downlink_sched_free(sched, batch[i].entry);
+
+	sched->pending -= due + missed;
+}
+
+/**
+ * @brief move responses of a slot of a higher level to the lower levels, relative to the current tick
+ */
+static void sfx_downlink_sched_cascade(sfx_dl_sched *sched, uint8_t level, uint32_t slot)
+{
+	uint32_t index = sched->wheel[level][slot];
+	sched->wheel[level][slot] = SFX_DL_SCHED_NONE;
+
+	while (index != SFX_DL_SCHED_NONE) {
+		uint32_t next = sched->entries[index].next;
+		sfx_downlink_sched_insert(sched, index);
+		index = next;
+	}
+}
+
+/**
+ * @brief emit all responses of the level 0 slot of the current tick in batches; responses whose deadline is not later
+ * than `now` are missed
+ */
+static void sfx_downlink_sched_expire(sfx_dl_sched *sched, uint32_t now)
+{
+	uint32_t *slot = &sched->wheel[0][sched->now & SFX_DL_SCHED_SLOT_MASK];
+	uint32_t due = 0, missed = 0;
+
+	while (*slot != SFX_DL_SCHED_NONE) {
+		uint32_t index = *slot;
+		sfx_dl_sched_entry *entry = &sched->entries[index];
+		*slot = entry->next;
+
+		if ((int32_t)(entry->deadline - now) > 0)
+			sched->batch[due++].entry = entry;
+		else
+			sched->batch[sched->batch_size - ++missed].entry = entry;
+
+		if (due + missed == sched->batch_size) {
+			sfx_downlink_sched_flush(sched, due, missed);
+			due = missed = 0;
+		}
+	}
+
+	if (due + missed > 0)
+		sfx_downlink_sched_flush(sched, due, missed);
+}
+
+/**
+ * @brief advance time to the given tick: encode and emit all responses that expire in the meantime, i.e. whose
+ * deadline is at most `lead` ticks ahead (see ::sfx_downlink_sched_init); tick duration is up to the caller
+ * (e.g. 10 ms), the tick counter may wrap around
+ * If time advances by more than one tick, e.g. because the caller was stalled or a virtual clock skips idle time,
+ * responses whose deadline is not later than `now` are emitted as missed (without being encoded). The execution
+ * time is linear in the number of elapsed ticks while responses are pending.
+ * @param sched downlink scheduler
+ * @param now current tick, must not be earlier than the tick of the previous call
+ */
+void sfx_downlink_sched_advance(sfx_dl_sched *sched, uint32_t now)
+{
+	while (sched->now != now) {
+		if (sched->pending == 0) {
+			sched->now = now;
+			break;
+		}
+
+		sched->now++;
+
+		// cascade from higher levels whenever the slot index of a level wraps around
+		for (uint8_t level = 1; level < SFX_DL_SCHED_LEVELS; ++level) {
+			uint32_t slot = (sched->now >> (level * SFX_DL_SCHED_SLOT_BITS)) & SFX_DL_SCHED_SLOT_MASK;
+			if ((sched->now & ((1UL << (level * SFX_DL_SCHED_SLOT_BITS)) - 1)) != 0)
+				break;
+			sfx_downlink_sched_cascade(sched, level, slot);
+		}
+
+		sfx_downlink_sched_expire(sched, now);
+	}
+}
@@ -0,0 +1,145 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "downlink.h"
+#include "workspace.h"
+#include "common.h"
+
+#ifndef _DOWNLINK_SCHED_H
+#define _DOWNLINK_SCHED_H
+
+/*
+ * Downlink scheduler: keeps pending downlink responses in a hierarchical timing wheel keyed by transmit deadline,
+ * encodes all responses that are due at the same tick in one batch and hands them to the application through a
+ * callback, see ::sfx_downlink_sched_advance. Time advances in ticks of a duration chosen by the application, driven
+ * by a real or a virtual clock. All memory is provided by the caller on initialization.
+ */
+
+/// number of levels of the timing wheel
+#define SFX_DL_SCHED_LEVELS 4
+
+/// number of slots per level of the timing wheel, as a power of two
+#define SFX_DL_SCHED_SLOT_BITS 6
+#define SFX_DL_SCHED_SLOTS (1 << SFX_DL_SCHED_SLOT_BITS)
+
+/// responses can be scheduled up to this many ticks ahead
+#define SFX_DL_SCHED_HORIZON (1UL << (SFX_DL_SCHED_LEVELS * SFX_DL_SCHED_SLOT_BITS))
+
+/// index that marks the end of a list / an empty slot
+#define SFX_DL_SCHED_NONE 0xffffffff
+
+/// responses are emitted encoded, ahead of their deadline
+#define SFX_DL_SCHED_EMIT_DUE 0
+
+/// responses are emitted without being encoded because their deadline has passed before they could be encoded
+#define SFX_DL_SCHED_EMIT_MISSED 1
+
+/**
+ * @brief pending downlink response
+ */
+typedef struct _s_sfx_dl_sched_entry {
+	/// device ID, sequence number of corresponding uplink and NAK of Sigfox object
+	sfx_commoninfo common;
+
+	/// plaintext downlink payload
+	uint8_t payload[SFX_DL_PAYLOADLEN];
+
+	/// tick by which the downlink has to be handed to the base station
+	uint32_t deadline;
+
+	/// tick at which the response is encoded, deadline minus lead time
+	uint32_t expires;
+
+	/// caller-defined identifier of response, e.g. base station
+	uint32_t tag;
+
+	/// next response in timing wheel slot / next free response
+	uint32_t next;
+} sfx_dl_sched_entry;
+
+/**
+ * @brief emitted downlink response
+ */
+typedef struct _s_sfx_dl_sched_response {
+	/// pending response, only valid during callback
+	const sfx_dl_sched_entry *entry;
+
+	/// encoded downlink frame, only set for ::SFX_DL_SCHED_EMIT_DUE
+	sfx_dl_encoded frame;
+} sfx_dl_sched_response;
+
+/**
+ * @brief emit callback, called from ::sfx_downlink_sched_advance for every batch of responses
+ * @param context context pointer passed to ::sfx_downlink_sched_init
+ * @param responses emitted responses, only valid during callback
+ * @param count number of responses, at least 1
+ * @param reason SFX_DL_SCHED_EMIT_*
+ */
+typedef void (*sfx_dl_sched_emit)(void *context, const sfx_dl_sched_response responses[], uint32_t count, uint8_t reason);
+
+/**
+ * @brief counters of downlink scheduler
+ */
+typedef struct _s_sfx_dl_sched_stats {
+	/// number of responses passed to ::sfx_downlink_sched_submit
+	uint64_t submitted;
+
+	/// number of responses that were rejected because their deadline could not be met any more on submission
+	uint64_t late;
+
+	/// number of responses that were rejected because no entry was available or the deadline is beyond the horizon
+	uint64_t dropped;
+
+	/// number of responses that were encoded and emitted ahead of their deadline
+	uint64_t encoded;
+
+	/// number of responses whose deadline has passed before they could be encoded (clock advanced by multiple ticks)
+	uint64_t missed;
+
+	/// number of emitted batches of due responses
+	uint64_t batches;
+} sfx_dl_sched_stats;
+
+/**
+ * @brief downlink scheduler, see ::sfx_downlink_sched_init
+ */
+typedef struct _s_sfx_dl_sched {
+	/// caller-provided response memory
+	sfx_dl_sched_entry *entries;
+	uint32_t capacity;
+
+	/// caller-provided batch memory, due responses are stored from the front, missed responses from the back
+	sfx_dl_sched_response *batch;
+	uint32_t batch_size;
+
+	/// timing wheel, one list of responses per slot, level n has a resolution of SFX_DL_SCHED_SLOTS^n ticks
+	uint32_t wheel[SFX_DL_SCHED_LEVELS][SFX_DL_SCHED_SLOTS];
+
+	/// free list of responses
+	uint32_t free;
+
+	/// number of pending responses
+	uint32_t pending;
+
+	/// current tick, see ::sfx_downlink_sched_advance
+	uint32_t now;
+
+	/// number of ticks before its deadline at which a response is encoded
+	uint32_t lead;
+
+	/// emit callback
+	sfx_dl_sched_emit emit;
+	void *context;
+
+	/// scratch buffers of downlink encoding
+	sfx_workspace workspace;
+
+	/// counters
+	sfx_dl_sched_stats stats;
+} sfx_dl_sched;
+
+bool sfx_downlink_sched_init(sfx_dl_sched *sched, sfx_dl_sched_entry *entries, uint32_t capacity, sfx_dl_sched_response *batch, uint32_t batch_size, uint32_t lead, uint32_t now, sfx_dl_sched_emit emit, void *context);
+bool sfx_downlink_sched_submit(sfx_dl_sched *sched, const sfx_commoninfo *common, const uint8_t *payload, uint32_t deadline, uint32_t tag);
+void sfx_downlink_sched_advance(sfx_dl_sched *sched, uint32_t now);
+
+#endif
@@ -0,0 +1,182 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "payload_crypto.h"
+#include "backend.h"
+
+/*
+ * Counter block layout (16 bytes):
+ * device ID (4 bytes, little endian) | frame counter (4 bytes, little endian) | direction (1 byte, 0x00 = uplink, 0x01 = downlink) | 7 zero bytes
+ * Key derivation block layout: device ID (4 bytes, little endian) | 12 bytes 0xff, can never collide with a counter block
+ */
+
+/**
+ * @brief derive payload encryption key from NAK, so that the NAK is not used for both MAC and encryption
+ * @param common device ID and NAK of Sigfox object
+ * @param kenc output, 16-byte encryption key
+ */
+void sfx_crypto_derive_key(const sfx_commoninfo *common, uint8_t *kenc)
+{
+	uint8_t i;
+
+	for (i = 0; i < 4; ++i)
+		kenc[i] = common->devid >> (8 * i);
+	memset(&kenc[4], 0xff, 12);
+
+	renard_backend_get()->aes_128_encrypt(kenc, common->key);
+}
+
+/**
+ * @brief generate keystream block for a single frame (one AES operation)
+ * @param kenc encryption key, see ::sfx_crypto_derive_key
+ * @param devid device ID of Sigfox object
+ * @param counter 32-bit frame counter, see ::SFX_CRYPTO_COUNTER; downlinks use the counter of the corresponding uplink
+ * @param downlink true for downlink payloads, false for uplink payloads
+ * @param keystream output, ::SFX_KEYSTREAM_LEN bytes
+ */
+void sfx_crypto_keystream(const uint8_t *kenc, uint32_t devid, uint32_t counter, bool downlink, uint8_t *keystream)
+{
+	uint8_t i;
+
+	for (i = 0; i < 4; ++i) {
+		keystream[i] = devid >> (8 * i);
+		keystream[i + 4] = counter >> (8 * i);
+	}
+	keystream[8] = downlink ? 0x01 : 0x00;
+	memset(&keystream[9], 0x00, 7);
+
+	renard_backend_get()->aes_128_encrypt(keystream, kenc);
+}
+
+/**
+ * @brief reconstruct 32-bit frame counter from received 12-bit sequence number
+ * @param reference frame counter the received frame is expected to be close to, e.g. counter of last received frame + 1
+ * @param seqnum received 12-bit sequence number
+ * @return frame counter with given sequence number in [reference - 2048, reference + 2047]
+ */
+uint32_t sfx_crypto_counter_resolve(uint32_t reference, uint16_t seqnum)
+{
+	int32_t delta = (seqnum - reference) & 0xfff;
+
+	if (delta >= 2048)
+		delta -= 4096;
+
+	return reference + delta;
+}
+
+/**
+ * @brief encrypt / decrypt uplink payload in place (XOR with keystream), single-bit uplinks are not encrypted
+ * @param uplink uplink whose payload to encrypt before ::sfx_uplink_encode / to decrypt after ::sfx_uplink_decode
+ * @param keystream keystream block of uplink, see ::sfx_crypto_keystream / ::sfx_keystream_cache_get
+ */
+void sfx_uplink_payload_crypt(sfx_ul_plain *uplink, const uint8_t *keystream)
+{
+	uint8_t i;
+
+	if (uplink->singlebit)
+		return;
+
+	for (i = 0; i < uplink->payloadlen && i < SFX_UL_MAX_PAYLOADLEN; ++i)
+		uplink->payload[i] ^= keystream[i];
+}
+
+/**
+ * @brief encrypt / decrypt downlink payload in place (XOR with keystream)
+ * @param downlink downlink whose payload to encrypt before ::sfx_downlink_encode / to decrypt after ::sfx_downlink_decode
+ * @param keystream keystream block of downlink, see ::sfx_crypto_keystream / ::sfx_keystream_cache_get
+ */
+void sfx_downlink_payload_crypt(sfx_dl_plain *downlink, const uint8_t *keystream)
+{
+	uint8_t i;
+
+	for (i = 0; i < SFX_DL_PAYLOADLEN; ++i)
+		downlink->payload[i] ^= keystream[i];
+}
+
+/**
+ * @brief initialize keystream cache and precompute keystream blocks for frame counters [first, first + capacity)
+ * @param cache cache to initialize
+ * @param common device ID and NAK of Sigfox object
+ * @param downlink true for downlink keystream, false for uplink keystream
+ * @param first frame counter of first block in window, e.g. SFX_CRYPTO_COUNTER(rollover, next seqnum)
+ * @param blocks caller-provided memory for `capacity` keystream blocks
+ * @param capacity number of blocks in window, must be a power of two and at most ::SFX_KEYSTREAM_MAX_WINDOW
+ * @return false if capacity is invalid
+ */
+bool sfx_keystream_cache_init(sfx_keystream_cache *cache, const sfx_commoninfo *common, bool downlink, uint32_t first, uint8_t (*blocks)[SFX_KEYSTREAM_LEN], uint16_t capacity)
+{
+	uint32_t i;
+
+	if (capacity == 0 || capacity > SFX_KEYSTREAM_MAX_WINDOW || (capacity & (capacity - 1)) != 0)
+		return false;
+
+	sfx_crypto_derive_key(common, cache->kenc);
+	cache->devid = common->devid;
+	cache->downlink = downlink;
+	cache->first = first;
+	cache->mask = capacity - 1;
+	cache->blocks = blocks;
+
+	for (i = 0; i < capacity; ++i)
+		sfx_crypto_keystream(cache->kenc, cache->devid, first + i, downlink, blocks[(first + i) & cache->mask]);
+
+	return true;
+}
+
+/**
+ * @brief slide window of keystream cache, only blocks for counters that were not in the window before are computed
+ * @param cache keystream cache
+ * @param first new frame counter of first block in window, e.g. counter of last used frame + 1
+ * @return number of computed keystream blocks (AES operations)
+ */
+uint16_t sfx_keystream_cache_advance(sfx_keystream_cache *cache, uint32_t first)
+{
+	uint32_t capacity = (uint32_t)cache->mask + 1;
+	uint32_t i, computed = 0;
+
+	for (i = 0; i < capacity; ++i) {
+		uint32_t counter = first + i;
+
+		if (counter - cache->first < capacity)
+			continue;
+
+		sfx_crypto_keystream(cache->kenc, cache->devid, counter, cache->downlink, cache->blocks[counter & cache->mask]);
+		computed++;
+	}
+
+	cache->first = first;
+
+	return computed;
+}
+
+/**
+ * @brief get cached keystream block for given frame counter
+ * @param cache keystream cache
+ * @param counter 32-bit frame counter
+ * @return keystream block, NULL if counter is outside of window
+ */
+const uint8_t *sfx_keystream_cache_get(const sfx_keystream_cache *cache, uint32_t counter)
+{
+	if (counter - cache->first > cache->mask)
+		return NULL;
+
+	return cache->blocks[counter & cache->mask];
+}
+
+/**
+ * @brief get cached keystream block for received 12-bit sequence number, e.g. for decrypting on a server
+ * @param cache keystream cache
+ * @param seqnum 12-bit sequence number of received frame
+ * @param counter output, 32-bit frame counter of frame, may be NULL
+ * @return keystream block, NULL if no counter in window matches sequence number
+ */
+const uint8_t *sfx_keystream_cache_lookup(const sfx_keystream_cache *cache, uint16_t seqnum, uint32_t *counter)
+{
+	uint32_t match = cache->first + ((seqnum - cache->first) & 0xfff);
+
+	if (counter)
+		*counter = match;
+
+	return sfx_keystream_cache_get(cache, match);
+}
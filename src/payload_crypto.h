@@ -0,0 +1,62 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "common.h"
+#include "uplink.h"
+#include "downlink.h"
+
+#ifndef _PAYLOAD_CRYPTO_H
+#define _PAYLOAD_CRYPTO_H
+
+/*
+ * Payload encryption: AES-128 in counter mode with an encryption key derived from the NAK
+ * One keystream block per frame, indexed by device ID, direction and 32-bit frame counter (sequence number
+ * including rollover), so that encryption and decryption of a payload is a plain XOR once the block is known.
+ * Payloads are encrypted before encoding and decrypted after decoding, CRC and MAC cover the encrypted payload.
+ */
+
+/// length of keystream block per frame in bytes, uplink payloads use the first 12, downlink payloads the first 8 bytes
+#define SFX_KEYSTREAM_LEN 16
+
+/// maximum capacity of ::sfx_keystream_cache, so that 12-bit sequence numbers in the window are unique
+#define SFX_KEYSTREAM_MAX_WINDOW 4096
+
+/// 32-bit frame counter from rollover counter (number of sequence number wraparounds) and 12-bit sequence number
+#define SFX_CRYPTO_COUNTER(rollover, seqnum) (((uint32_t)(rollover) << 12) | ((seqnum) & 0xfff))
+
+/**
+ * @brief keystream blocks for a window of upcoming frame counters of a single device and direction, see ::sfx_keystream_cache_init
+ */
+typedef struct _s_sfx_keystream_cache {
+	/// encryption key derived from NAK, see ::sfx_crypto_derive_key
+	uint8_t kenc[16];
+
+	/// device ID of Sigfox object
+	uint32_t devid;
+
+	/// indicates whether keystream is for downlink (true) or uplink (false) payloads
+	bool downlink;
+
+	/// frame counter of first block in window
+	uint32_t first;
+
+	/// capacity - 1
+	uint16_t mask;
+
+	/// caller-provided block memory, block for counter `c` is stored at index `c & mask`
+	uint8_t (*blocks)[SFX_KEYSTREAM_LEN];
+} sfx_keystream_cache;
+
+void sfx_crypto_derive_key(const sfx_commoninfo *common, uint8_t *kenc);
+void sfx_crypto_keystream(const uint8_t *kenc, uint32_t devid, uint32_t counter, bool downlink, uint8_t *keystream);
+uint32_t sfx_crypto_counter_resolve(uint32_t reference, uint16_t seqnum);
+
+void sfx_uplink_payload_crypt(sfx_ul_plain *uplink, const uint8_t *keystream);
+void sfx_downlink_payload_crypt(sfx_dl_plain *downlink, const uint8_t *keystream);
+
+bool sfx_keystream_cache_init(sfx_keystream_cache *cache, const sfx_commoninfo *common, bool downlink, uint32_t first, uint8_t (*blocks)[SFX_KEYSTREAM_LEN], uint16_t capacity);
+uint16_t sfx_keystream_cache_advance(sfx_keystream_cache *cache, uint32_t first);
+const uint8_t *sfx_keystream_cache_get(const sfx_keystream_cache *cache, uint32_t counter);
+const uint8_t *sfx_keystream_cache_lookup(const sfx_keystream_cache *cache, uint16_t seqnum, uint32_t *counter);
+
+#endif
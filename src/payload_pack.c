@@ -0,0 +1,238 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "payload_pack.h"
+#include "uplink_class.h"
+#include "uplink.h"
+
+/*
+ * The payload is handled as a sequence of big-endian 64-bit words, so that every field is extracted / inserted with
+ * shifts of at most two words (a field is at most 32 bits wide).
+ */
+
+/// number of 64-bit words of the maximum payload
+#define SFX_PAYLOAD_WORDS ((SFX_PAYLOAD_MAX_BITS + 63) / 64)
+
+/**
+ * @brief load payload into zero-padded words, `payloadlen` is bounded by ::SFX_UL_MAX_PAYLOADLEN
+ */
+static void sfx_payload_words_load(uint64_t *words, const uint8_t *payload, uint8_t payloadlen)
+{
+	uint8_t i;
+
+	if (payloadlen > SFX_UL_MAX_PAYLOADLEN)
+		payloadlen = SFX_UL_MAX_PAYLOADLEN;
+
+	memset(words, 0, SFX_PAYLOAD_WORDS * sizeof(*words));
+	for (i = 0; i < payloadlen; ++i)
+		words[i / 8] |= (uint64_t)payload[i] << (56 - 8 * (i % 8));
+}
+
+/**
+ * @brief store words into payload, `payloadlen` is bounded by ::SFX_UL_MAX_PAYLOADLEN
+ */
+static void sfx_payload_words_store(const uint64_t *words, uint8_t *payload, uint8_t payloadlen)
+{
+	uint8_t i;
+
+	// schemas never exceed it, but the compiler can not know that (-Wstringop-overflow)
+	if (payloadlen > SFX_UL_MAX_PAYLOADLEN)
+		payloadlen = SFX_UL_MAX_PAYLOADLEN;
+
+	for (i = 0; i < payloadlen; ++i)
+		payload[i] = words[i / 8] >> (56 - 8 * (i % 8));
+}
+
+/**
+ * @brief extract `bits` bits starting at bit `position` (MSB of first word is bit 0)
+ */
+static uint32_t sfx_payload_words_get(const uint64_t *words, uint8_t position, uint8_t bits)
+{
+	uint8_t shift = position % 64;
+	uint64_t value = words[position / 64] << shift;
+
+	if (shift + bits > 64)
+		value |= words[position / 64 + 1] >> (64 - shift);
+
+	return value >> (64 - bits);
+}
+
+/**
+ * @brief insert `bits` bits starting at bit `position` into zero-initialized words
+ */
+static void sfx_payload_words_set(uint64_t *words, uint8_t position, uint8_t bits, uint32_t value)
+{
+	uint8_t shift = position % 64;
+	uint64_t aligned = (uint64_t)value << (64 - bits);
+
+	words[position / 64] |= aligned >> shift;
+
+	if (shift + bits > 64)
+		words[position / 64 + 1] |= aligned << (64 - shift);
+}
+
+/**
+ * @brief divide by quantization step and round to nearest integer, halves away from zero
+ */
+static int64_t sfx_payload_quantize(int64_t value, uint32_t scale)
+{
+	if (value >= 0)
+		return (value + scale / 2) / scale;
+	else
+		return -((-value + scale / 2) / scale);
+}
+
+/**
+ * @brief clamp reconstructed value to the range of `int32_t`; delta fields can step beyond it, pack and unpack both
+ * clamp, so that the values of following delta fields agree
+ */
+static int64_t sfx_payload_clamp(int64_t value)
+{
+	if (value > INT32_MAX)
+		return INT32_MAX;
+	if (value < INT32_MIN)
+		return INT32_MIN;
+	return value;
+}
+
+/**
+ * @brief initialize payload schema: check fields and determine payload length and frame class
+ * @param schema schema to initialize
+ * @param fields fields in packing order, must stay valid as long as the schema is used
+ * @param count number of fields
+ * @return ::SFX_PACK_ERR_SCHEMA if there are no fields, the total number of bits exceeds ::SFX_PAYLOAD_MAX_BITS or a
+ * field is invalid (width, encoding, scale, or values of a linear field that exceed the range of `int32_t`)
+ */
+sfx_pack_err sfx_payload_schema_init(sfx_payload_schema *schema, const sfx_payload_field *fields, uint8_t count)
+{
+	uint16_t bits = 0;
+	uint8_t i;
+
+	if (count == 0)
+		return SFX_PACK_ERR_SCHEMA;
+
+	for (i = 0; i < count; ++i) {
+		const sfx_payload_field *field = &fields[i];
+
+		if (field->bits == 0 || field->bits > SFX_PAYLOAD_FIELD_MAX_BITS || field->scale == 0)
+			return SFX_PACK_ERR_SCHEMA;
+
+		if (field->encoding == SFX_PAYLOAD_LINEAR) {
+			// largest value offset + (2^bits - 1) * scale must be representable
+			uint64_t maxcode = (1ULL << field->bits) - 1;
+			if (field->scale > ((int64_t)INT32_MAX - field->offset) / maxcode)
+				return SFX_PACK_ERR_SCHEMA;
+		} else if (field->encoding != SFX_PAYLOAD_DELTA) {
+			return SFX_PACK_ERR_SCHEMA;
+		}
+
+		bits += field->bits;
+	}
+
+	if (bits > SFX_PAYLOAD_MAX_BITS)
+		return SFX_PACK_ERR_SCHEMA;
+
+	schema->fields = fields;
+	schema->count = count;
+	schema->bits = bits;
+	schema->singlebit = bits == 1;
+	schema->payloadlen = schema->singlebit ? 0 : (bits + 7) / 8;
+
+	sfx_ul_plain uplink;
+	uplink.payloadlen = schema->payloadlen;
+	uplink.singlebit = schema->singlebit;
+	schema->frameclass = sfx_uplink_frameclass(&uplink);
+
+	return SFX_PACK_ERR_NONE;
+}
+
+/**
+ * @brief pack field values into uplink payload, sets payload, payload length and single-bit flag of uplink
+ * @param schema payload schema
+ * @param values one value per field of schema, rounded to the quantization step of the field
+ * @param uplink output, uplink to be encoded, downlink request and replica flags are not modified
+ * @return ::SFX_PACK_ERR_RANGE if a value of a field without saturation is not representable, uplink is not modified then
+ */
+sfx_pack_err sfx_payload_pack(const sfx_payload_schema *schema, const int32_t *values, sfx_ul_plain *uplink)
+{
+	uint64_t words[SFX_PAYLOAD_WORDS] = {0};
+	int64_t previous = 0;
+	uint8_t position = 0;
+	uint8_t i;
+
+	for (i = 0; i < schema->count; ++i) {
+		const sfx_payload_field *field = &schema->fields[i];
+		int64_t base = field->encoding == SFX_PAYLOAD_DELTA ? previous : field->offset;
+		int64_t code = sfx_payload_quantize((int64_t)values[i] - base, field->scale);
+		int64_t min = 0, max = (1LL << field->bits) - 1;
+
+		if (field->encoding == SFX_PAYLOAD_DELTA) {
+			min = -(1LL << (field->bits - 1));
+			max = (1LL << (field->bits - 1)) - 1;
+		}
+
+		if (code < min || code > max) {
+			if (!field->saturate)
+				return SFX_PACK_ERR_RANGE;
+			code = code < min ? min : max;
+		}
+
+		// value as reconstructed by the unpacker, base of a following delta field
+		previous = sfx_payload_clamp(base + code * field->scale);
+
+		sfx_payload_words_set(words, position, field->bits, (uint64_t)code & ((1ULL << field->bits) - 1));
+		position += field->bits;
+	}
+
+	memset(uplink->payload, 0, SFX_UL_MAX_PAYLOADLEN);
+	uplink->payloadlen = schema->payloadlen;
+	uplink->singlebit = schema->singlebit;
+
+	if (schema->singlebit)
+		uplink->payload[0] = words[0] >> 63;
+	else
+		sfx_payload_words_store(words, uplink->payload, schema->payloadlen);
+
+	return SFX_PACK_ERR_NONE;
+}
+
+/**
+ * @brief unpack field values from uplink payload, e.g. right after ::sfx_uplink_decode
+ * @param schema payload schema
+ * @param uplink decoded uplink
+ * @param values output, one value per field of schema
+ * @return ::SFX_PACK_ERR_LENGTH if payload length or single-bit flag of uplink does not match the schema
+ */
+sfx_pack_err sfx_payload_unpack(const sfx_payload_schema *schema, const sfx_ul_plain *uplink, int32_t *values)
+{
+	uint64_t words[SFX_PAYLOAD_WORDS];
+	int64_t previous = 0;
+	uint8_t position = 0;
+	uint8_t i;
+
+	if (uplink->singlebit != schema->singlebit || uplink->payloadlen != schema->payloadlen)
+		return SFX_PACK_ERR_LENGTH;
+
+	sfx_payload_words_load(words, uplink->payload, schema->payloadlen);
+	if (schema->singlebit)
+		words[0] = uplink->payload[0] ? 1ULL << 63 : 0;
+
+	for (i = 0; i < schema->count; ++i) {
+		const sfx_payload_field *field = &schema->fields[i];
+		uint32_t code = sfx_payload_words_get(words, position, field->bits);
+		position += field->bits;
+
+		if (field->encoding == SFX_PAYLOAD_DELTA) {
+			// sign extension
+			int64_t sign = 1LL << (field->bits - 1);
+			previous = sfx_payload_clamp(previous + (((int64_t)code ^ sign) - sign) * field->scale);
+		} else {
+			previous = field->offset + (int64_t)code * field->scale;
+		}
+
+		values[i] = previous;
+	}
+
+	return SFX_PACK_ERR_NONE;
+}
@@ -0,0 +1,106 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "uplink.h"
+
+#ifndef _PAYLOAD_PACK_H
+#define _PAYLOAD_PACK_H
+
+/*
+ * Payload packing: a schema of bit-width fields, packed MSB first in schema order into the fewest payload bytes, so
+ * that the uplink is sent in the smallest frame class that fits (see ::sfx_uplink_frameclass). Frame classes carry
+ * 1 bit (single-bit frame), 1 byte, 2 - 4 bytes, 5 - 8 bytes or 9 - 12 bytes of payload, so schemas with at most 1,
+ * 8, 32, 64 or 96 bits use the same airtime. Bytes left over in a frame class lengthen the MAC instead.
+ */
+
+/// maximum total number of bits of a schema
+#define SFX_PAYLOAD_MAX_BITS (SFX_UL_MAX_PAYLOADLEN * 8)
+
+/// maximum width of a field in bits; values are `int32_t`, so that linear fields are limited to 31 bits unless their
+/// offset is negative (see sfx_payload_field::offset), values reconstructed from delta fields are clamped to the
+/// range of `int32_t` by both ::sfx_payload_pack and ::sfx_payload_unpack
+#define SFX_PAYLOAD_FIELD_MAX_BITS 32
+
+/// field encoding: value is stored as unsigned integer (value - offset) / scale
+#define SFX_PAYLOAD_LINEAR 0
+
+/// field encoding: value is stored as signed (two's complement) integer (value - previous) / scale, where previous is
+/// the value of the preceding field as reconstructed by the unpacker, so that rounding errors do not accumulate
+#define SFX_PAYLOAD_DELTA 1
+
+/**
+ * @brief field of a payload schema, see SFX_PAYLOAD_UINT, SFX_PAYLOAD_SCALED and SFX_PAYLOAD_DELTA_SCALED
+ */
+typedef struct _s_sfx_payload_field {
+	/// width of field in bits, 1 to ::SFX_PAYLOAD_FIELD_MAX_BITS
+	uint8_t bits;
+
+	/// encoding of field, SFX_PAYLOAD_LINEAR or SFX_PAYLOAD_DELTA
+	uint8_t encoding;
+
+	/// indicates whether values outside of the representable range are clamped (true) or rejected (false)
+	bool saturate;
+
+	/// smallest representable value of linear fields, ignored for delta fields; the largest value
+	/// offset + (2^bits - 1) * scale must not exceed INT32_MAX, e.g. a full 32-bit field needs offset INT32_MIN
+	int32_t offset;
+
+	/// quantization step, at least 1, values are rounded to the nearest multiple
+	uint32_t scale;
+} sfx_payload_field;
+
+/// unsigned integer field of given width (at most 31 bits, values are `int32_t`), values outside of the range are rejected
+#define SFX_PAYLOAD_UINT(bits) {(bits), SFX_PAYLOAD_LINEAR, false, 0, 1}
+
+/// field of given width for values from `min` in steps of `step`, values outside of the range are clamped, e.g.
+/// temperature in units of 0.1 degC from -40 degC: SFX_PAYLOAD_SCALED(10, -400, 1) up to 62.3 degC
+#define SFX_PAYLOAD_SCALED(bits, min, step) {(bits), SFX_PAYLOAD_LINEAR, true, (min), (step)}
+
+/// difference to the preceding field in steps of `step`, e.g. for a series of readings, differences are clamped
+#define SFX_PAYLOAD_DELTA_SCALED(bits, step) {(bits), SFX_PAYLOAD_DELTA, true, 0, (step)}
+
+/**
+ * @brief payload schema, see ::sfx_payload_schema_init
+ */
+typedef struct _s_sfx_payload_schema {
+	/// fields in packing order
+	const sfx_payload_field *fields;
+
+	/// number of fields
+	uint8_t count;
+
+	/// total number of bits of all fields
+	uint8_t bits;
+
+	/// length of packed payload in bytes, 0 for single-bit frames, see ::sfx_ul_plain
+	uint8_t payloadlen;
+
+	/// indicates whether payloads are sent as single-bit frames (schema of a single 1-bit field)
+	bool singlebit;
+
+	/// frame class of packed payloads, see ::sfx_uplink_frameclass
+	uint8_t frameclass;
+} sfx_payload_schema;
+
+/**
+ * @brief set of errors that can occur during payload packing / unpacking
+ */
+typedef enum _s_sfx_pack_err {
+	/// no error occured, success
+	SFX_PACK_ERR_NONE = 0,
+
+	/// schema is empty, longer than ::SFX_PAYLOAD_MAX_BITS or contains an invalid field
+	SFX_PACK_ERR_SCHEMA,
+
+	/// value of a field without saturation is outside of the representable range
+	SFX_PACK_ERR_RANGE,
+
+	/// payload length / single-bit flag of uplink does not match schema
+	SFX_PACK_ERR_LENGTH
+} sfx_pack_err;
+
+sfx_pack_err sfx_payload_schema_init(sfx_payload_schema *schema, const sfx_payload_field *fields, uint8_t count);
+sfx_pack_err sfx_payload_pack(const sfx_payload_schema *schema, const int32_t *values, sfx_ul_plain *uplink);
+sfx_pack_err sfx_payload_unpack(const sfx_payload_schema *schema, const sfx_ul_plain *uplink, int32_t *values);
+
+#endif
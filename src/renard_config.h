@@ -0,0 +1,34 @@
+#ifndef _RENARD_CONFIG_H
+#define _RENARD_CONFIG_H
+
+/*
+ * Build configuration
+ *
+ * RENARD_MINIMAL: Footprint-optimized profile for small microcontrollers, selected by `make PROFILE=minimal`.
+ * Enables all of the following options. They can also be defined individually (e.g. in CFLAGS).
+ *
+ * RENARD_AES_ENCRYPT_ONLY: librenard only ever encrypts, drop AES decryption path and inverse S-box.
+ * RENARD_NO_CLASS_INLINE: Share one copy of the frame class specialized encoder / decoder code between all
+ *   frame classes instead of expanding it for every class (smaller, but with runtime length arithmetic).
+ * RENARD_NO_COUNTING_BACKEND: Drop the call counting stand-in backend (see backend.h).
+ *
+ * RENARD_CONSTANT_TIME: Selected by `make CONSTANT_TIME=1`, not part of any profile. Removes the data-dependent
+ *   timing of selected decoding steps, mainly to keep the NAK out of timing side channels: frame type classification
+ *   without data-dependent branches, uplink MAC is computed even if the CRC is invalid, and AES S-box lookups are
+ *   computed arithmetically instead of from tables (slower). MAC comparisons are always constant-time (see
+ *   constant_time.h). Decoding as a whole still depends on frame contents: the CRC branches on every bit, downlink
+ *   error correction depends on the received bits, and uplinks whose length does not match the frame type are
+ *   rejected early.
+ *
+ * RENARD_THUMB_KERNELS: Defined by the Makefile if ARCHFLAGS selects a Cortex-M CPU (`-mcpu=cortex-m0plus`,
+ *   `-mcpu=cortex-m4`, ...) or if `ARCH_KERNELS=thumb` is given. The software backend then uses the assembly AES and
+ *   CRC-16 kernels from src/thumb/ and uplink encoding the assembly convolutional coder (see thumb_kernels.h).
+ *   The assembly AES kernel uses an S-box table and is not used with RENARD_CONSTANT_TIME.
+ */
+#ifdef RENARD_MINIMAL
+#define RENARD_AES_ENCRYPT_ONLY
+#define RENARD_NO_CLASS_INLINE
+#define RENARD_NO_COUNTING_BACKEND
+#endif
+
+#endif
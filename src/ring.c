@@ -0,0 +1,315 @@
+#include <string.h>
+
+#include "ring.h"
+
+// atomic builtins are only available with GCC / clang
+#if defined(__GNUC__)
+
+/*
+ * Single-producer / single-consumer ring
+ * `tail` is only written by the producer, `head` only by the consumer. Both sides cache the other
+ * side's index and only reload it (with acquire semantics) if the cached value indicates a full /
+ * empty ring, so that the shared cache lines are touched as rarely as possible.
+ */
+
+/**
+ * @brief initialize single-producer / single-consumer ring
+ * @param ring ring to initialize
+ * @param buffer slot memory, ::RENARD_SPSC_BUFSIZE bytes
+ * @param capacity number of slots, must be a power of two
+ * @param slot_size size of a single slot in bytes, e.g. `sizeof(sfx_frame_record)`
+ * @return false if capacity is not a power of two
+ */
+bool renard_spsc_init(renard_spsc_ring *ring, void *buffer, uint32_t capacity, uint32_t slot_size)
+{
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+		return false;
+
+	memset(ring, 0, sizeof(*ring));
+	ring->slots = buffer;
+	ring->mask = capacity - 1;
+	ring->slot_size = slot_size;
+
+	return true;
+}
+
+/**
+ * @brief producer: reserve contiguous free slots to write to in place (zero-copy)
+ * @param ring ring to write to
+ * @param count input: number of slots requested, output: number of contiguous slots reserved (may be less, 0 if ring is full)
+ * @return pointer to first reserved slot, consecutive slots follow directly; make them visible using ::renard_spsc_commit
+ */
+void *renard_spsc_reserve(renard_spsc_ring *ring, uint32_t *count)
+{
+	uint32_t capacity = ring->mask + 1;
+	uint32_t tail = ring->tail;
+
+	if (capacity - (tail - ring->head_cache) < *count)
+		ring->head_cache = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+	uint32_t free = capacity - (tail - ring->head_cache);
+	uint32_t contiguous = capacity - (tail & ring->mask);
+
+	if (*count > free)
+		*count = free;
+	if (*count > contiguous)
+		*count = contiguous;
+
+	return ring->slots + (tail & ring->mask) * ring->slot_size;
+}
+
+/**
+ * @brief producer: make written slots visible to consumer
+ * @param ring ring to write to
+ * @param count number of slots to commit, at most the number of slots reserved by ::renard_spsc_reserve
+ */
+void renard_spsc_commit(renard_spsc_ring *ring, uint32_t count)
+{
+	__atomic_store_n(&ring->tail, ring->tail + count, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief consumer: get contiguous filled slots to read in place (zero-copy)
+ * @param ring ring to read from
+ * @param count input: maximum number of slots, output: number of contiguous filled slots (0 if ring is empty)
+ * @return pointer to first filled slot; hand slots back to producer using ::renard_spsc_release
+ */
+void *renard_spsc_peek(renard_spsc_ring *ring, uint32_t *count)
+{
+	uint32_t capacity = ring->mask + 1;
+	uint32_t head = ring->head;
+
+	if (ring->tail_cache - head < *count)
+		ring->tail_cache = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+	uint32_t filled = ring->tail_cache - head;
+	uint32_t contiguous = capacity - (head & ring->mask);
+
+	if (*count > filled)
+		*count = filled;
+	if (*count > contiguous)
+		*count = contiguous;
+
+	return ring->slots + (head & ring->mask) * ring->slot_size;
+}
+
+/**
+ * @brief consumer: hand read slots back to producer
+ * @param ring ring to read from
+ * @param count number of slots to release, at most the number of slots returned by ::renard_spsc_peek
+ */
+void renard_spsc_release(renard_spsc_ring *ring, uint32_t count)
+{
+	__atomic_store_n(&ring->head, ring->head + count, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief producer: copy records into ring (batch push)
+ * @param ring ring to write to
+ * @param items array of `count` records of ring's slot size
+ * @param count number of records to push
+ * @return number of records pushed, less than `count` if ring is full
+ */
+uint32_t renard_spsc_push(renard_spsc_ring *ring, const void *items, uint32_t count)
+{
+	uint32_t pushed = 0;
+
+	// at most two contiguous parts because of wrap-around
+	for (uint8_t part = 0; part < 2 && pushed < count; ++part) {
+		uint32_t n = count - pushed;
+		void *slots = renard_spsc_reserve(ring, &n);
+		if (n == 0)
+			break;
+
+		memcpy(slots, (const uint8_t *)items + pushed * ring->slot_size, n * ring->slot_size);
+		renard_spsc_commit(ring, n);
+		pushed += n;
+	}
+
+	return pushed;
+}
+
+/**
+ * @brief consumer: copy records out of ring (batch pop)
+ * @param ring ring to read from
+ * @param items output, space for `count` records of ring's slot size
+ * @param count maximum number of records to pop
+ * @return number of records popped, less than `count` if ring ran empty
+ */
+uint32_t renard_spsc_pop(renard_spsc_ring *ring, void *items, uint32_t count)
+{
+	uint32_t popped = 0;
+
+	for (uint8_t part = 0; part < 2 && popped < count; ++part) {
+		uint32_t n = count - popped;
+		void *slots = renard_spsc_peek(ring, &n);
+		if (n == 0)
+			break;
+
+		memcpy((uint8_t *)items + popped * ring->slot_size, slots, n * ring->slot_size);
+		renard_spsc_release(ring, n);
+		popped += n;
+	}
+
+	return popped;
+}
+
+/*
+ * Multi-producer / multi-consumer ring
+ * Every slot carries a sequence number: A slot at position `pos` is free for the producer that claims
+ * `pos` if its sequence number equals `pos`, and filled for the consumer that claims `pos` if it
+ * equals `pos + 1`. Producers / consumers claim positions by compare-and-swap.
+ */
+
+/**
+ * @brief initialize multi-producer / multi-consumer ring
+ * @param ring ring to initialize
+ * @param buffer slot memory including sequence numbers, ::RENARD_MPMC_BUFSIZE bytes, 4-byte aligned
+ * @param capacity number of slots, must be a power of two
+ * @param slot_size size of a single slot in bytes, e.g. `sizeof(sfx_frame_record)`
+ * @return false if capacity is not a power of two
+ */
+bool renard_mpmc_init(renard_mpmc_ring *ring, void *buffer, uint32_t capacity, uint32_t slot_size)
+{
+	if (capacity == 0 || (capacity & (capacity - 1)) != 0)
+		return false;
+
+	memset(ring, 0, sizeof(*ring));
+	ring->sequence = buffer;
+	ring->slots = (uint8_t *)buffer + capacity * sizeof(uint32_t);
+	ring->mask = capacity - 1;
+	ring->slot_size = slot_size;
+
+	for (uint32_t i = 0; i < capacity; ++i)
+		ring->sequence[i] = i;
+
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	return true;
+}
+
+/**
+ * @brief producer: reserve a free slot to write to in place (zero-copy)
+ * @param ring ring to write to
+ * @param ticket output, identifies reserved slot, pass to ::renard_mpmc_commit
+ * @return pointer to reserved slot, NULL if ring is full
+ */
+void *renard_mpmc_reserve(renard_mpmc_ring *ring, uint32_t *ticket)
+{
+	uint32_t pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+
+	for (;;) {
+		uint32_t seq = __atomic_load_n(&ring->sequence[pos & ring->mask], __ATOMIC_ACQUIRE);
+		int32_t diff = (int32_t)(seq - pos);
+
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&ring->enqueue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			return NULL;
+		} else {
+			pos = __atomic_load_n(&ring->enqueue_pos, __ATOMIC_RELAXED);
+		}
+	}
+
+	*ticket = pos;
+	return ring->slots + (pos & ring->mask) * ring->slot_size;
+}
+
+/**
+ * @brief producer: make written slot visible to consumers
+ * @param ring ring to write to
+ * @param ticket ticket returned by ::renard_mpmc_reserve
+ */
+void renard_mpmc_commit(renard_mpmc_ring *ring, uint32_t ticket)
+{
+	__atomic_store_n(&ring->sequence[ticket & ring->mask], ticket + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief consumer: acquire a filled slot to read in place (zero-copy)
+ * @param ring ring to read from
+ * @param ticket output, identifies acquired slot, pass to ::renard_mpmc_release
+ * @return pointer to acquired slot, NULL if ring is empty
+ */
+void *renard_mpmc_acquire(renard_mpmc_ring *ring, uint32_t *ticket)
+{
+	uint32_t pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+
+	for (;;) {
+		uint32_t seq = __atomic_load_n(&ring->sequence[pos & ring->mask], __ATOMIC_ACQUIRE);
+		int32_t diff = (int32_t)(seq - (pos + 1));
+
+		if (diff == 0) {
+			if (__atomic_compare_exchange_n(&ring->dequeue_pos, &pos, pos + 1, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				break;
+		} else if (diff < 0) {
+			return NULL;
+		} else {
+			pos = __atomic_load_n(&ring->dequeue_pos, __ATOMIC_RELAXED);
+		}
+	}
+
+	*ticket = pos;
+	return ring->slots + (pos & ring->mask) * ring->slot_size;
+}
+
+/**
+ * @brief consumer: hand read slot back to producers
+ * @param ring ring to read from
+ * @param ticket ticket returned by ::renard_mpmc_acquire
+ */
+void renard_mpmc_release(renard_mpmc_ring *ring, uint32_t ticket)
+{
+	__atomic_store_n(&ring->sequence[ticket & ring->mask], ticket + ring->mask + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief producer: copy records into ring (batch push)
+ * @param ring ring to write to
+ * @param items array of `count` records of ring's slot size
+ * @param count number of records to push
+ * @return number of records pushed, less than `count` if ring is full
+ */
+uint32_t renard_mpmc_push(renard_mpmc_ring *ring, const void *items, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; ++i) {
+		uint32_t ticket;
+		void *slot = renard_mpmc_reserve(ring, &ticket);
+		if (!slot)
+			break;
+
+		memcpy(slot, (const uint8_t *)items + i * ring->slot_size, ring->slot_size);
+		renard_mpmc_commit(ring, ticket);
+	}
+
+	return i;
+}
+
+/**
+ * @brief consumer: copy records out of ring (batch pop)
+ * @param ring ring to read from
+ * @param items output, space for `count` records of ring's slot size
+ * @param count maximum number of records to pop
+ * @return number of records popped, less than `count` if ring ran empty
+ */
+uint32_t renard_mpmc_pop(renard_mpmc_ring *ring, void *items, uint32_t count)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; ++i) {
+		uint32_t ticket;
+		void *slot = renard_mpmc_acquire(ring, &ticket);
+		if (!slot)
+			break;
+
+		memcpy((uint8_t *)items + i * ring->slot_size, slot, ring->slot_size);
+		renard_mpmc_release(ring, ticket);
+	}
+
+	return i;
+}
+
+#endif
@@ -0,0 +1,116 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "uplink.h"
+#include "downlink.h"
+
+#ifndef _RING_H
+#define _RING_H
+
+/*
+ * Lock-free rings of fixed-size records for passing frames between threads, e.g. from a demodulator
+ * to a decoder. Memory for the slots is provided by the caller, the capacity must be a power of two.
+ * Requires GCC / clang atomic builtins and a target with native atomic operations.
+ */
+
+/// assumed size of a cache line, producer and consumer state are kept on separate cache lines
+#define RENARD_CACHELINE 64
+
+#if defined(__GNUC__)
+#define RENARD_CACHELINE_ALIGNED __attribute__((aligned(RENARD_CACHELINE)))
+#else
+#define RENARD_CACHELINE_ALIGNED
+#endif
+
+/// size of buffer required for a ::renard_spsc_ring with given capacity and slot size, in bytes
+#define RENARD_SPSC_BUFSIZE(capacity, slot_size) ((capacity) * (slot_size))
+
+/// size of buffer required for a ::renard_mpmc_ring with given capacity and slot size, in bytes
+#define RENARD_MPMC_BUFSIZE(capacity, slot_size) ((capacity) * (sizeof(uint32_t) + (slot_size)))
+
+/**
+ * @brief frame record that can be used as ring slot, holds either an uplink or a downlink frame
+ */
+typedef struct _s_sfx_frame_record {
+	/// reception timestamp, e.g. in microseconds
+	uint64_t timestamp;
+
+	/// identifier of receiving gateway / base station
+	uint32_t gateway;
+
+	/// indicates whether record contains downlink (true) or uplink (false) frame
+	bool is_downlink;
+
+	/// raw frame
+	union {
+		sfx_ul_encoded uplink;
+		sfx_dl_encoded downlink;
+	} frame;
+} sfx_frame_record;
+
+/**
+ * @brief single-producer / single-consumer ring, see ::renard_spsc_init
+ */
+typedef struct _s_renard_spsc_ring {
+	/// producer: next slot to write, number of slots ever committed
+	uint32_t tail RENARD_CACHELINE_ALIGNED;
+
+	/// producer: last known value of `head`
+	uint32_t head_cache;
+
+	/// consumer: next slot to read, number of slots ever released
+	uint32_t head RENARD_CACHELINE_ALIGNED;
+
+	/// consumer: last known value of `tail`
+	uint32_t tail_cache;
+
+	/// slot memory, capacity * slot_size bytes
+	uint8_t *slots RENARD_CACHELINE_ALIGNED;
+
+	/// capacity - 1
+	uint32_t mask;
+
+	/// size of a single slot in bytes
+	uint32_t slot_size;
+} renard_spsc_ring;
+
+/**
+ * @brief multi-producer / multi-consumer ring (bounded queue with per-slot sequence numbers), see ::renard_mpmc_init
+ */
+typedef struct _s_renard_mpmc_ring {
+	/// producers: position of next slot to reserve
+	uint32_t enqueue_pos RENARD_CACHELINE_ALIGNED;
+
+	/// consumers: position of next slot to acquire
+	uint32_t dequeue_pos RENARD_CACHELINE_ALIGNED;
+
+	/// sequence number of every slot, indicates whether it is free or filled
+	uint32_t *sequence RENARD_CACHELINE_ALIGNED;
+
+	/// slot memory, capacity * slot_size bytes
+	uint8_t *slots;
+
+	/// capacity - 1
+	uint32_t mask;
+
+	/// size of a single slot in bytes
+	uint32_t slot_size;
+} renard_mpmc_ring;
+
+bool renard_spsc_init(renard_spsc_ring *ring, void *buffer, uint32_t capacity, uint32_t slot_size);
+void *renard_spsc_reserve(renard_spsc_ring *ring, uint32_t *count);
+void renard_spsc_commit(renard_spsc_ring *ring, uint32_t count);
+void *renard_spsc_peek(renard_spsc_ring *ring, uint32_t *count);
+void renard_spsc_release(renard_spsc_ring *ring, uint32_t count);
+uint32_t renard_spsc_push(renard_spsc_ring *ring, const void *items, uint32_t count);
+uint32_t renard_spsc_pop(renard_spsc_ring *ring, void *items, uint32_t count);
+
+bool renard_mpmc_init(renard_mpmc_ring *ring, void *buffer, uint32_t capacity, uint32_t slot_size);
+void *renard_mpmc_reserve(renard_mpmc_ring *ring, uint32_t *ticket);
+void renard_mpmc_commit(renard_mpmc_ring *ring, uint32_t ticket);
+void *renard_mpmc_acquire(renard_mpmc_ring *ring, uint32_t *ticket);
+void renard_mpmc_release(renard_mpmc_ring *ring, uint32_t ticket);
+uint32_t renard_mpmc_push(renard_mpmc_ring *ring, const void *items, uint32_t count);
+uint32_t renard_mpmc_pop(renard_mpmc_ring *ring, void *items, uint32_t count);
+
+#endif
@@ -1,10 +1,14 @@
 #include <stdint.h>
+#include <string.h>
+
+#include "sigfox_crc.h"
+#include "backend.h"
 
 // Standard CRC-16-CCITT as implemented by the proprietary sigfox stack
 
 #define CRC16_POLYNOMIAL 0x1021
 
-uint16_t renard_crc16(uint8_t const data[], uint8_t length)
+uint16_t renard_crc16_software(uint8_t const data[], uint8_t length)
 {
 	if (length == 0)
 		return 0;
@@ -25,11 +29,33 @@ uint16_t renard_crc16(uint8_t const data[], uint8_t length)
 	return remainder;
 }
 
+/**
+ * @brief update CRC-16 remainder (see ::renard_crc16_software) with a single byte, for incremental computation
+ * Always computed in software, not by the selected backend: backends take complete buffers, a call per received byte
+ * would cost more than the bitwise update itself.
+ * @param remainder remainder after previous bytes, 0 before the first byte
+ * @param byte next input byte
+ * @return updated remainder, equals ::renard_crc16_software of all bytes so far
+ */
+uint16_t renard_crc16_update(uint16_t remainder, uint8_t byte)
+{
+	remainder ^= (byte << 8);
+
+	for (uint8_t bit = 8; bit > 0; --bit) {
+		if (remainder & (1 << 15))
+			remainder = ((remainder << 1) ^ CRC16_POLYNOMIAL);
+		else
+			remainder = (remainder << 1);
+	}
+
+	return remainder;
+}
+
 // Standard CRC-8 8H2F as implemented by the proprietary sigfox stack
 
 #define CRC8_POLYNOMIAL 0x2f
 
-uint8_t renard_crc8(uint8_t const data[], uint8_t length)
+uint8_t renard_crc8_software(uint8_t const data[], uint8_t length)
 {
 	if (length == 0)
 		return 0;
@@ -49,3 +75,142 @@ uint8_t renard_crc8(uint8_t const data[], uint8_t length)
 
 	return remainder;
 }
+
+// Dispatch to selected backend, see backend.h
+
+uint16_t renard_crc16(uint8_t const data[], uint8_t length)
+{
+	return renard_backend_get()->crc16(data, length);
+}
+
+uint8_t renard_crc8(uint8_t const data[], uint8_t length)
+{
+	return renard_backend_get()->crc8(data, length);
+}
+
+/*
+ * Multi-buffer CRC: Computes the CRCs of several equal-length buffers at once, one buffer per SIMD lane.
+ * Uses GCC / clang vector extensions sized to the widest available SIMD unit, so that the same code is
+ * translated to AVX-512BW, AVX2, SSE2 or NEON instructions. Falls back to one buffer at a time otherwise.
+ */
+#if defined(__GNUC__) && (defined(__AVX512BW__) || defined(__AVX2__) || defined(__SSE2__) || defined(__ARM_NEON))
+
+#if defined(__AVX512BW__)
+#define CRC_VECTOR_BYTES 64
+#elif defined(__AVX2__)
+#define CRC_VECTOR_BYTES 32
+#else
+#define CRC_VECTOR_BYTES 16
+#endif
+
+#define CRC16_LANES (CRC_VECTOR_BYTES / 2)
+#define CRC8_LANES CRC_VECTOR_BYTES
+
+typedef uint16_t crc16_vector __attribute__((vector_size(CRC_VECTOR_BYTES)));
+typedef int16_t crc16_vector_signed __attribute__((vector_size(CRC_VECTOR_BYTES)));
+typedef uint8_t crc8_vector __attribute__((vector_size(CRC_VECTOR_BYTES)));
+typedef int8_t crc8_vector_signed __attribute__((vector_size(CRC_VECTOR_BYTES)));
+
+// dummy input for unused lanes
+static const uint8_t crc_zeros[255];
+
+static void renard_crc16_lanes(uint8_t const *const data[], uint8_t length, uint8_t count, uint16_t *crc)
+{
+	uint8_t const *lanedata[CRC16_LANES];
+	for (uint8_t lane = 0; lane < CRC16_LANES; ++lane)
+		lanedata[lane] = lane < count ? data[lane] : crc_zeros;
+
+	crc16_vector remainder = { 0 };
+	for (uint8_t i = 0; i < length; ++i) {
+		uint16_t bytes[CRC16_LANES];
+		crc16_vector input;
+
+		for (uint8_t lane = 0; lane < CRC16_LANES; ++lane)
+			bytes[lane] = lanedata[lane][i];
+		memcpy(&input, bytes, sizeof(input));
+
+		remainder ^= input << 8;
+		for (uint8_t bit = 8; bit > 0; --bit) {
+			// all-ones in lanes with MSB set
+			crc16_vector mask = (crc16_vector)((crc16_vector_signed)remainder >> 15);
+			remainder = (remainder << 1) ^ (mask & CRC16_POLYNOMIAL);
+		}
+	}
+
+	uint16_t out[CRC16_LANES];
+	memcpy(out, &remainder, sizeof(out));
+	memcpy(crc, out, count * sizeof(uint16_t));
+}
+
+static void renard_crc8_lanes(uint8_t const *const data[], uint8_t length, uint8_t count, uint8_t *crc)
+{
+	uint8_t const *lanedata[CRC8_LANES];
+	for (uint8_t lane = 0; lane < CRC8_LANES; ++lane)
+		lanedata[lane] = lane < count ? data[lane] : crc_zeros;
+
+	crc8_vector remainder = { 0 };
+	for (uint8_t i = 0; i < length; ++i) {
+		uint8_t bytes[CRC8_LANES];
+		crc8_vector input;
+
+		for (uint8_t lane = 0; lane < CRC8_LANES; ++lane)
+			bytes[lane] = lanedata[lane][i];
+		memcpy(&input, bytes, sizeof(input));
+
+		remainder ^= input;
+		for (uint8_t bit = 8; bit > 0; --bit) {
+			// all-ones in lanes with MSB set
+			crc8_vector mask = (crc8_vector)((crc8_vector_signed)remainder >> 7);
+			remainder = (remainder << 1) ^ (mask & CRC8_POLYNOMIAL);
+		}
+	}
+
+	uint8_t out[CRC8_LANES];
+	memcpy(out, &remainder, sizeof(out));
+	memcpy(crc, out, count);
+}
+
+#else
+
+#define CRC16_LANES 1
+#define CRC8_LANES 1
+
+static void renard_crc16_lanes(uint8_t const *const data[], uint8_t length, uint8_t count, uint16_t *crc)
+{
+	crc[0] = renard_crc16_software(data[0], length);
+}
+
+static void renard_crc8_lanes(uint8_t const *const data[], uint8_t length, uint8_t count, uint8_t *crc)
+{
+	crc[0] = renard_crc8_software(data[0], length);
+}
+
+#endif
+
+/**
+ * @brief compute CRC-16 (see ::renard_crc16) of many buffers of equal length at once, e.g. all frames of the same frame class
+ * @param data array of `count` pointers to input buffers
+ * @param length length of every input buffer in bytes
+ * @param count number of input buffers
+ * @param crc output, array of `count` CRC values
+ * @attention Always uses the software implementation (SIMD if available), not the selected backend
+ */
+void renard_crc16_multi(uint8_t const *const data[], uint8_t length, uint16_t count, uint16_t *crc)
+{
+	for (uint16_t i = 0; i < count; i += CRC16_LANES)
+		renard_crc16_lanes(&data[i], length, count - i < CRC16_LANES ? count - i : CRC16_LANES, &crc[i]);
+}
+
+/**
+ * @brief compute CRC-8 (see ::renard_crc8) of many buffers of equal length at once, e.g. a batch of downlink frames
+ * @param data array of `count` pointers to input buffers
+ * @param length length of every input buffer in bytes
+ * @param count number of input buffers
+ * @param crc output, array of `count` CRC values
+ * @attention Always uses the software implementation (SIMD if available), not the selected backend
+ */
+void renard_crc8_multi(uint8_t const *const data[], uint8_t length, uint16_t count, uint8_t *crc)
+{
+	for (uint16_t i = 0; i < count; i += CRC8_LANES)
+		renard_crc8_lanes(&data[i], length, count - i < CRC8_LANES ? count - i : CRC8_LANES, &crc[i]);
+}
@@ -5,5 +5,10 @@
 
 uint16_t renard_crc16(uint8_t const data[], uint8_t length);
 uint8_t renard_crc8(uint8_t const data[], uint8_t length);
+uint16_t renard_crc16_software(uint8_t const data[], uint8_t length);
+uint8_t renard_crc8_software(uint8_t const data[], uint8_t length);
+uint16_t renard_crc16_update(uint16_t remainder, uint8_t byte);
+void renard_crc16_multi(uint8_t const *const data[], uint8_t length, uint16_t count, uint16_t *crc);
+void renard_crc8_multi(uint8_t const *const data[], uint8_t length, uint16_t count, uint8_t *crc);
 
 #endif
@@ -1,23 +1,26 @@
 #include <inttypes.h>
 
-#include "ti_aes_128.h"
+#include "backend.h"
 
 /* Source: https://github.com/pycom/pycom-micropython-censis/blob/master/esp32/sigfox/manufacturer_api.c */
 
-int renard_aes_128_cbc_encrypt(uint8_t *encrypted_data, uint8_t *data_to_encrypt, uint8_t data_len, uint8_t *key)
+int renard_aes_128_cbc_encrypt(uint8_t *encrypted_data, const uint8_t *data_to_encrypt, uint8_t data_len, const uint8_t *key)
 {
 	uint8_t i, j, blocks;
-	uint8_t cbc[16] = { 0x00 };
+	const renard_backend *backend = renard_backend_get();
 
+	if (backend->aes_128_cbc_encrypt) {
+		backend->aes_128_cbc_encrypt(encrypted_data, data_to_encrypt, data_len, key);
+		return 0;
+	}
+
+	// chaining in output buffer: every block is XORed with the previous ciphertext block (zero IV) and encrypted in place
 	blocks = data_len / 16;
 	for (i = 0; i < blocks; i++) {
 		for (j = 0; j < 16; j++)
-			cbc[j] ^= data_to_encrypt[j + i * 16];
+			encrypted_data[j + i * 16] = data_to_encrypt[j + i * 16] ^ (i > 0 ? encrypted_data[j + (i - 1) * 16] : 0x00);
 
-		renard_aes_enc_dec(cbc, key, 0);
-
-		for (j = 0; j < 16; j++)
-			encrypted_data[j + (i * 16)] = cbc[j];
+		backend->aes_128_encrypt(&encrypted_data[i * 16], key);
 	}
 
 	return 0;
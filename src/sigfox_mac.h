@@ -3,6 +3,6 @@
 #ifndef _SIGFOX_MAC_H
 #define _SIGFOX_MAC_H
 
-int renard_aes_128_cbc_encrypt(uint8_t *encrypted_data, uint8_t *data_to_encrypt, uint8_t data_len, uint8_t *key);
+int renard_aes_128_cbc_encrypt(uint8_t *encrypted_data, const uint8_t *data_to_encrypt, uint8_t data_len, const uint8_t *key);
 
 #endif
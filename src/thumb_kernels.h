@@ -0,0 +1,20 @@
+#include <inttypes.h>
+
+#include "renard_config.h"
+
+#ifndef _THUMB_KERNELS_H
+#define _THUMB_KERNELS_H
+
+/*
+ * Hand-written Thumb assembly kernels for Cortex-M0+ / M3 / M4 (src/thumb/), only available if built with
+ * RENARD_THUMB_KERNELS (see renard_config.h). All kernels are bit-exact replacements of the C implementations.
+ */
+#ifdef RENARD_THUMB_KERNELS
+
+uint16_t renard_crc16_thumb(uint8_t const data[], uint8_t length);
+void renard_convcode_thumb(uint8_t *buffer, uint8_t length, uint8_t polynomial);
+void renard_aes_128_encrypt_thumb(uint8_t *block, const uint8_t *key);
+
+#endif
+
+#endif
@@ -60,6 +60,9 @@ const unsigned char sbox[256] =   {
 0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf, //E
 0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16 }; //F
 
+#include "renard_config.h"
+
+#ifndef RENARD_AES_ENCRYPT_ONLY
 // inverse sbox
 const unsigned char rsbox[256] =
 { 0x52, 0x09, 0x6a, 0xd5, 0x30, 0x36, 0xa5, 0x38, 0xbf, 0x40, 0xa3, 0x9e, 0x81, 0xf3, 0xd7, 0xfb
@@ -78,6 +81,7 @@ const unsigned char rsbox[256] =
 , 0x60, 0x51, 0x7f, 0xa9, 0x19, 0xb5, 0x4a, 0x0d, 0x2d, 0xe5, 0x7a, 0x9f, 0x93, 0xc9, 0x9c, 0xef
 , 0xa0, 0xe0, 0x3b, 0x4d, 0xae, 0x2a, 0xf5, 0xb0, 0xc8, 0xeb, 0xbb, 0x3c, 0x83, 0x53, 0x99, 0x61
 , 0x17, 0x2b, 0x04, 0x7e, 0xba, 0x77, 0xd6, 0x26, 0xe1, 0x69, 0x14, 0x63, 0x55, 0x21, 0x0c, 0x7d };
+#endif
 
 // round constant
 const unsigned char Rcon[10] = {
@@ -98,12 +102,69 @@ unsigned char renard_galois_mul2(unsigned char value)
   return ((value << 1)^temp);
 }
 
+#ifdef RENARD_CONSTANT_TIME
+// Constant-time S-box (see RENARD_CONSTANT_TIME in renard_config.h): table lookups
+// with secret indices are replaced by computing the multiplicative inverse in the
+// galois field and the affine transformation, without data-dependent branches or
+// memory accesses
+
+// multiply in the galois field, all 8 bits of b are processed
+static unsigned char renard_galois_mul(unsigned char a, unsigned char b)
+{
+  unsigned char result = 0, i;
+  for (i = 0; i < 8; i++) {
+    result ^= a & (unsigned char)(0 - (b & 1));
+    a = renard_galois_mul2(a);
+    b >>= 1;
+  }
+  return result;
+}
+
+// multiplicative inverse a^254 (0 for a = 0)
+static unsigned char renard_galois_inv(unsigned char a)
+{
+  unsigned char a2, a3, a12, a15, a240;
+  a2 = renard_galois_mul(a, a);
+  a3 = renard_galois_mul(a2, a);
+  a12 = renard_galois_mul(a3, a3);
+  a12 = renard_galois_mul(a12, a12);
+  a15 = renard_galois_mul(a12, a3);
+  a240 = renard_galois_mul(a15, a15);
+  a240 = renard_galois_mul(a240, a240);
+  a240 = renard_galois_mul(a240, a240);
+  a240 = renard_galois_mul(a240, a240);
+  return renard_galois_mul(renard_galois_mul(a240, a12), a2);
+}
+
+#define ROTL8(x, n) ((unsigned char)(((x) << (n)) | ((x) >> (8 - (n)))))
+
+static unsigned char renard_sbox(unsigned char value)
+{
+  unsigned char inv = renard_galois_inv(value);
+  return inv ^ ROTL8(inv, 1) ^ ROTL8(inv, 2) ^ ROTL8(inv, 3) ^ ROTL8(inv, 4) ^ 0x63;
+}
+
+#ifndef RENARD_AES_ENCRYPT_ONLY
+static unsigned char renard_rsbox(unsigned char value)
+{
+  return renard_galois_inv(ROTL8(value, 1) ^ ROTL8(value, 3) ^ ROTL8(value, 6) ^ 0x05);
+}
+#endif
+
+#define SBOX(x) renard_sbox(x)
+#define RSBOX(x) renard_rsbox(x)
+#else
+#define SBOX(x) sbox[x]
+#define RSBOX(x) rsbox[x]
+#endif
+
 // AES encryption and decryption function
 // The code was optimized for memory (flash and ram)
 // Combining both encryption and decryption resulted in a slower implementation
 // but much smaller than the 2 functions separated
 // This function only implements AES-128 encryption and decryption (AES-192 and 
 // AES-256 are not supported by this code) 
+// With RENARD_AES_ENCRYPT_ONLY, only encryption is supported and `dir` is ignored
 void renard_aes_enc_dec(unsigned char *state, const unsigned char *Localkey, unsigned char dir)
 {
   unsigned char buf1, buf2, buf3, buf4, round, i;
@@ -116,15 +177,19 @@ void renard_aes_enc_dec(unsigned char *state, const unsigned char *Localkey, uns
 	  key[i]=Localkey[i];
   }
 
+#ifdef RENARD_AES_ENCRYPT_ONLY
+  // decryption path removed, treat as encryption
+  dir = 0;
+#else
   // In case of decryption
   if (dir) {
     // compute the last key of encryption before starting the decryption
     for (round = 0 ; round < 10; round++) {
       //key schedule
-      key[0] = sbox[key[13]]^key[0]^Rcon[round];
-      key[1] = sbox[key[14]]^key[1];
-      key[2] = sbox[key[15]]^key[2];
-      key[3] = sbox[key[12]]^key[3];
+      key[0] = SBOX(key[13])^key[0]^Rcon[round];
+      key[1] = SBOX(key[14])^key[1];
+      key[2] = SBOX(key[15])^key[2];
+      key[3] = SBOX(key[12])^key[3];
       for (i=4; i<16; i++) {
         key[i] = key[i] ^ key[i-4];
       }
@@ -135,22 +200,26 @@ void renard_aes_enc_dec(unsigned char *state, const unsigned char *Localkey, uns
       state[i]=state[i] ^ key[i];
     }
   }
+#endif
   
   // main loop
   for (round = 0; round < 10; round++){
+#ifndef RENARD_AES_ENCRYPT_ONLY
     if (dir){
       //Inverse key schedule
       for (i=15; i>3; --i) {
 	key[i] = key[i] ^ key[i-4];
       }  
-      key[0] = sbox[key[13]]^key[0]^Rcon[9-round];
-      key[1] = sbox[key[14]]^key[1];
-      key[2] = sbox[key[15]]^key[2];
-      key[3] = sbox[key[12]]^key[3]; 
-    } else {
+      key[0] = SBOX(key[13])^key[0]^Rcon[9-round];
+      key[1] = SBOX(key[14])^key[1];
+      key[2] = SBOX(key[15])^key[2];
+      key[3] = SBOX(key[12])^key[3]; 
+    } else
+#endif
+    {
       for (i = 0; i <16; i++){
         // with shiftrow i+5 mod 16
-	state[i]=sbox[state[i] ^ key[i]];
+	state[i]=SBOX(state[i] ^ key[i]);
       }
       //shift rows
       buf1 = state[1];
@@ -176,12 +245,14 @@ void renard_aes_enc_dec(unsigned char *state, const unsigned char *Localkey, uns
     if ((round > 0 && dir) || (round < 9 && !dir)) {
       for (i=0; i <4; i++){
         buf4 = (i << 2);
+#ifndef RENARD_AES_ENCRYPT_ONLY
         if (dir){
           // precompute for decryption
           buf1 = renard_galois_mul2(renard_galois_mul2(state[buf4]^state[buf4+2]));
           buf2 = renard_galois_mul2(renard_galois_mul2(state[buf4+1]^state[buf4+3]));
           state[buf4] ^= buf1; state[buf4+1] ^= buf2; state[buf4+2] ^= buf1; state[buf4+3] ^= buf2; 
         }
+#endif
         // in all cases
         buf1 = state[buf4] ^ state[buf4+1] ^ state[buf4+2] ^ state[buf4+3];
         buf2 = state[buf4];
@@ -192,6 +263,7 @@ void renard_aes_enc_dec(unsigned char *state, const unsigned char *Localkey, uns
       }
     }
     
+#ifndef RENARD_AES_ENCRYPT_ONLY
     if (dir) {
       //Inv shift rows
       // Row 1
@@ -216,14 +288,16 @@ void renard_aes_enc_dec(unsigned char *state, const unsigned char *Localkey, uns
            
       for (i = 0; i <16; i++){
         // with shiftrow i+5 mod 16
-        state[i]=rsbox[state[i]] ^ key[i];
+        state[i]=RSBOX(state[i]) ^ key[i];
       } 
-    } else {
+    } else
+#endif
+    {
       //key schedule
-      key[0] = sbox[key[13]]^key[0]^Rcon[round];
-      key[1] = sbox[key[14]]^key[1];
-      key[2] = sbox[key[15]]^key[2];
-      key[3] = sbox[key[12]]^key[3];
+      key[0] = SBOX(key[13])^key[0]^Rcon[round];
+      key[1] = SBOX(key[14])^key[1];
+      key[2] = SBOX(key[15])^key[2];
+      key[3] = SBOX(key[12])^key[3];
       for (i=4; i<16; i++) {
         key[i] = key[i] ^ key[i-4];
       }
@@ -2,13 +2,16 @@
 
 #include "sigfox_mac.h"
 #include "sigfox_crc.h"
+#include "constant_time.h"
+#include "uplink_class.h"
+#include "workspace.h"
 #include "uplink.h"
 #include "common.h"
 
 /**
  * @brief content of Sigfox's 5-nibble (::SFX_UL_PREAMBLELEN_NIBBLES) uplink preamble, only use first 5 nibbles
  */
-uint8_t SFX_UL_PREAMBLE[] = {
+const uint8_t SFX_UL_PREAMBLE[] = {
 	0xaa, 0xaa, 0xa0
 };
 
@@ -171,7 +174,7 @@ void unconvcode(uint8_t *inbuffer, uint8_t *outbuffer, uint8_t length_bits, uint
  * These values were probably chosen to achieve a minimal
  * hamming distance of 5 so that 2 bit errors can be corrected.
  */
-uint16_t frametypes[3][5] = {
+const uint16_t frametypes[SFX_UL_TRANSMISSIONS][SFX_UL_FRAMECLASSES] = {
 	// 1bit  1Byte  4Byte  8Byte 12Byte
 	{ 0x06b, 0x08d, 0x35f, 0x611, 0x94c }, // first transmission
 	{ 0x6e0, 0x0d2, 0x598, 0x6bf, 0x971 }, // second transmission
@@ -182,8 +185,9 @@ uint16_t frametypes[3][5] = {
  * Translation table:
  * Column in 'frametypes' to packet (Flags + SN + Device ID + Payload + MAC) length
  */
-uint8_t frametype_to_packetlen[] = {
-	8, 9, 12, 16, 20
+const uint8_t frametype_to_packetlen[SFX_UL_FRAMECLASSES] = {
+	SFX_UL_CLASS_A_PACKETLEN, SFX_UL_CLASS_B_PACKETLEN, SFX_UL_CLASS_C_PACKETLEN,
+	SFX_UL_CLASS_D_PACKETLEN, SFX_UL_CLASS_E_PACKETLEN
 };
 
 /**
@@ -192,16 +196,17 @@ uint8_t frametype_to_packetlen[] = {
  * @param payloadlen length of payload inside packet in bytes (0 to 12, where 0 is for single-bit messages), length of `packetcontent` is thus 6 + payloadlen
  * @param key buffer containing the NAK (secret key)
  * @param mac output, message authentication code (MAC)
+ * @param workspace scratch buffers for AES input and output
  * @return length of MAC in bytes
  */
-uint8_t sfx_uplink_get_mac(uint8_t *packetcontent, uint8_t payloadlen, uint8_t *key, uint8_t *mac) {
+uint8_t sfx_uplink_get_mac(const uint8_t *packetcontent, uint8_t payloadlen, const uint8_t *key, uint8_t *mac, sfx_mac_workspace *workspace) {
 	// Fill two 128bit-AES blocks with data to encrypt, even if maybe just one of them is used
 	// authentic_data_length: not only the payload, but also flags, SN and device id are begin protected
 	// (authenticity checked) by MAC, therefore the length of data to be encrypted is greater than just
 	// the message payload
 	#define ADDITIONAL_LENGTH_BYTES ((SFX_UL_FLAGLEN_NIBBLES + SFX_UL_SNLEN_NIBBLES + SFX_UL_DEVIDLEN_NIBBLES) / 2)
 	uint8_t authentic_data_length = ADDITIONAL_LENGTH_BYTES + payloadlen;
-	uint8_t data_to_encrypt[32];
+	uint8_t *data_to_encrypt = workspace->input;
 	uint8_t j = 0;
 	for (uint8_t i = 0; i < 32; ++i) {
 		data_to_encrypt[i] = packetcontent[j];
@@ -214,7 +219,7 @@ uint8_t sfx_uplink_get_mac(uint8_t *packetcontent, uint8_t payloadlen, uint8_t *
 
 	// Encrypt authenticity-checked data with 'private' AES key,
 	// beginning of encrypted_data is mac
-	uint8_t encrypted_data[32];
+	uint8_t *encrypted_data = workspace->output;
 	renard_aes_128_cbc_encrypt(encrypted_data, data_to_encrypt, blocknum * 16, key);
 
 	// The length of the MAC included in the frame depends on the length of the
@@ -228,6 +233,55 @@ uint8_t sfx_uplink_get_mac(uint8_t *packetcontent, uint8_t payloadlen, uint8_t *
 	return maclen;
 }
 
+/**
+ * @brief determine frame class (column in 'frametypes' table) for the given frame contents
+ * @param uplink the content of the payload to encode
+ * @return frame class: single bit (class A) = 0, 1 byte (class B) = 1, 4 / 8 / 12 bytes (classes C / D / E) = 2 / 3 / 4
+ */
+uint8_t sfx_uplink_frameclass(const sfx_ul_plain *uplink)
+{
+	if (uplink->singlebit)
+		return 0;
+	else if (uplink->payloadlen == 1)
+		return 1;
+	else
+		return (uplink->payloadlen - 1) / 4 + 2;
+}
+
+/**
+ * @brief check whether the given frame contents can be encoded
+ * @param uplink the content of the payload to encode
+ * @return ::SFX_ULE_ERR_NONE if frame contents are valid, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_check(const sfx_ul_plain *uplink)
+{
+	if (uplink->payloadlen > SFX_UL_MAX_PAYLOADLEN)
+		return SFX_ULE_ERR_PAYLOAD_TOO_LONG;
+	if (uplink->singlebit && uplink->payloadlen != 0)
+		return SFX_ULE_SINGLEBIT_MISMATCH;
+	if (!uplink->singlebit && uplink->payloadlen == 0)
+		return SFX_ULE_ERR_PAYLOAD_EMPTY;
+
+	return SFX_ULE_ERR_NONE;
+}
+
+/**
+ * @brief generate initial transmission of raw Sigfox uplink frame (frame type, packet and CRC) for the given frame contents
+ * @param uplink the content of the payload to encode
+ * @param common general information about the Sigfox object and its state
+ * @param frame output, raw frame of initial transmission without preamble, at least ::SFX_UL_MAX_FRAMELEN bytes
+ * @param workspace scratch memory, see workspace.h
+ * @return length of frame in nibbles, excluding preamble
+ * @attention Input is not validated, see ::sfx_uplink_check
+ */
+static uint8_t sfx_uplink_build_frame(const sfx_ul_plain *uplink, const sfx_commoninfo *common, uint8_t *frame, sfx_workspace *workspace)
+{
+	uint8_t frameclass = sfx_uplink_frameclass(uplink);
+	sfx_uplink_class_encoders[frameclass](uplink, common, (uint8_t (*)[SFX_UL_MAX_FRAMELEN])frame, 1, workspace);
+
+	return SFX_UL_FRAMELEN_NIBBLES(frametype_to_packetlen[frameclass]);
+}
+
 /**
  * @brief generate raw Sigfox uplink frame for the given frame contents
  * @param uplink the content of the payload to encode
@@ -237,115 +291,162 @@ uint8_t sfx_uplink_get_mac(uint8_t *packetcontent, uint8_t payloadlen, uint8_t *
  */
 sfx_ule_err sfx_uplink_encode(sfx_ul_plain uplink, sfx_commoninfo common, sfx_ul_encoded *encoded)
 {
-	if (uplink.payloadlen > SFX_UL_MAX_PAYLOADLEN)
-		return SFX_ULE_ERR_PAYLOAD_TOO_LONG;
-	if (uplink.singlebit && uplink.payloadlen != 0)
-		return SFX_ULE_SINGLEBIT_MISMATCH;
+	sfx_workspace workspace;
+	return sfx_uplink_encode_ws(&uplink, &common, encoded, &workspace);
+}
 
-	uint8_t i;
-	uint8_t replica;
+/**
+ * @brief generate raw Sigfox uplink frame, see ::sfx_uplink_encode, using caller-provided scratch memory
+ * @param uplink the content of the payload to encode
+ * @param common general information about the Sigfox object and its state
+ * @param encoded output, raw encoded Sigfox uplink frame(s)
+ * @param workspace scratch memory, see workspace.h
+ * @return ::SFX_ULE_ERR_NONE if encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_encode_ws(const sfx_ul_plain *uplink, const sfx_commoninfo *common, sfx_ul_encoded *encoded, sfx_workspace *workspace)
+{
+	sfx_ule_err err = sfx_uplink_check(uplink);
+	if (err != SFX_ULE_ERR_NONE)
+		return err;
 
 	/*
-	 * All replicas: Set frame type, indicates transmission count (initial / replica) and frame class
-	 * Three general types of frame classes:
-	 * Single bit (class A), 1 byte (class B), 4 / 8 / 12 bytes (classes C / D / E)
+	 * Encoding is specialized for each frame class, see uplink_class.c:
+	 * Frame type indicates transmission count (initial / replica) and frame class, packet consists
+	 * of flags, sequence number, device ID, message and MAC, replicas use (7, 5) convolutional code.
 	 */
-	for (replica = 0; replica < 3; ++replica) {
-		uint16_t ftype;
-		if (uplink.singlebit)
-			ftype = frametypes[replica][0];
-		else if (uplink.payloadlen == 1)
-			ftype = frametypes[replica][1];
-		else
-			ftype = frametypes[replica][(uplink.payloadlen - 1) / 4 + 2];
+	uint8_t frameclass = sfx_uplink_frameclass(uplink);
+	sfx_uplink_class_encoders[frameclass](uplink, common, encoded->frame, 3, workspace);
+	encoded->framelen_nibbles = SFX_UL_FRAMELEN_NIBBLES(frametype_to_packetlen[frameclass]);
 
-		setnibble(encoded->frame[replica], 0, (ftype & 0xf00) >> 8);
-		setnibble(encoded->frame[replica], 1, (ftype & 0x0f0) >> 4);
-		setnibble(encoded->frame[replica], 2, (ftype & 0x00f) >> 0);
-	}
+	return SFX_ULE_ERR_NONE;
+}
 
-	/*
-	 * Construct packet consisting of flags, sequence number, device ID, message and MAC
-	 * Length of MAC is at least 2, but may be extended
-	 */
-	uint8_t packet[SFX_UL_MAX_PACKETLEN];
-	uint8_t flags = 0x0;
+/**
+ * @brief pre-encode the parts of an upcoming uplink frame that do not depend on the payload (frame class, flags, sequence number and device ID), e.g. during idle time
+ * @param uplink template for frame contents: payload length, downlink request and whether replicas are generated are fixed now; payload is only used if `fixed_payload` is set
+ * @param common general information about the Sigfox object and its state, sfx_commoninfo::seqnum is the sequence number the frame will be sent with
+ * @param fixed_payload If true, the payload in `uplink` is final and the complete frame including replicas is encoded right away, so that ::sfx_uplink_finalize only has to copy it
+ * @param precomputed output, pre-encoded frame
+ * @return ::SFX_ULE_ERR_NONE if pre-encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_precompute(sfx_ul_plain uplink, sfx_commoninfo common, bool fixed_payload, sfx_ul_precomputed *precomputed)
+{
+	sfx_workspace workspace;
+	return sfx_uplink_precompute_ws(&uplink, &common, fixed_payload, precomputed, &workspace);
+}
 
-	/*
-	 * Flags: Three special cases:
-	 * - class A (single bit) messages: MSB of flag nibble is always 1, second bit is the message content (true / false)
-	 * - class B: Length of MAC is always 2, thus flags are zero
-	 * - class C / D / E: Length of MAC = 2 + <integer representation of upper two bits of flags>
-	 */
-	uint8_t maclen;
-	if (uplink.singlebit) {
-		maclen = SFX_UL_MIN_MACLEN;
-		flags |= 0x8 | ((uplink.payload[0] == 0) ? 0x0 : 0x4);
-	} else if (uplink.payloadlen == 1) {
-		maclen = SFX_UL_MIN_MACLEN;
-	} else {
-		maclen = (SFX_UL_MAX_PAYLOADLEN - uplink.payloadlen) % 4 + SFX_UL_MIN_MACLEN;
-		flags |= (maclen - 2) << 2;
-	}
+/**
+ * @brief pre-encode the parts of an upcoming uplink frame that do not depend on the payload, see ::sfx_uplink_precompute, using caller-provided scratch memory
+ * @param uplink template for frame contents, see ::sfx_uplink_precompute
+ * @param common general information about the Sigfox object and its state, see ::sfx_uplink_precompute
+ * @param fixed_payload If true, the payload in `uplink` is final and the complete frame is encoded right away
+ * @param precomputed output, pre-encoded frame
+ * @param workspace scratch memory, see workspace.h
+ * @return ::SFX_ULE_ERR_NONE if pre-encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_precompute_ws(const sfx_ul_plain *uplink, const sfx_commoninfo *common, bool fixed_payload, sfx_ul_precomputed *precomputed, sfx_workspace *workspace)
+{
+	sfx_ule_err err = sfx_uplink_check(uplink);
+	if (err != SFX_ULE_ERR_NONE)
+		return err;
 
-	// Set downlink bit in flags if requested
-	if (uplink.request_downlink)
-		flags |= 0x2;
+	precomputed->seqnum = common->seqnum;
+	precomputed->payloadlen = uplink->payloadlen;
+	precomputed->frameclass = sfx_uplink_frameclass(uplink);
+	precomputed->replicas = uplink->replicas;
+	memcpy(precomputed->key, common->key, sizeof(precomputed->key));
+	sfx_uplink_prepare_header(uplink, common, precomputed->packet);
 
-	setnibble(packet, 0, flags);
+	precomputed->complete = fixed_payload;
+	if (fixed_payload)
+		sfx_uplink_encode_ws(uplink, common, &precomputed->encoded, workspace);
 
-	/*
-	 * Sequence Number (SN): 12 bits
-	 */
-	setnibble(packet, 1, (common.seqnum & 0xf00) >> 8);
-	setnibble(packet, 2, (common.seqnum & 0x0f0) >> 4);
-	setnibble(packet, 3, (common.seqnum & 0x00f) >> 0);
+	return SFX_ULE_ERR_NONE;
+}
 
-	/*
-	 * Device ID: Little Endian format
-	 */
-	packet[2] = (common.devid & 0x000000ff) >> 0;
-	packet[3] = (common.devid & 0x0000ff00) >> 8;
-	packet[4] = (common.devid & 0x00ff0000) >> 16;
-	packet[5] = (common.devid & 0xff000000) >> 24;
+/**
+ * @brief pre-encode upcoming uplink frames for a window of consecutive sequence numbers, see ::sfx_uplink_precompute
+ * @param uplink template for frame contents, see ::sfx_uplink_precompute
+ * @param common general information about the Sigfox object and its state, sfx_commoninfo::seqnum is the sequence number of the first frame in the window
+ * @param fixed_payload If true, the payload in `uplink` is final and all frames are completely encoded
+ * @param precomputed output, array of `count` pre-encoded frames for sequence numbers `common.seqnum` to `common.seqnum + count - 1` (wrapping around after 12 bits)
+ * @param count number of frames to pre-encode
+ * @return ::SFX_ULE_ERR_NONE if pre-encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_precompute_window(sfx_ul_plain uplink, sfx_commoninfo common, bool fixed_payload, sfx_ul_precomputed *precomputed, uint16_t count)
+{
+	sfx_workspace workspace;
+	return sfx_uplink_precompute_window_ws(&uplink, &common, fixed_payload, precomputed, count, &workspace);
+}
 
-	/*
-	 * Payload
-	 */
-	if (!uplink.singlebit)
-		for (i = 0; i < uplink.payloadlen; ++i)
-			packet[6 + i] = uplink.payload[i];
+/**
+ * @brief pre-encode upcoming uplink frames for a window of consecutive sequence numbers, see ::sfx_uplink_precompute_window, using caller-provided scratch memory
+ * @param uplink template for frame contents, see ::sfx_uplink_precompute
+ * @param common general information about the Sigfox object and its state, sfx_commoninfo::seqnum is the sequence number of the first frame in the window
+ * @param fixed_payload If true, the payload in `uplink` is final and all frames are completely encoded
+ * @param precomputed output, array of `count` pre-encoded frames, see ::sfx_uplink_precompute_window
+ * @param count number of frames to pre-encode
+ * @param workspace scratch memory, see workspace.h
+ * @return ::SFX_ULE_ERR_NONE if pre-encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_precompute_window_ws(const sfx_ul_plain *uplink, const sfx_commoninfo *common, bool fixed_payload, sfx_ul_precomputed *precomputed, uint16_t count, sfx_workspace *workspace)
+{
+	sfx_commoninfo current = *common;
 
-	/*
-	 * Message Authentication Code (MAC)
-	 * The length of the MAC in the frame depends on the length of the payload.
-	 * It is at least 2 bytes long, but can be extended to 3 / 4 / 5 bytes for frame classes C / D / E.
-	 */
-	uint8_t mac[SFX_UL_MAX_MACLEN];
-	sfx_uplink_get_mac(packet, uplink.payloadlen, common.key, mac);
-	uint8_t mac_offset = (SFX_UL_FLAGLEN_NIBBLES + SFX_UL_SNLEN_NIBBLES + SFX_UL_DEVIDLEN_NIBBLES) / 2 + (uplink.singlebit ? 0 : uplink.payloadlen);
+	for (uint16_t i = 0; i < count; ++i) {
+		sfx_ule_err err = sfx_uplink_precompute_ws(uplink, &current, fixed_payload, &precomputed[i], workspace);
+		if (err != SFX_ULE_ERR_NONE)
+			return err;
 
-	for (i = 0; i < maclen; ++i)
-		packet[mac_offset + i] = mac[i];
+		current.seqnum = (current.seqnum + 1) & 0xfff;
+	}
 
-	/*
-	 * Copy whole packet to frame buffer, including MAC and CRC, for first transmission only
-	 */
-	uint8_t packetlen = mac_offset + maclen;
-	memcpy_nibbles(encoded->frame[0], packet, 0, SFX_UL_FTYPELEN_NIBBLES, packetlen * 2);
+	return SFX_ULE_ERR_NONE;
+}
 
-	/*
-	 * Add CRC to frame, takes care of bitwise inversion of CRC value
-	 */
-	uint16_t crc16 = ~renard_crc16(packet, packetlen);
-	setvalue_nibbles(encoded->frame[0], SFX_UL_FTYPELEN_NIBBLES + packetlen * 2, 4, crc16);
-	encoded->framelen_nibbles = SFX_UL_FTYPELEN_NIBBLES + packetlen * 2 + SFX_UL_CRCLEN_NIBBLES;
+/**
+ * @brief complete a pre-encoded uplink frame: fill in payload, MAC and CRC and generate replicas
+ * @param precomputed pre-encoded frame, see ::sfx_uplink_precompute
+ * @param payload payload to transmit, sfx_ul_precomputed::payloadlen bytes (a single byte containing `0` or `1` for single-bit frames); may be NULL if the frame was pre-encoded with a fixed payload
+ * @param encoded output, raw encoded Sigfox uplink frame(s), see ::sfx_uplink_encode
+ * @return ::SFX_ULE_ERR_NONE if encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_finalize(sfx_ul_precomputed *precomputed, const uint8_t *payload, sfx_ul_encoded *encoded)
+{
+	sfx_workspace workspace;
+	return sfx_uplink_finalize_ws(precomputed, payload, encoded, &workspace);
+}
 
-	/*
-	 * Encode replica transmissions using (7, 5) convolutional code
-	 */
-	convcode(encoded->frame[0], encoded->frame[1], encoded->framelen_nibbles * 4, SFX_UL_FTYPELEN_NIBBLES * 4, 07);
-	convcode(encoded->frame[0], encoded->frame[2], encoded->framelen_nibbles * 4, SFX_UL_FTYPELEN_NIBBLES * 4, 05);
+/**
+ * @brief complete a pre-encoded uplink frame, see ::sfx_uplink_finalize, using caller-provided scratch memory
+ * @param precomputed pre-encoded frame, see ::sfx_uplink_precompute
+ * @param payload payload to transmit, see ::sfx_uplink_finalize
+ * @param encoded output, raw encoded Sigfox uplink frame(s)
+ * @param workspace scratch memory, see workspace.h
+ * @return ::SFX_ULE_ERR_NONE if encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_finalize_ws(const sfx_ul_precomputed *precomputed, const uint8_t *payload, sfx_ul_encoded *encoded, sfx_workspace *workspace)
+{
+	if (payload == NULL) {
+		if (!precomputed->complete)
+			return SFX_ULE_ERR_PAYLOAD_EMPTY;
+
+		memcpy(encoded, &precomputed->encoded, sizeof(*encoded));
+		return SFX_ULE_ERR_NONE;
+	}
+
+	uint8_t *packet = workspace->packet;
+	memcpy(packet, precomputed->packet, SFX_UL_HEADERLEN);
+
+	// single-bit frames carry their payload in the flags
+	if (precomputed->frameclass == 0)
+		packet[0] = (packet[0] & ~0x40) | (payload[0] ? 0x40 : 0x00);
+	else
+		memcpy(&packet[SFX_UL_HEADERLEN], payload, precomputed->payloadlen);
+
+	sfx_uplink_class_finishers[precomputed->frameclass](precomputed->payloadlen, precomputed->key,
+			encoded->frame, precomputed->replicas ? 3 : 1, workspace);
+	encoded->framelen_nibbles = SFX_UL_FRAMELEN_NIBBLES(frametype_to_packetlen[precomputed->frameclass]);
 
 	return SFX_ULE_ERR_NONE;
 }
@@ -360,18 +461,19 @@ sfx_ule_err sfx_uplink_encode(sfx_ul_plain uplink, sfx_commoninfo common, sfx_ul
  */
 sfx_uld_err sfx_uplink_decode(sfx_ul_encoded to_decode, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac)
 {
-	uint8_t *frame = to_decode.frame[0];
-
-	// only odd nibble numbers can naturally occur - discard all frames with even nibble numbers
-	if (to_decode.framelen_nibbles % 2 == 0)
-		return SFX_ULD_ERR_FRAMELEN_EVEN;
+	sfx_workspace workspace;
+	return sfx_uplink_decode_ws(&to_decode, uplink_out, common, check_mac, &workspace);
+}
 
-	/*
-	 * Find frame type value from table (indicates replica number / frame length) that matches contained
-	 * frame type best (lowest hamming distance). This way, we can correct up to two erroneous bits
-	 * inside the frame type field.
-	*/
-	uint16_t frametype = ((frame[0] & 0xf0) << 4) | ((frame[0] & 0x0f) << 4) | ((frame[1] & 0xf0) >> 4);
+/**
+ * @brief determine replica and frame class from the frame type value closest to the received one (lowest hamming
+ * distance), so that up to two erroneous bits inside the frame type field are corrected
+ * @param frametype received 12-bit frame type
+ * @param replica_out output, replica number (row in 'frametypes' table)
+ * @param frameclass_out output, frame class (column in 'frametypes' table)
+ */
+void sfx_uplink_classify_frametype(uint16_t frametype, uint8_t *replica_out, uint8_t *frameclass_out)
+{
 	uint8_t replica;
 	uint8_t payloadlen_type;
 
@@ -382,91 +484,443 @@ sfx_uld_err sfx_uplink_decode(sfx_ul_encoded to_decode, sfx_ul_plain *uplink_out
 		for (payloadlen_type = 0; payloadlen_type < 5; ++payloadlen_type) {
 			uint8_t hammingdistance = __builtin_popcount(frametypes[replica][payloadlen_type] ^ frametype);
 
+#ifdef RENARD_CONSTANT_TIME
+			// select without branching on the received frame type
+			uint8_t better = renard_ct_lt_mask(hammingdistance, lowest_hammingdistance);
+			lowest_hammingdistance ^= (lowest_hammingdistance ^ hammingdistance) & better;
+			best_replica ^= (best_replica ^ replica) & better;
+			best_payloadlen_type ^= (best_payloadlen_type ^ payloadlen_type) & better;
+#else
 			if (hammingdistance < lowest_hammingdistance) {
 				lowest_hammingdistance = hammingdistance;
 				best_replica = replica;
 				best_payloadlen_type = payloadlen_type;
 			}
+#endif
 		}
 	}
 
-	// length of packet (Flags + SN + Device ID + Payload + MAC) in bytes
-	uint8_t packetlen_bytes = frametype_to_packetlen[best_payloadlen_type];
+	*replica_out = best_replica;
+	*frameclass_out = best_payloadlen_type;
+}
+
+/**
+ * @brief determine replica and frame class of uplink frame from its frame type (see ::sfx_uplink_classify_frametype)
+ * and check frame length
+ * @param to_decode the raw contents of the Sigfox uplink frame, only first frame is processed
+ * @param replica_out output, replica number (row in 'frametypes' table)
+ * @param frameclass_out output, frame class (column in 'frametypes' table)
+ * @return ::SFX_ULD_ERR_NONE or an error concerning frame length / frame type
+ */
+sfx_uld_err sfx_uplink_classify(const sfx_ul_encoded *to_decode, uint8_t *replica_out, uint8_t *frameclass_out)
+{
+	const uint8_t *frame = to_decode->frame[0];
+	uint8_t replica, frameclass;
+
+	// only odd nibble numbers can naturally occur - discard all frames with even nibble numbers
+	if (to_decode->framelen_nibbles % 2 == 0)
+		return SFX_ULD_ERR_FRAMELEN_EVEN;
+
+	sfx_uplink_classify_frametype(((uint16_t)frame[0] << 4) | (frame[1] >> 4), &replica, &frameclass);
 
 	// check if frame length indicated by frame type matches actual length of frame
-	if (to_decode.framelen_nibbles != SFX_UL_FTYPELEN_NIBBLES + packetlen_bytes * 2 + SFX_UL_CRCLEN_NIBBLES)
+	if (to_decode->framelen_nibbles != SFX_UL_FRAMELEN_NIBBLES(frametype_to_packetlen[frameclass]))
 		return SFX_ULD_ERR_FTYPE_MISMATCH;
 
-	uplink_out->singlebit = (best_payloadlen_type == 0);
+	*replica_out = replica;
+	*frameclass_out = frameclass;
+
+	return SFX_ULD_ERR_NONE;
+}
+
+/**
+ * @brief retrieve contents of Sigfox uplink from given raw frame, see ::sfx_uplink_decode, using caller-provided scratch memory
+ * @param to_decode the raw contents of the Sigfox uplink frame to decode, only first frame is processed
+ * @param uplink_out output, decoded plain contents of uplink frame
+ * @param common general information about the Sigfox object and its state, see ::sfx_uplink_decode
+ * @param check_mac If true, check MAC tag of uplink frame. In this case, a valid NAK has to be provided.
+ * @param workspace scratch memory, see workspace.h
+ * @return ::SFX_ULD_ERR_NONE if decoding was successful, otherwise some error defined in ::sfx_uld_err
+ */
+sfx_uld_err sfx_uplink_decode_ws(const sfx_ul_encoded *to_decode, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac, sfx_workspace *workspace)
+{
+	uint8_t replica, frameclass;
+
+	sfx_uld_err err = sfx_uplink_classify(to_decode, &replica, &frameclass);
+	if (err != SFX_ULD_ERR_NONE)
+		return err;
 
 	/*
-	 * Just allocate the maximum possible frame length (even if it isn't necessary),
-	 * so that we don't have to depend on stdlib.h for malloc. Allocates one more nibble than
-	 * required because frames have an odd-nibble length, but we can only allocate bytes.
+	 * Decoding is specialized for each frame class and replica, see uplink_class.c
 	 */
-	uint8_t frame_plain[SFX_UL_MAX_FRAMELEN];
-	uint8_t ceil_framelen_bytes = (to_decode.framelen_nibbles + 1) / 2;
-	if (best_replica == 0)
-		memcpy(frame_plain, frame, ceil_framelen_bytes);
-	else if (best_replica == 1)
-		unconvcode(frame, frame_plain, ceil_framelen_bytes * 8, SFX_UL_FTYPELEN_NIBBLES * 4, 07);
-	else if (best_replica == 2)
-		unconvcode(frame, frame_plain, ceil_framelen_bytes * 8, SFX_UL_FTYPELEN_NIBBLES * 4, 05);
+	return sfx_uplink_class_decoders[replica][frameclass](to_decode->frame[0], uplink_out, common, check_mac, workspace);
+}
+
+/// number of frames whose CRCs are computed by one call of ::renard_crc16_multi in ::sfx_uplink_decode_batch
+#define SFX_UL_BATCH_CRC_CHUNK 64
+
+/**
+ * @brief decode many uplink frames at once without checking their MACs, e.g. for a batch of received frames whose
+ * devices are not known yet: all frames are realigned and unconvolved first, then the CRCs of all frames of the same
+ * frame class are computed together (see ::renard_crc16_multi). MACs can be checked afterwards with
+ * ::sfx_uplink_check_mac once the devices' NAKs are known. Results are identical to ::sfx_uplink_decode without MAC
+ * check for every frame.
+ * @param to_decode array of `count` pointers to raw uplink frames, see ::sfx_uplink_decode
+ * @param count number of frames
+ * @param uplinks_out output, array of `count` decoded plain contents
+ * @param commons output, array of `count` infos, only device ID and sequence number are set
+ * @param packets output, array of `count` byte-aligned packets, needed for ::sfx_uplink_check_mac
+ * @param status output, array of `count` decoding results, other outputs of a frame are only valid if its result is
+ * ::SFX_ULD_ERR_NONE or ::SFX_ULD_ERR_CRC_INVALID
+ */
+void sfx_uplink_decode_batch(const sfx_ul_encoded *const to_decode[], uint16_t count, sfx_ul_plain uplinks_out[], sfx_commoninfo commons[], sfx_ul_packet packets[], sfx_uld_err status[])
+{
+	uint8_t const *data[SFX_UL_BATCH_CRC_CHUNK];
+	uint16_t indices[SFX_UL_BATCH_CRC_CHUNK];
+	uint16_t crcs[SFX_UL_BATCH_CRC_CHUNK];
+	uint8_t replica, frameclass;
+	uint16_t i, j, n;
+
+	for (i = 0; i < count; ++i) {
+		status[i] = sfx_uplink_classify(to_decode[i], &replica, &frameclass);
+		packets[i].packetlen = 0;
+
+		if (status[i] == SFX_ULD_ERR_NONE) {
+			status[i] = sfx_uplink_class_unpackers[replica][frameclass](to_decode[i]->frame[0], &uplinks_out[i], &commons[i], packets[i].packet);
+			packets[i].packetlen = frametype_to_packetlen[frameclass];
+		}
+	}
 
 	/*
-	 * Extract basic metadata from uplink frame
+	 * CRCs per frame class, in chunks of up to SFX_UL_BATCH_CRC_CHUNK frames
 	 */
-	#define FLAGS_OFFSET_NIBBLES SFX_UL_FTYPELEN_NIBBLES
-	#define SN_OFFSET_NIBBLES FLAGS_OFFSET_NIBBLES + SFX_UL_FLAGLEN_NIBBLES
-	#define DEVID_OFFSET_NIBBLES SN_OFFSET_NIBBLES + SFX_UL_SNLEN_NIBBLES
-	#define PAYLOAD_OFFSET_NIBBLES DEVID_OFFSET_NIBBLES + SFX_UL_DEVIDLEN_NIBBLES
-
-	// Device ID is encoded in little endian format - reverse byte order
-	uint32_t devid_le = getvalue_nibbles(frame_plain, DEVID_OFFSET_NIBBLES, SFX_UL_DEVIDLEN_NIBBLES);
-	common->devid = (devid_le & 0x000000ff) << 24;
-	common->devid |= (devid_le & 0x0000ff00) << 8;
-	common->devid |= (devid_le & 0x00ff0000) >> 8;
-	common->devid |= (devid_le & 0xff000000) >> 24;
-	common->seqnum = getvalue_nibbles(frame_plain, SN_OFFSET_NIBBLES, SFX_UL_SNLEN_NIBBLES);
-
-	// Read and interpret flags
-	uint8_t flags = getvalue_nibbles(frame_plain, 3, 1);
-	uint8_t maclen = SFX_UL_MIN_MACLEN + (uplink_out->singlebit ? 0 : flags >> 2);
-	uplink_out->request_downlink = flags & 0x2 ? true : false;
-	uplink_out->payloadlen = packetlen_bytes - (SFX_UL_FLAGLEN_NIBBLES + SFX_UL_SNLEN_NIBBLES + SFX_UL_DEVIDLEN_NIBBLES) / 2 - maclen;
-
-	// Copy frame's payload to uplink_out (decoded properties)
-	if (!uplink_out->singlebit)
-		memcpy_nibbles(uplink_out->payload, frame_plain, PAYLOAD_OFFSET_NIBBLES, 0, uplink_out->payloadlen * 2);
-	else
-		uplink_out->payload[0] = flags & 0x4 ? 0x01 : 0x00;
+	for (frameclass = 0; frameclass < SFX_UL_FRAMECLASSES; ++frameclass) {
+		uint8_t packetlen = frametype_to_packetlen[frameclass];
+
+		for (i = 0; i < count;) {
+			for (n = 0; i < count && n < SFX_UL_BATCH_CRC_CHUNK; ++i) {
+				if (status[i] == SFX_ULD_ERR_NONE && packets[i].packetlen == packetlen) {
+					indices[n] = i;
+					data[n++] = packets[i].packet;
+				}
+			}
+
+			renard_crc16_multi(data, packetlen, n, crcs);
+
+			for (j = 0; j < n; ++j) {
+				const uint8_t *packet = data[j];
+				if ((uint16_t)~crcs[j] != ((packet[packetlen] << 8) | packet[packetlen + 1]))
+					status[indices[j]] = SFX_ULD_ERR_CRC_INVALID;
+			}
+		}
+	}
+}
+
+/**
+ * @brief check MAC of an uplink decoded by ::sfx_uplink_decode_batch
+ * @param packet byte-aligned packet of the uplink
+ * @param uplink decoded plain contents of the uplink
+ * @param key NAK of the Sigfox object
+ * @return ::SFX_ULD_ERR_NONE if the MAC is valid, ::SFX_ULD_ERR_MAC_INVALID otherwise
+ */
+sfx_uld_err sfx_uplink_check_mac(const sfx_ul_packet *packet, const sfx_ul_plain *uplink, const uint8_t *key)
+{
+	sfx_workspace workspace;
+	return sfx_uplink_check_mac_ws(packet, uplink, key, &workspace);
+}
+
+/**
+ * @brief check MAC of an uplink decoded by ::sfx_uplink_decode_batch, see ::sfx_uplink_check_mac, using
+ * caller-provided scratch memory
+ * @param packet byte-aligned packet of the uplink
+ * @param uplink decoded plain contents of the uplink
+ * @param key NAK of the Sigfox object
+ * @param workspace scratch memory, see workspace.h
+ * @return ::SFX_ULD_ERR_NONE if the MAC is valid, ::SFX_ULD_ERR_MAC_INVALID otherwise
+ */
+sfx_uld_err sfx_uplink_check_mac_ws(const sfx_ul_packet *packet, const sfx_ul_plain *uplink, const uint8_t *key, sfx_workspace *workspace)
+{
+	uint8_t maclen = packet->packetlen - SFX_UL_HEADERLEN - uplink->payloadlen;
+
+	sfx_uplink_get_mac(packet->packet, uplink->payloadlen, key, workspace->mac, &workspace->aes);
+
+	return renard_ct_equal(&packet->packet[packet->packetlen - maclen], workspace->mac, maclen) ? SFX_ULD_ERR_NONE : SFX_ULD_ERR_MAC_INVALID;
+}
+
+/**
+ * @brief retrieve contents of Sigfox uplink from given raw frame, resolving corrupted frame type fields by trial decoding
+ * Unlike ::sfx_uplink_decode, which only considers the frame type closest to the received one, all frame types of
+ * the frame class indicated by the frame length whose Hamming distance to the received frame type does not exceed
+ * `max_distance` are decoded in order of increasing distance (CRC first, MAC only if CRC is valid). The first valid
+ * interpretation is returned.
+ * @param to_decode the raw contents of the Sigfox uplink frame to decode, see ::sfx_uplink_decode
+ * @param uplink_out output, contents of Sigfox uplink frame, see ::sfx_uplink_decode
+ * @param common general information about the Sigfox object and its state, see ::sfx_uplink_decode
+ * @param check_mac whether to check the MAC, see ::sfx_uplink_decode
+ * @param max_distance maximum number of erroneous frame type bits, e.g. ::SFX_UL_FTYPE_TRIAL_DISTANCE
+ * @return ::SFX_ULD_ERR_NONE for the first valid interpretation, otherwise the error of the most plausible candidate
+ * (::SFX_ULD_ERR_MAC_INVALID before ::SFX_ULD_ERR_CRC_INVALID, lower distance first), outputs then belong to that candidate
+ */
+sfx_uld_err sfx_uplink_decode_trial(sfx_ul_encoded to_decode, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac, uint8_t max_distance)
+{
+	sfx_workspace workspace;
+	return sfx_uplink_decode_trial_ws(&to_decode, uplink_out, common, check_mac, max_distance, &workspace);
+}
+
+/**
+ * @brief decode frame with uncertain frame type, see ::sfx_uplink_decode_trial, using caller-provided scratch memory
+ * @param to_decode the raw contents of the Sigfox uplink frame to decode, see ::sfx_uplink_decode
+ * @param uplink_out output, contents of Sigfox uplink frame, see ::sfx_uplink_decode
+ * @param common general information about the Sigfox object and its state, see ::sfx_uplink_decode
+ * @param check_mac whether to check the MAC, see ::sfx_uplink_decode
+ * @param max_distance maximum number of erroneous frame type bits, e.g. ::SFX_UL_FTYPE_TRIAL_DISTANCE
+ * @param workspace scratch memory, see workspace.h
+ * @return see ::sfx_uplink_decode_trial
+ */
+sfx_uld_err sfx_uplink_decode_trial_ws(const sfx_ul_encoded *to_decode, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac, uint8_t max_distance, sfx_workspace *workspace)
+{
+	const uint8_t *frame = to_decode->frame[0];
+
+	if (to_decode->framelen_nibbles % 2 == 0)
+		return SFX_ULD_ERR_FRAMELEN_EVEN;
 
 	/*
-	 * Check CRC
-	 * CRC is calculated from the frame contents starting at the flags
+	 * Frame length determines frame class, only replica number is ambiguous
 	 */
-	uint8_t packet[SFX_UL_MAX_PACKETLEN];
-	uint8_t crc16_offset_nibbles = SFX_UL_FTYPELEN_NIBBLES + packetlen_bytes * 2;
+	uint8_t frameclass;
+	for (frameclass = 0; frameclass < SFX_UL_FRAMECLASSES; ++frameclass)
+		if (to_decode->framelen_nibbles == SFX_UL_FRAMELEN_NIBBLES(frametype_to_packetlen[frameclass]))
+			break;
 
-	memcpy_nibbles(packet, frame_plain, FLAGS_OFFSET_NIBBLES, 0, packetlen_bytes * 2);
+	if (frameclass == SFX_UL_FRAMECLASSES)
+		return SFX_ULD_ERR_FTYPE_MISMATCH;
 
-	uint16_t crc16 = ~renard_crc16(packet, packetlen_bytes);
-	uint16_t crc16_frame = getvalue_nibbles(frame_plain, crc16_offset_nibbles, SFX_UL_CRCLEN_NIBBLES);
+	/*
+	 * Candidates within distance, sorted by distance (stable, earlier transmissions first on ties)
+	 */
+	uint16_t frametype = ((frame[0] & 0xf0) << 4) | ((frame[0] & 0x0f) << 4) | ((frame[1] & 0xf0) >> 4);
+	uint8_t candidates[SFX_UL_TRANSMISSIONS];
+	uint8_t distances[SFX_UL_TRANSMISSIONS];
+	uint8_t count = 0;
+	uint8_t replica, i;
+
+	for (replica = 0; replica < SFX_UL_TRANSMISSIONS; ++replica) {
+		uint8_t distance = __builtin_popcount(frametypes[replica][frameclass] ^ frametype);
+		if (distance > max_distance)
+			continue;
 
-	if (crc16 != crc16_frame)
-		return SFX_ULD_ERR_CRC_INVALID;
+		for (i = count++; i > 0 && distances[i - 1] > distance; --i) {
+			candidates[i] = candidates[i - 1];
+			distances[i] = distances[i - 1];
+		}
+		candidates[i] = replica;
+		distances[i] = distance;
+	}
 
 	/*
-	 * Check MAC (optional)
+	 * Trial decoding, keep outputs of most plausible failed candidate
 	 */
-	if (check_mac) {
-		uint8_t mac[SFX_UL_MAX_MACLEN];
-		uint8_t maclen = sfx_uplink_get_mac(packet, uplink_out->payloadlen, common->key, mac);
+	sfx_uld_err best_err = SFX_ULD_ERR_FTYPE_MISMATCH;
+
+	for (i = 0; i < count; ++i) {
+		sfx_ul_plain *trial_uplink = &workspace->trial_uplink;
+		sfx_commoninfo *trial_common = &workspace->trial_common;
+		*trial_common = *common;
 
-		for (uint8_t i = 0; i < maclen; ++i)
-			if (packet[packetlen_bytes - maclen + i] != mac[i])
-				return SFX_ULD_ERR_MAC_INVALID;
+		sfx_uld_err err = sfx_uplink_class_decoders[candidates[i]][frameclass](frame, trial_uplink, trial_common, check_mac, workspace);
+
+		bool better = best_err == SFX_ULD_ERR_FTYPE_MISMATCH || (err == SFX_ULD_ERR_MAC_INVALID && best_err != SFX_ULD_ERR_MAC_INVALID);
+		if (err == SFX_ULD_ERR_NONE || better) {
+			*uplink_out = *trial_uplink;
+			*common = *trial_common;
+			best_err = err;
+		}
+
+		if (err == SFX_ULD_ERR_NONE)
+			break;
 	}
 
-	return SFX_ULD_ERR_NONE;
+	return best_err;
+}
+
+/**
+ * @brief prepare generation of the complete on-air bitstream (preamble, frame type, packet and CRC) of an uplink, for the initial transmission and, if requested, both replicas
+ * @param stream output, bitstream generator state, read from it using ::sfx_uplink_stream_read
+ * @param uplink the content of the payload to encode, sfx_ul_plain::replicas determines whether replica transmissions are generated
+ * @param common general information about the Sigfox object and its state
+ * @param dbpsk If true, output bits are differentially encoded for DBPSK modulation: The output bit represents the carrier phase, which is inverted for every `0` bit and kept for every `1` bit. The phase is reset to `0` at the start of every transmission.
+ * @return ::SFX_ULE_ERR_NONE if encoding was successful, otherwise some error defined in ::sfx_ule_err
+ * @attention Only the frame of the initial transmission is held in memory, replicas are convolutionally encoded while they are being read.
+ */
+sfx_ule_err sfx_uplink_stream_init(sfx_ul_stream *stream, sfx_ul_plain uplink, sfx_commoninfo common, bool dbpsk)
+{
+	sfx_workspace workspace;
+	return sfx_uplink_stream_init_ws(stream, &uplink, &common, dbpsk, &workspace);
+}
+
+/**
+ * @brief prepare generation of the on-air bitstream of an uplink, see ::sfx_uplink_stream_init, using caller-provided scratch memory
+ * @param stream output, bitstream generator state, read from it using ::sfx_uplink_stream_read
+ * @param uplink the content of the payload to encode, see ::sfx_uplink_stream_init
+ * @param common general information about the Sigfox object and its state
+ * @param dbpsk If true, output bits are differentially encoded for DBPSK modulation, see ::sfx_uplink_stream_init
+ * @param workspace scratch memory, see workspace.h, only used during this call
+ * @return ::SFX_ULE_ERR_NONE if encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_stream_init_ws(sfx_ul_stream *stream, const sfx_ul_plain *uplink, const sfx_commoninfo *common, bool dbpsk, sfx_workspace *workspace)
+{
+	sfx_ule_err err = sfx_uplink_check(uplink);
+	if (err != SFX_ULE_ERR_NONE)
+		return err;
+
+	stream->framelen_nibbles = sfx_uplink_build_frame(uplink, common, stream->frame, workspace);
+	stream->frameclass = sfx_uplink_frameclass(uplink);
+
+	stream->transmissions = uplink->replicas ? 3 : 1;
+	stream->transmission = 0;
+	stream->bitpos = 0;
+	stream->shiftregister = 0x00;
+	stream->dbpsk = dbpsk;
+	stream->phase = 0;
+
+	return SFX_ULE_ERR_NONE;
+}
+
+/**
+ * @brief generate the next bits of the current transmission's on-air bitstream
+ * @param stream bitstream generator state, initialized by ::sfx_uplink_stream_init
+ * @param out output buffer, bits are written MSB first starting at the MSB of `out[0]`, unused bits of the last byte are cleared
+ * @param bits maximum number of bits to generate, e.g. the free space in the radio's FIFO
+ * @return number of bits that were written to `out`, less than `bits` if the end of the current transmission was reached, 0 if the current transmission is complete
+ * @attention Never crosses the boundary between two transmissions, call ::sfx_uplink_stream_next to continue with the next replica.
+ */
+uint16_t sfx_uplink_stream_read(sfx_ul_stream *stream, uint8_t *out, uint16_t bits)
+{
+	uint16_t total_bits = (SFX_UL_PREAMBLELEN_NIBBLES + stream->framelen_nibbles) * 4;
+	uint16_t ftype = frametypes[stream->transmission][stream->frameclass];
+	uint16_t written = 0;
+
+	/*
+	 * Transmissions always consist of whole bytes: preamble and frame type fill bytes 0 - 3, packet and CRC are byte
+	 * i + 4. Output bytes are generated as a whole, coder state is only advanced once a byte is completely read, so
+	 * that reads can end anywhere within a byte.
+	 */
+	while (written < bits && stream->bitpos < total_bits) {
+		uint16_t index = stream->bitpos / 8;
+		uint8_t offset = stream->bitpos % 8;
+		uint8_t source = 0x00;
+		uint8_t coded;
+
+		if (index < 2) {
+			coded = SFX_UL_PREAMBLE[index];
+		} else if (index == 2) {
+			coded = (SFX_UL_PREAMBLE[2] & 0xf0) | (ftype >> 8);
+		} else if (index == 3) {
+			coded = ftype & 0xff;
+		} else {
+			source = (stream->frame[index - 3] << 4) | (stream->frame[index - 2] >> 4);
+
+			// Replicas: (7, 5) convolutional code, bytewise as in ::convcode_07 / ::convcode_05
+			uint16_t window = ((uint16_t)stream->shiftregister << 8) | source;
+			if (stream->transmission == 1)
+				coded = window ^ (window >> 1) ^ (window >> 2);
+			else if (stream->transmission == 2)
+				coded = window ^ (window >> 2);
+			else
+				coded = source;
+		}
+
+		if (stream->dbpsk) {
+			// phase is inverted for every `0` bit: prefix XOR over inverted bits, starting at the MSB
+			coded = ~coded;
+			coded ^= coded >> 1;
+			coded ^= coded >> 2;
+			coded ^= coded >> 4;
+			coded ^= stream->phase ? 0xff : 0x00;
+		}
+
+		uint8_t count = 8 - offset;
+		if (count > bits - written)
+			count = bits - written;
+
+		// append `count` bits of `coded` starting at bit `offset` (from MSB) to output
+		uint8_t chunk = (uint8_t)(coded << offset) & (uint8_t)(0xff << (8 - count));
+		uint8_t shift = written % 8;
+		if (shift == 0)
+			out[written / 8] = chunk;
+		else
+			out[written / 8] |= chunk >> shift;
+		if (shift + count > 8)
+			out[written / 8 + 1] = chunk << (8 - shift);
+
+		written += count;
+		stream->bitpos += count;
+
+		if (stream->bitpos % 8 == 0) {
+			stream->shiftregister = source;
+			stream->phase = coded & 0x01;
+		}
+	}
+
+	return written;
+}
+
+/**
+ * @brief continue bitstream generation with the next transmission (replica)
+ * @param stream bitstream generator state, initialized by ::sfx_uplink_stream_init
+ * @return true if there is another transmission to generate, false if all transmissions are complete
+ */
+bool sfx_uplink_stream_next(sfx_ul_stream *stream)
+{
+	if (stream->transmission + 1 >= stream->transmissions)
+		return false;
+
+	stream->transmission++;
+	stream->bitpos = 0;
+	stream->shiftregister = 0x00;
+	stream->phase = 0;
+
+	return true;
+}
+
+/**
+ * @brief generate the complete on-air bitstream (preamble, frame type, packet and CRC) of an uplink in a single pass, without intermediate ::sfx_ul_encoded buffer
+ * @param uplink the content of the payload to encode, sfx_ul_plain::replicas determines whether replica transmissions are generated
+ * @param common general information about the Sigfox object and its state
+ * @param dbpsk If true, output is differentially encoded for DBPSK modulation, see ::sfx_uplink_stream_init
+ * @param onair output, transmissions are stored back to back, each of them `*onairlen_bytes` long; must provide space for 3 * ::SFX_UL_MAX_ONAIRLEN bytes if replicas are requested, otherwise ::SFX_UL_MAX_ONAIRLEN bytes
+ * @param onairlen_bytes output, length of a single transmission (preamble and frame) in bytes
+ * @return ::SFX_ULE_ERR_NONE if encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_encode_onair(sfx_ul_plain uplink, sfx_commoninfo common, bool dbpsk, uint8_t *onair, uint8_t *onairlen_bytes)
+{
+	sfx_workspace workspace;
+	return sfx_uplink_encode_onair_ws(&uplink, &common, dbpsk, onair, onairlen_bytes, &workspace);
+}
+
+/**
+ * @brief generate the complete on-air bitstream of an uplink in a single pass, see ::sfx_uplink_encode_onair, using caller-provided scratch memory
+ * @param uplink the content of the payload to encode, see ::sfx_uplink_encode_onair
+ * @param common general information about the Sigfox object and its state
+ * @param dbpsk If true, output is differentially encoded for DBPSK modulation, see ::sfx_uplink_stream_init
+ * @param onair output, transmissions are stored back to back, see ::sfx_uplink_encode_onair
+ * @param onairlen_bytes output, length of a single transmission (preamble and frame) in bytes
+ * @param workspace scratch memory, see workspace.h
+ * @return ::SFX_ULE_ERR_NONE if encoding was successful, otherwise some error defined in ::sfx_ule_err
+ */
+sfx_ule_err sfx_uplink_encode_onair_ws(const sfx_ul_plain *uplink, const sfx_commoninfo *common, bool dbpsk, uint8_t *onair, uint8_t *onairlen_bytes, sfx_workspace *workspace)
+{
+	sfx_ul_stream stream;
+	sfx_ule_err err = sfx_uplink_stream_init_ws(&stream, uplink, common, dbpsk, workspace);
+	if (err != SFX_ULE_ERR_NONE)
+		return err;
+
+	*onairlen_bytes = (SFX_UL_PREAMBLELEN_NIBBLES + stream.framelen_nibbles) / 2;
+
+	do {
+		sfx_uplink_stream_read(&stream, onair, *onairlen_bytes * 8);
+		onair += *onairlen_bytes;
+	} while (sfx_uplink_stream_next(&stream));
+
+	return SFX_ULE_ERR_NONE;
 }
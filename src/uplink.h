@@ -30,7 +30,7 @@
 /*
  * Public Interface:
  */
-extern uint8_t SFX_UL_PREAMBLE[];
+extern const uint8_t SFX_UL_PREAMBLE[];
 
 /// length of Sigfox's uplink preamble, in nibbles
 #define SFX_UL_PREAMBLELEN_NIBBLES 5
@@ -77,7 +77,10 @@ typedef enum _s_sfx_ule_err {
 	SFX_ULE_ERR_PAYLOAD_TOO_LONG,
 
 	/// single-bit uplink was transmitted, but payload length was not defined to be 0
-	SFX_ULE_SINGLEBIT_MISMATCH
+	SFX_ULE_SINGLEBIT_MISMATCH,
+
+	/// payload length was 0, but uplink was not defined to be single-bit; empty uplinks are not supported
+	SFX_ULE_ERR_PAYLOAD_EMPTY
 } sfx_ule_err;
 
 /**
@@ -98,9 +101,184 @@ typedef enum _s_sfx_uld_err {
 
 	/// frame's MAC doesn't match MAC computed from frame contents (and private key); can only occur if `check_mac` parameter to ::sfx_uplink_decode is set
 	SFX_ULD_ERR_MAC_INVALID,
+
+	/// incremental decoding only: frame is not yet complete, see ::sfx_uplink_decoder_result
+	SFX_ULD_ERR_INCOMPLETE,
 } sfx_uld_err;
 
+/// suggested maximum frame type distance for ::sfx_uplink_decode_trial; the frame types of one frame class differ in at least 5 bits
+#define SFX_UL_FTYPE_TRIAL_DISTANCE 4
+
+/// maximum length of a single on-air transmission (preamble and frame), in bytes; preamble and frame together always have an even number of nibbles
+#define SFX_UL_MAX_ONAIRLEN ((SFX_UL_PREAMBLELEN_NIBBLES + SFX_UL_MAX_FRAMELEN * 2 - 1) / 2)
+
+/**
+ * @brief state of an on-air bitstream generator for uplink transmissions, see ::sfx_uplink_stream_init
+ */
+typedef struct _s_sfx_ul_stream {
+	/// frame of initial transmission without preamble, replicas are derived from it on the fly
+	uint8_t frame[SFX_UL_MAX_FRAMELEN];
+
+	/// length of frame in nibbles, excluding preamble
+	uint8_t framelen_nibbles;
+
+	/// frame class (column in frame type table) of frame
+	uint8_t frameclass;
+
+	/// number of transmissions to generate, 1 (initial transmission only) or 3 (initial transmission and replicas)
+	uint8_t transmissions;
+
+	/// index of transmission that is currently being generated
+	uint8_t transmission;
+
+	/// position inside current transmission (including preamble), in bits
+	uint16_t bitpos;
+
+	/// state of convolutional coder for replica transmissions: last completely read packet byte of current transmission
+	uint8_t shiftregister;
+
+	/// indicates whether output bits are DBPSK-differentially encoded
+	bool dbpsk;
+
+	/// last output bit of last completely read byte (current phase) if output is DBPSK-differentially encoded
+	uint8_t phase;
+} sfx_ul_stream;
+
+/**
+ * @brief partially or completely pre-encoded uplink frame for an upcoming sequence number, see ::sfx_uplink_precompute
+ */
+typedef struct _s_sfx_ul_precomputed {
+	/// byte-aligned packet (flags, SN, device ID, payload, MAC) followed by CRC, flags, SN and device ID are prepared in advance
+	uint8_t packet[SFX_UL_MAX_PACKETLEN + SFX_UL_CRCLEN_NIBBLES / 2];
+
+	/// NAK of Sigfox object, required for MAC calculation during ::sfx_uplink_finalize
+	uint8_t key[16];
+
+	/// sequence number the frame was prepared for
+	uint16_t seqnum;
+
+	/// length of payload, fixed when pre-encoding
+	uint8_t payloadlen;
+
+	/// frame class (column in frame type table) of frame
+	uint8_t frameclass;
+
+	/// indicates whether replica frames are generated
+	bool replicas;
+
+	/// indicates whether `encoded` already contains the complete frame for a fixed payload
+	bool complete;
+
+	/// complete frame if `complete` is set
+	sfx_ul_encoded encoded;
+} sfx_ul_precomputed;
+
+/**
+ * @brief state of an incremental uplink decoder that is fed bits as they are received, see ::sfx_uplink_decoder_init
+ */
+typedef struct _s_sfx_ul_decoder {
+	/// byte-aligned packet (flags, SN, device ID, payload, MAC) followed by CRC, convolutional code of replicas already undone
+	uint8_t packet[SFX_UL_MAX_PACKETLEN + 2];
+
+	/// MAC computed from authenticated data, valid once `mac_done` is set
+	uint8_t mac[SFX_UL_MAX_MACLEN];
+
+	/// NAK of Sigfox object, valid if `has_key` is set
+	uint8_t key[16];
+
+	/// number of complete nibbles received so far, excluding preamble
+	uint8_t nibbles;
+
+	/// bits of nibble that is currently being received, MSB first
+	uint8_t current;
+
+	/// number of bits of nibble that is currently being received
+	uint8_t currentbits;
+
+	/// frame type value, first 3 nibbles
+	uint16_t frametype;
+
+	/// frame length in nibbles as indicated by frame type, 0 while frame type is not yet known
+	uint8_t framelen_nibbles;
+
+	/// frame class and transmission number (0: initial transmission, 1 / 2: replicas) as indicated by frame type
+	uint8_t frameclass;
+	uint8_t replica;
+
+	/// packet length (excluding CRC) as indicated by frame type, in bytes
+	uint8_t packetlen;
+
+	/// number of complete bytes in `packet`
+	uint8_t packetbytes;
+
+	/// state of convolutional decoder for replicas
+	uint8_t unconv_state;
+
+	/// CRC-16 remainder over complete packet bytes
+	uint16_t crc;
+
+	/// MAC length and payload length as indicated by flags, valid once first packet byte is complete
+	uint8_t maclen;
+	uint8_t payloadlen;
+
+	/// indicates whether a NAK was provided (MAC is checked)
+	bool has_key;
+
+	/// indicates whether MAC has already been computed
+	bool mac_done;
+
+	/// indicates whether decoding is finished, further bits are ignored
+	bool finished;
+
+	/// result, valid once `finished` is set
+	sfx_uld_err status;
+} sfx_ul_decoder;
+
+/**
+ * @brief frame header of a raw uplink frame as obtained by ::sfx_uplink_peek, *not* protected by CRC or MAC check
+ */
+typedef struct _s_sfx_ul_header {
+	/// device ID and sequence number
+	uint32_t devid;
+	uint16_t seqnum;
+
+	/// frame class (0: single bit, 1 - 4: 1 / 4 / 8 / 12 byte payload) and transmission number (0: initial transmission, 1 / 2: replicas) as indicated by frame type
+	uint8_t frameclass;
+	uint8_t replica;
+} sfx_ul_header;
+
+/**
+ * @brief byte-aligned packet of an uplink decoded by ::sfx_uplink_decode_batch, for a subsequent MAC check with ::sfx_uplink_check_mac
+ */
+typedef struct _s_sfx_ul_packet {
+	/// packet (flags, SN, device ID, payload, MAC) followed by CRC, convolutional code of replicas already undone
+	uint8_t packet[SFX_UL_MAX_PACKETLEN + SFX_UL_CRCLEN_NIBBLES / 2];
+
+	/// length of packet excluding CRC in bytes, 0 if the frame could not be decoded
+	uint8_t packetlen;
+} sfx_ul_packet;
+
 sfx_ule_err sfx_uplink_encode(sfx_ul_plain uplink, sfx_commoninfo common, sfx_ul_encoded *encoded);
+sfx_ule_err sfx_uplink_precompute(sfx_ul_plain uplink, sfx_commoninfo common, bool fixed_payload, sfx_ul_precomputed *precomputed);
+sfx_ule_err sfx_uplink_precompute_window(sfx_ul_plain uplink, sfx_commoninfo common, bool fixed_payload, sfx_ul_precomputed *precomputed, uint16_t count);
+sfx_ule_err sfx_uplink_finalize(sfx_ul_precomputed *precomputed, const uint8_t *payload, sfx_ul_encoded *encoded);
 sfx_uld_err sfx_uplink_decode(sfx_ul_encoded to_decode, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac);
+sfx_uld_err sfx_uplink_decode_trial(sfx_ul_encoded to_decode, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac, uint8_t max_distance);
+void sfx_uplink_decode_batch(const sfx_ul_encoded *const to_decode[], uint16_t count, sfx_ul_plain uplinks_out[], sfx_commoninfo commons[], sfx_ul_packet packets[], sfx_uld_err status[]);
+sfx_uld_err sfx_uplink_check_mac(const sfx_ul_packet *packet, const sfx_ul_plain *uplink, const uint8_t *key);
+
+sfx_ule_err sfx_uplink_stream_init(sfx_ul_stream *stream, sfx_ul_plain uplink, sfx_commoninfo common, bool dbpsk);
+uint16_t sfx_uplink_stream_read(sfx_ul_stream *stream, uint8_t *out, uint16_t bits);
+bool sfx_uplink_stream_next(sfx_ul_stream *stream);
+sfx_ule_err sfx_uplink_encode_onair(sfx_ul_plain uplink, sfx_commoninfo common, bool dbpsk, uint8_t *onair, uint8_t *onairlen_bytes);
+
+void sfx_uplink_decoder_init(sfx_ul_decoder *decoder, const uint8_t *key);
+void sfx_uplink_decoder_set_key(sfx_ul_decoder *decoder, const uint8_t *key);
+bool sfx_uplink_decoder_push_bits(sfx_ul_decoder *decoder, uint32_t bits, uint8_t count);
+bool sfx_uplink_decoder_push_nibble(sfx_ul_decoder *decoder, uint8_t nibble);
+bool sfx_uplink_decoder_devid(const sfx_ul_decoder *decoder, uint32_t *devid);
+sfx_uld_err sfx_uplink_decoder_result(const sfx_ul_decoder *decoder, sfx_ul_plain *uplink_out, sfx_commoninfo *common);
+
+sfx_uld_err sfx_uplink_peek(const sfx_ul_encoded *encoded, sfx_ul_header *header);
 
 #endif
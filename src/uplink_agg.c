@@ -0,0 +1,263 @@
+#include <string.h>
+
+#include "uplink_agg.h"
+#include "uplink.h"
+
+/*
+ * Replica aggregator
+ * Groups are found through a hash table with chaining (key: device ID and sequence number) and expire through a
+ * single-level hashed timing wheel: a group is inserted into the slot of the tick at which its timeout expires, and
+ * since the timeout is shorter than the wheel, every slot only ever contains groups that expire at the tick that is
+ * being processed. Hash chains are doubly linked, so that insertion and expiry are O(1), groups and copies come from
+ * caller-provided pools with free lists.
+ * Groups that are emitted as complete stay in the table until their timeout, so that late copies of an uplink do
+ * not open a new group and are not emitted a second time.
+ */
+
+/// bit mask of ::sfx_ul_agg_group.replicas if all transmissions have been received
+#define SFX_UL_AGG_ALL_REPLICAS 0x07
+
+static uint32_t sfx_uplink_agg_hash(uint32_t devid, uint16_t seqnum)
+{
+	uint32_t hash = (devid ^ (seqnum * 0x9e3779b1)) * 0x85ebca6b;
+	return hash ^ (hash >> 16);
+}
+
+static bool sfx_uplink_agg_power_of_two(uint32_t value)
+{
+	return value != 0 && (value & (value - 1)) == 0;
+}
+
+/**
+ * @brief initialize replica aggregator
+ * @param agg aggregator to initialize
+ * @param groups caller-provided memory for `group_capacity` groups, i.e. the maximum number of active groups
+ * @param group_capacity number of groups
+ * @param copies caller-provided memory for `copy_capacity` frames, shared by all active groups
+ * @param copy_capacity number of frames
+ * @param buckets caller-provided hash table memory for `bucket_count` indices
+ * @param bucket_count number of hash buckets, must be a power of two, e.g. at least `group_capacity`
+ * @param wheel caller-provided timing wheel memory for `wheel_slots` indices
+ * @param wheel_slots number of timing wheel slots, must be a power of two and greater than `timeout`
+ * @param timeout number of ticks (see ::sfx_uplink_agg_advance) after the first frame of a group at which the group is emitted if not complete, at least 1
+ * @param min_copies minimum number of frames of a complete group: a group is complete once all three transmissions
+ * have been received and it contains at least `min_copies` frames, e.g. three times the number of gateways that
+ * usually receive a device. If `min_copies` exceeds ::SFX_UL_AGG_MAX_COPIES, groups only ever expire.
+ * @param emit emit callback, must not call ::sfx_uplink_agg_push or ::sfx_uplink_agg_advance
+ * @param context context pointer passed to `emit`
+ * @return false if a capacity, the number of buckets / slots or the timeout is invalid
+ */
+bool sfx_uplink_agg_init(sfx_ul_agg *agg, sfx_ul_agg_group *groups, uint32_t group_capacity, sfx_ul_agg_copy *copies, uint32_t copy_capacity, uint32_t *buckets, uint32_t bucket_count, uint32_t *wheel, uint32_t wheel_slots, uint32_t timeout, uint8_t min_copies, sfx_ul_agg_emit emit, void *context)
+{
+	uint32_t i;
+
+	if (group_capacity == 0 || group_capacity == SFX_UL_AGG_NONE || copy_capacity == 0 || copy_capacity == SFX_UL_AGG_NONE)
+		return false;
+
+	if (!sfx_uplink_agg_power_of_two(bucket_count) || !sfx_uplink_agg_power_of_two(wheel_slots))
+		return false;
+
+	if (timeout == 0 || timeout >= wheel_slots)
+		return false;
+
+	memset(agg, 0, sizeof(*agg));
+	agg->groups = groups;
+	agg->group_capacity = group_capacity;
+	agg->copies = copies;
+	agg->copy_capacity = copy_capacity;
+	agg->buckets = buckets;
+	agg->bucket_mask = bucket_count - 1;
+	agg->wheel = wheel;
+	agg->wheel_mask = wheel_slots - 1;
+	agg->timeout = timeout;
+	agg->min_copies = min_copies;
+	agg->emit = emit;
+	agg->context = context;
+
+	memset(buckets, 0xff, bucket_count * sizeof(*buckets));
+	memset(wheel, 0xff, wheel_slots * sizeof(*wheel));
+
+	for (i = 0; i < group_capacity; ++i)
+		groups[i].wheel_next = i + 1 < group_capacity ? i + 1 : SFX_UL_AGG_NONE;
+	agg->free_groups = 0;
+
+	for (i = 0; i < copy_capacity; ++i)
+		copies[i].next = i + 1 < copy_capacity ? i + 1 : SFX_UL_AGG_NONE;
+	agg->free_copies = 0;
+
+	return true;
+}
+
+/**
+ * @brief call emit callback for a group and return its copies to the free list
+ */
+static void sfx_uplink_agg_emit_group(sfx_ul_agg *agg, sfx_ul_agg_group *group, uint8_t reason)
+{
+	const sfx_ul_agg_copy *list[SFX_UL_AGG_MAX_COPIES];
+	uint32_t index;
+	uint8_t count = 0;
+
+	for (index = group->copies; index != SFX_UL_AGG_NONE; index = agg->copies[index].next)
+		list[count++] = &agg->copies[index];
+
+	if (agg->emit)
+		agg->emit(agg->context, group, list, reason);
+
+	if (group->copies != SFX_UL_AGG_NONE) {
+		agg->copies[group->last].next = agg->free_copies;
+		agg->free_copies = group->copies;
+		group->copies = SFX_UL_AGG_NONE;
+	}
+}
+
+/**
+ * @brief add a frame to the group of its device ID and sequence number at the current tick, a new group is opened
+ * for the first frame; emits the group if it is complete now
+ * @param agg replica aggregator
+ * @param encoded raw frame, only first frame is used
+ * @param tag caller-defined identifier of frame, passed back in ::sfx_ul_agg_copy
+ * @return false if the frame was not added: header could not be read, group has already been emitted as complete,
+ * or group / copy memory is exhausted (see ::sfx_ul_agg_stats)
+ */
+bool sfx_uplink_agg_push(sfx_ul_agg *agg, const sfx_ul_encoded *encoded, uint32_t tag)
+{
+	sfx_ul_header header;
+	sfx_ul_agg_group *group = NULL;
+	uint32_t index;
+
+	agg->stats.pushed++;
+
+	if (sfx_uplink_peek(encoded, &header) != SFX_ULD_ERR_NONE) {
+		agg->stats.invalid++;
+		return false;
+	}
+
+	uint32_t bucket = sfx_uplink_agg_hash(header.devid, header.seqnum) & agg->bucket_mask;
+	for (index = agg->buckets[bucket]; index != SFX_UL_AGG_NONE; index = agg->groups[index].hash_next) {
+		if (agg->groups[index].devid == header.devid && agg->groups[index].seqnum == header.seqnum) {
+			group = &agg->groups[index];
+			break;
+		}
+	}
+
+	if (group && group->closed) {
+		agg->stats.late++;
+		return false;
+	}
+
+	if (agg->free_copies == SFX_UL_AGG_NONE || (group && group->count == SFX_UL_AGG_MAX_COPIES) || (!group && agg->free_groups == SFX_UL_AGG_NONE)) {
+		agg->stats.dropped++;
+		return false;
+	}
+
+	// open new group, expires `timeout` ticks from now
+	if (!group) {
+		index = agg->free_groups;
+		group = &agg->groups[index];
+		agg->free_groups = group->wheel_next;
+
+		group->devid = header.devid;
+		group->seqnum = header.seqnum;
+		group->replicas = 0;
+		group->count = 0;
+		group->first = agg->now;
+		group->copies = SFX_UL_AGG_NONE;
+		group->last = SFX_UL_AGG_NONE;
+		group->closed = false;
+
+		group->hash_next = agg->buckets[bucket];
+		group->hash_prev = SFX_UL_AGG_NONE;
+		if (group->hash_next != SFX_UL_AGG_NONE)
+			agg->groups[group->hash_next].hash_prev = index;
+		agg->buckets[bucket] = index;
+
+		uint32_t slot = (agg->now + agg->timeout) & agg->wheel_mask;
+		group->wheel_next = agg->wheel[slot];
+		agg->wheel[slot] = index;
+
+		agg->active++;
+	}
+
+	// append copy
+	index = agg->free_copies;
+	sfx_ul_agg_copy *copy = &agg->copies[index];
+	agg->free_copies = copy->next;
+
+	memcpy(copy->frame, encoded->frame[0], SFX_UL_MAX_FRAMELEN);
+	copy->framelen_nibbles = encoded->framelen_nibbles;
+	copy->replica = header.replica;
+	copy->tag = tag;
+	copy->next = SFX_UL_AGG_NONE;
+
+	if (group->copies == SFX_UL_AGG_NONE)
+		group->copies = index;
+	else
+		agg->copies[group->last].next = index;
+	group->last = index;
+
+	group->replicas |= 1 << header.replica;
+	group->count++;
+
+	if (group->replicas == SFX_UL_AGG_ALL_REPLICAS && group->count >= agg->min_copies) {
+		sfx_uplink_agg_emit_group(agg, group, SFX_UL_AGG_EMIT_COMPLETE);
+		group->closed = true;
+		agg->stats.complete++;
+	}
+
+	return true;
+}
+
+/**
+ * @brief remove all groups of a timing wheel slot, emitting those that have not been emitted as complete
+ */
+static void sfx_uplink_agg_expire_slot(sfx_ul_agg *agg, uint32_t slot)
+{
+	uint32_t index = agg->wheel[slot];
+	agg->wheel[slot] = SFX_UL_AGG_NONE;
+
+	while (index != SFX_UL_AGG_NONE) {
+		sfx_ul_agg_group *group = &agg->groups[index];
+		uint32_t next = group->wheel_next;
+
+		// unlink from hash bucket
+		if (group->hash_prev == SFX_UL_AGG_NONE)
+			agg->buckets[sfx_uplink_agg_hash(group->devid, group->seqnum) & agg->bucket_mask] = group->hash_next;
+		else
+			agg->groups[group->hash_prev].hash_next = group->hash_next;
+		if (group->hash_next != SFX_UL_AGG_NONE)
+			agg->groups[group->hash_next].hash_prev = group->hash_prev;
+
+		if (!group->closed) {
+			sfx_uplink_agg_emit_group(agg, group, SFX_UL_AGG_EMIT_TIMEOUT);
+			agg->stats.expired++;
+		}
+
+		group->wheel_next = agg->free_groups;
+		agg->free_groups = index;
+		agg->active--;
+
+		index = next;
+	}
+}
+
+/**
+ * @brief advance time to the given tick and emit all groups whose timeout expired in the meantime; tick duration is
+ * up to the caller (e.g. 100 ms), the tick counter may wrap around
+ * @param agg replica aggregator
+ * @param now current tick, must not be earlier than the tick of the previous call
+ */
+void sfx_uplink_agg_advance(sfx_ul_agg *agg, uint32_t now)
+{
+	uint32_t ticks = now - agg->now;
+
+	// all groups expire within one revolution of the wheel
+	if (ticks > agg->wheel_mask + 1)
+		ticks = agg->wheel_mask + 1;
+
+	while (ticks-- > 0) {
+		agg->now++;
+		sfx_uplink_agg_expire_slot(agg, agg->now & agg->wheel_mask);
+	}
+
+	agg->now = now;
+}
@@ -0,0 +1,160 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "uplink.h"
+
+#ifndef _UPLINK_AGG_H
+#define _UPLINK_AGG_H
+
+/*
+ * Replica aggregator: groups raw uplink frames by device ID and sequence number (see ::sfx_uplink_peek), so that the
+ * initial transmission, the replicas and copies received by different gateways can be decoded or combined together.
+ * Groups are held in a hashed timing wheel and emitted once complete or when their timeout expires. All memory is
+ * provided by the caller on initialization.
+ */
+
+/// maximum number of frames per group, further copies are dropped
+#define SFX_UL_AGG_MAX_COPIES 16
+
+/// index that marks the end of a list / an empty bucket
+#define SFX_UL_AGG_NONE 0xffffffff
+
+/// group is emitted because all transmissions (and the requested number of copies) have been received
+#define SFX_UL_AGG_EMIT_COMPLETE 0
+
+/// group is emitted because its timeout expired
+#define SFX_UL_AGG_EMIT_TIMEOUT 1
+
+/**
+ * @brief single received frame of a group
+ */
+typedef struct _s_sfx_ul_agg_copy {
+	/// raw frame as received, *without* preamble
+	uint8_t frame[SFX_UL_MAX_FRAMELEN];
+
+	/// length of frame in nibbles
+	uint8_t framelen_nibbles;
+
+	/// transmission number as indicated by frame type, see ::sfx_ul_header
+	uint8_t replica;
+
+	/// caller-defined identifier of frame, e.g. gateway or index in capture
+	uint32_t tag;
+
+	/// next copy of the same group / next free copy
+	uint32_t next;
+} sfx_ul_agg_copy;
+
+/**
+ * @brief group of frames with the same device ID and sequence number
+ */
+typedef struct _s_sfx_ul_agg_group {
+	/// device ID and sequence number of all frames in group
+	uint32_t devid;
+	uint16_t seqnum;
+
+	/// bit i is set if transmission i has been received
+	uint8_t replicas;
+
+	/// number of copies in group
+	uint8_t count;
+
+	/// tick at which the first frame of the group was received
+	uint32_t first;
+
+	/// first copy of group, in order of reception
+	uint32_t copies;
+
+	/// last copy of group
+	uint32_t last;
+
+	/// next / previous group in hash bucket, doubly linked so that expired groups are unlinked in O(1)
+	uint32_t hash_next;
+	uint32_t hash_prev;
+
+	/// next group in timing wheel slot / next free group
+	uint32_t wheel_next;
+
+	/// indicates whether group has already been emitted as complete, it is kept until its timeout to absorb late copies
+	bool closed;
+} sfx_ul_agg_group;
+
+/**
+ * @brief emit callback, called for every group once, from ::sfx_uplink_agg_push or ::sfx_uplink_agg_advance
+ * @param context context pointer passed to ::sfx_uplink_agg_init
+ * @param group group that is emitted
+ * @param copies frames of group in order of reception, only valid during callback
+ * @param reason SFX_UL_AGG_EMIT_*
+ */
+typedef void (*sfx_ul_agg_emit)(void *context, const sfx_ul_agg_group *group, const sfx_ul_agg_copy *const copies[], uint8_t reason);
+
+/**
+ * @brief counters of replica aggregator
+ */
+typedef struct _s_sfx_ul_agg_stats {
+	/// number of frames passed to ::sfx_uplink_agg_push
+	uint64_t pushed;
+
+	/// number of frames whose header could not be read (frame length does not match frame type)
+	uint64_t invalid;
+
+	/// number of frames that arrived after their group has been emitted as complete
+	uint64_t late;
+
+	/// number of frames that were dropped because no group / copy was available or the group was full
+	uint64_t dropped;
+
+	/// number of groups emitted as complete / because of timeout
+	uint64_t complete;
+	uint64_t expired;
+} sfx_ul_agg_stats;
+
+/**
+ * @brief replica aggregator, see ::sfx_uplink_agg_init
+ */
+typedef struct _s_sfx_ul_agg {
+	/// caller-provided group memory
+	sfx_ul_agg_group *groups;
+	uint32_t group_capacity;
+
+	/// caller-provided copy memory
+	sfx_ul_agg_copy *copies;
+	uint32_t copy_capacity;
+
+	/// caller-provided hash buckets, number of buckets is a power of two
+	uint32_t *buckets;
+	uint32_t bucket_mask;
+
+	/// caller-provided timing wheel, one list of groups per slot, number of slots is a power of two
+	uint32_t *wheel;
+	uint32_t wheel_mask;
+
+	/// free lists of groups / copies
+	uint32_t free_groups;
+	uint32_t free_copies;
+
+	/// number of groups in use
+	uint32_t active;
+
+	/// current tick, see ::sfx_uplink_agg_advance
+	uint32_t now;
+
+	/// number of ticks after the first frame of a group at which the group is emitted
+	uint32_t timeout;
+
+	/// minimum number of copies of a complete group, in addition to all three transmissions
+	uint8_t min_copies;
+
+	/// emit callback
+	sfx_ul_agg_emit emit;
+	void *context;
+
+	/// counters
+	sfx_ul_agg_stats stats;
+} sfx_ul_agg;
+
+bool sfx_uplink_agg_init(sfx_ul_agg *agg, sfx_ul_agg_group *groups, uint32_t group_capacity, sfx_ul_agg_copy *copies, uint32_t copy_capacity, uint32_t *buckets, uint32_t bucket_count, uint32_t *wheel, uint32_t wheel_slots, uint32_t timeout, uint8_t min_copies, sfx_ul_agg_emit emit, void *context);
+bool sfx_uplink_agg_push(sfx_ul_agg *agg, const sfx_ul_encoded *encoded, uint32_t tag);
+void sfx_uplink_agg_advance(sfx_ul_agg *agg, uint32_t now);
+
+#endif
@@ -0,0 +1,629 @@
+#include <string.h>
+
+#include "constant_time.h"
+#include "sigfox_crc.h"
+#include "thumb_kernels.h"
+#include "uplink_class.h"
+#include "uplink.h"
+#include "common.h"
+
+/*
+ * Frame class specialized encoders / decoders
+ * The generic implementation is expanded for every frame class (and replica) by the macros below,
+ * so that packet length, frame length, offsets and loop bounds are compile-time constants.
+ * Instead of processing the frame nibble by nibble, the packet is realigned to byte boundaries once,
+ * which allows for bytewise convolutional coding.
+ */
+
+/**
+ * @brief bytewise convolutional coder for generator polynomial 07 (see ::convcode), in place
+ * @param buffer byte-aligned data to encode
+ * @param length length of buffer in bytes
+ */
+static RENARD_CLASS_INLINE void convcode_07(uint8_t *buffer, const uint8_t length)
+{
+#ifdef RENARD_THUMB_KERNELS
+	renard_convcode_thumb(buffer, length, 0x07);
+#else
+	uint16_t window = 0x0000;
+	for (uint8_t i = 0; i < length; ++i) {
+		window = (window << 8) | buffer[i];
+		buffer[i] = window ^ (window >> 1) ^ (window >> 2);
+	}
+#endif
+}
+
+/**
+ * @brief bytewise convolutional coder for generator polynomial 05 (see ::convcode), in place
+ * @param buffer byte-aligned data to encode
+ * @param length length of buffer in bytes
+ */
+static RENARD_CLASS_INLINE void convcode_05(uint8_t *buffer, const uint8_t length)
+{
+#ifdef RENARD_THUMB_KERNELS
+	renard_convcode_thumb(buffer, length, 0x05);
+#else
+	uint16_t window = 0x0000;
+	for (uint8_t i = 0; i < length; ++i) {
+		window = (window << 8) | buffer[i];
+		buffer[i] = window ^ (window >> 2);
+	}
+#endif
+}
+
+/**
+ * @brief inverse of ::convcode_07 for a single byte
+ * Division by G(X) = 1 + X + X^2 is equivalent to multiplication with 1 + X followed by division by 1 + X^3,
+ * the latter is a prefix XOR over every third bit.
+ * @param in coded byte
+ * @param state decoder state carried between bytes, 0 before the first byte
+ * @return decoded byte
+ */
+static RENARD_CLASS_INLINE uint8_t unconvcode_07_byte(uint8_t in, uint8_t *state)
+{
+	uint32_t window = ((uint32_t)(*state & 0x07) << 8) | (uint8_t)(in ^ (in >> 1) ^ ((*state >> 3) << 7));
+	window ^= window >> 3;
+	window ^= window >> 6;
+	window ^= window >> 12;
+	*state = (window & 0x07) | ((in & 0x01) << 3);
+	return window;
+}
+
+/**
+ * @brief inverse of ::convcode_05 for a single byte
+ * Division by G(X) = 1 + X^2 is a prefix XOR over every second bit.
+ * @param in coded byte
+ * @param state decoder state carried between bytes, 0 before the first byte
+ * @return decoded byte
+ */
+static RENARD_CLASS_INLINE uint8_t unconvcode_05_byte(uint8_t in, uint8_t *state)
+{
+	uint16_t window = ((uint16_t)*state << 8) | in;
+	window ^= window >> 2;
+	window ^= window >> 4;
+	window ^= window >> 8;
+	*state = window & 0x03;
+	return window;
+}
+
+/**
+ * @brief bytewise inverse of ::convcode_07, in place
+ * @param buffer byte-aligned data to decode
+ * @param length length of buffer in bytes
+ */
+static RENARD_CLASS_INLINE void unconvcode_07(uint8_t *buffer, const uint8_t length)
+{
+	uint8_t state = 0x00;
+	for (uint8_t i = 0; i < length; ++i)
+		buffer[i] = unconvcode_07_byte(buffer[i], &state);
+}
+
+/**
+ * @brief bytewise inverse of ::convcode_05, in place
+ * @param buffer byte-aligned data to decode
+ * @param length length of buffer in bytes
+ */
+static RENARD_CLASS_INLINE void unconvcode_05(uint8_t *buffer, const uint8_t length)
+{
+	uint8_t state = 0x00;
+	for (uint8_t i = 0; i < length; ++i)
+		buffer[i] = unconvcode_05_byte(buffer[i], &state);
+}
+
+/**
+ * @brief write frame type and byte-aligned packet (including CRC) to frame buffer, shifting the packet by the frame type's odd nibble count
+ * @param frame output frame buffer
+ * @param ftype frame type value
+ * @param packet byte-aligned packet followed by CRC
+ * @param length length of `packet` in bytes
+ */
+static RENARD_CLASS_INLINE void sfx_uplink_class_pack(uint8_t *frame, uint16_t ftype, uint8_t *packet, const uint8_t length)
+{
+	frame[0] = ftype >> 4;
+	frame[1] = ((ftype & 0x0f) << 4) | (packet[0] >> 4);
+	for (uint8_t i = 1; i < length; ++i)
+		frame[i + 1] = (packet[i - 1] << 4) | (packet[i] >> 4);
+	frame[length + 1] = packet[length - 1] << 4;
+}
+
+/**
+ * @brief prepare flags, sequence number and device ID at the beginning of the packet
+ */
+static RENARD_CLASS_INLINE void sfx_uplink_header_class(const sfx_ul_plain *uplink, const sfx_commoninfo *common, uint8_t *packet, const uint8_t frameclass, const uint8_t packetlen)
+{
+	uint8_t flags = 0x0;
+
+	/*
+	 * Flags, see ::sfx_uplink_encode
+	 * MAC fills up the remainder of the packet
+	 */
+	uint8_t maclen = packetlen - SFX_UL_HEADERLEN - uplink->payloadlen;
+	if (frameclass == 0)
+		flags |= 0x8 | ((uplink->payload[0] == 0) ? 0x0 : 0x4);
+	else if (frameclass > 1)
+		flags |= (maclen - 2) << 2;
+
+	if (uplink->request_downlink)
+		flags |= 0x2;
+
+	packet[0] = (flags << 4) | ((common->seqnum & 0xf00) >> 8);
+	packet[1] = common->seqnum & 0x0ff;
+	packet[2] = (common->devid & 0x000000ff) >> 0;
+	packet[3] = (common->devid & 0x0000ff00) >> 8;
+	packet[4] = (common->devid & 0x00ff0000) >> 16;
+	packet[5] = (common->devid & 0xff000000) >> 24;
+}
+
+/**
+ * @brief add MAC and CRC to packet in workspace that already contains header and payload, generate frames
+ */
+static RENARD_CLASS_INLINE void sfx_uplink_finish_class(uint8_t payloadlen, const uint8_t *key, uint8_t frames[][SFX_UL_MAX_FRAMELEN], uint8_t transmissions, sfx_workspace *workspace, const uint8_t frameclass, const uint8_t packetlen)
+{
+	uint8_t *packet = workspace->packet;
+	uint8_t maclen = packetlen - SFX_UL_HEADERLEN - payloadlen;
+	sfx_uplink_get_mac(packet, payloadlen, key, workspace->mac, &workspace->aes);
+	memcpy(&packet[packetlen - maclen], workspace->mac, maclen);
+
+	uint16_t crc16 = ~renard_crc16(packet, packetlen);
+	packet[packetlen] = crc16 >> 8;
+	packet[packetlen + 1] = crc16 & 0xff;
+
+	sfx_uplink_class_pack(frames[0], frametypes[0][frameclass], packet, packetlen + 2);
+
+	/*
+	 * Replicas: (7, 5) convolutional code on copies of the byte-aligned packet
+	 */
+	if (transmissions > 1) {
+		uint8_t *coded = workspace->coded;
+
+		memcpy(coded, packet, packetlen + 2);
+		convcode_07(coded, packetlen + 2);
+		sfx_uplink_class_pack(frames[1], frametypes[1][frameclass], coded, packetlen + 2);
+
+		memcpy(coded, packet, packetlen + 2);
+		convcode_05(coded, packetlen + 2);
+		sfx_uplink_class_pack(frames[2], frametypes[2][frameclass], coded, packetlen + 2);
+	}
+}
+
+static RENARD_CLASS_INLINE void sfx_uplink_encode_class(const sfx_ul_plain *uplink, const sfx_commoninfo *common, uint8_t frames[][SFX_UL_MAX_FRAMELEN], uint8_t transmissions, sfx_workspace *workspace, const uint8_t frameclass, const uint8_t packetlen)
+{
+	sfx_uplink_header_class(uplink, common, workspace->packet, frameclass, packetlen);
+	if (frameclass != 0)
+		memcpy(&workspace->packet[SFX_UL_HEADERLEN], uplink->payload, uplink->payloadlen);
+
+	sfx_uplink_finish_class(uplink->payloadlen, common->key, frames, transmissions, workspace, frameclass, packetlen);
+}
+
+/**
+ * @brief realign packet and CRC to byte boundaries, undo convolutional code of replicas and read header and payload,
+ * without checking CRC and MAC
+ */
+static RENARD_CLASS_INLINE sfx_uld_err sfx_uplink_unpack_class(const uint8_t *frame, sfx_ul_plain *uplink_out, sfx_commoninfo *common, uint8_t *packet, const uint8_t replica, const uint8_t frameclass, const uint8_t packetlen)
+{
+	uint8_t i;
+
+	/*
+	 * Realign packet and CRC to byte boundaries (skip frame type), undo convolutional code of replicas
+	 */
+	for (i = 0; i < packetlen + 2; ++i)
+		packet[i] = (frame[i + 1] << 4) | (frame[i + 2] >> 4);
+
+	if (replica == 1)
+		unconvcode_07(packet, packetlen + 2);
+	else if (replica == 2)
+		unconvcode_05(packet, packetlen + 2);
+
+	uplink_out->singlebit = (frameclass == 0);
+
+	// Device ID is encoded in little endian format
+	common->devid = ((uint32_t)packet[2] << 0) | ((uint32_t)packet[3] << 8) | ((uint32_t)packet[4] << 16) | ((uint32_t)packet[5] << 24);
+	common->seqnum = ((packet[0] & 0x0f) << 8) | packet[1];
+
+	// Read and interpret flags
+	uint8_t flags = packet[0] >> 4;
+	uint8_t maclen = SFX_UL_MIN_MACLEN + (frameclass == 0 ? 0 : flags >> 2);
+	uplink_out->request_downlink = flags & 0x2 ? true : false;
+
+	// MAC length from flags must leave room for the header inside the packet
+	if (maclen > packetlen - SFX_UL_HEADERLEN)
+		return SFX_ULD_ERR_FTYPE_MISMATCH;
+
+	uplink_out->payloadlen = packetlen - SFX_UL_HEADERLEN - maclen;
+
+	if (frameclass != 0)
+		memcpy(uplink_out->payload, &packet[SFX_UL_HEADERLEN], uplink_out->payloadlen);
+	else
+		uplink_out->payload[0] = flags & 0x4 ? 0x01 : 0x00;
+
+	return SFX_ULD_ERR_NONE;
+}
+
+static RENARD_CLASS_INLINE sfx_uld_err sfx_uplink_decode_class(const uint8_t *frame, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac, sfx_workspace *workspace, const uint8_t replica, const uint8_t frameclass, const uint8_t packetlen)
+{
+	uint8_t *packet = workspace->packet;
+	sfx_uld_err err = sfx_uplink_unpack_class(frame, uplink_out, common, packet, replica, frameclass, packetlen);
+	if (err != SFX_ULD_ERR_NONE)
+		return err;
+
+	uint8_t maclen = packetlen - SFX_UL_HEADERLEN - uplink_out->payloadlen;
+
+	/*
+	 * Check CRC
+	 */
+	uint16_t crc16 = ~renard_crc16(packet, packetlen);
+	bool crc_ok = crc16 == ((packet[packetlen] << 8) | packet[packetlen + 1]);
+
+#ifndef RENARD_CONSTANT_TIME
+	if (!crc_ok)
+		return SFX_ULD_ERR_CRC_INVALID;
+#endif
+
+	/*
+	 * Check MAC (optional), with RENARD_CONSTANT_TIME also if CRC is invalid
+	 */
+	bool mac_ok = true;
+	if (check_mac) {
+		sfx_uplink_get_mac(packet, uplink_out->payloadlen, common->key, workspace->mac, &workspace->aes);
+		mac_ok = renard_ct_equal(&packet[packetlen - maclen], workspace->mac, maclen);
+	}
+
+	if (!crc_ok)
+		return SFX_ULD_ERR_CRC_INVALID;
+
+	if (!mac_ok)
+		return SFX_ULD_ERR_MAC_INVALID;
+
+	return SFX_ULD_ERR_NONE;
+}
+
+/**
+ * @brief prepare flags, sequence number and device ID of byte-aligned packet for any frame class, see ::sfx_uplink_precompute
+ * @param uplink the content of the payload to encode, only payload length, single-bit value and downlink request are used
+ * @param common general information about the Sigfox object and its state
+ * @param packet output, byte-aligned packet buffer, ::SFX_UL_CLASS_BUFLEN bytes
+ */
+void sfx_uplink_prepare_header(const sfx_ul_plain *uplink, const sfx_commoninfo *common, uint8_t *packet)
+{
+	uint8_t frameclass = sfx_uplink_frameclass(uplink);
+	sfx_uplink_header_class(uplink, common, packet, frameclass, frametype_to_packetlen[frameclass]);
+}
+
+#define SFX_UL_CLASS_ENCODER(frameclass, packetlen) \
+	static void sfx_uplink_encode_class_##frameclass(const sfx_ul_plain *uplink, const sfx_commoninfo *common, uint8_t frames[][SFX_UL_MAX_FRAMELEN], uint8_t transmissions, sfx_workspace *workspace) \
+	{ \
+		sfx_uplink_encode_class(uplink, common, frames, transmissions, workspace, frameclass, packetlen); \
+	}
+
+#define SFX_UL_CLASS_FINISHER(frameclass, packetlen) \
+	static void sfx_uplink_finish_class_##frameclass(uint8_t payloadlen, const uint8_t *key, uint8_t frames[][SFX_UL_MAX_FRAMELEN], uint8_t transmissions, sfx_workspace *workspace) \
+	{ \
+		sfx_uplink_finish_class(payloadlen, key, frames, transmissions, workspace, frameclass, packetlen); \
+	}
+
+#define SFX_UL_CLASS_DECODER(replica, frameclass, packetlen) \
+	static sfx_uld_err sfx_uplink_decode_class_##replica##_##frameclass(const uint8_t *frame, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac, sfx_workspace *workspace) \
+	{ \
+		return sfx_uplink_decode_class(frame, uplink_out, common, check_mac, workspace, replica, frameclass, packetlen); \
+	}
+
+#define SFX_UL_CLASS_UNPACKER(replica, frameclass, packetlen) \
+	static sfx_uld_err sfx_uplink_unpack_class_##replica##_##frameclass(const uint8_t *frame, sfx_ul_plain *uplink_out, sfx_commoninfo *common, uint8_t *packet) \
+	{ \
+		return sfx_uplink_unpack_class(frame, uplink_out, common, packet, replica, frameclass, packetlen); \
+	}
+
+#define SFX_UL_CLASS_DECODERS(replica) \
+	SFX_UL_CLASS_DECODER(replica, 0, SFX_UL_CLASS_A_PACKETLEN) \
+	SFX_UL_CLASS_DECODER(replica, 1, SFX_UL_CLASS_B_PACKETLEN) \
+	SFX_UL_CLASS_DECODER(replica, 2, SFX_UL_CLASS_C_PACKETLEN) \
+	SFX_UL_CLASS_DECODER(replica, 3, SFX_UL_CLASS_D_PACKETLEN) \
+	SFX_UL_CLASS_DECODER(replica, 4, SFX_UL_CLASS_E_PACKETLEN) \
+	SFX_UL_CLASS_UNPACKER(replica, 0, SFX_UL_CLASS_A_PACKETLEN) \
+	SFX_UL_CLASS_UNPACKER(replica, 1, SFX_UL_CLASS_B_PACKETLEN) \
+	SFX_UL_CLASS_UNPACKER(replica, 2, SFX_UL_CLASS_C_PACKETLEN) \
+	SFX_UL_CLASS_UNPACKER(replica, 3, SFX_UL_CLASS_D_PACKETLEN) \
+	SFX_UL_CLASS_UNPACKER(replica, 4, SFX_UL_CLASS_E_PACKETLEN)
+
+SFX_UL_CLASS_ENCODER(0, SFX_UL_CLASS_A_PACKETLEN)
+SFX_UL_CLASS_ENCODER(1, SFX_UL_CLASS_B_PACKETLEN)
+SFX_UL_CLASS_ENCODER(2, SFX_UL_CLASS_C_PACKETLEN)
+SFX_UL_CLASS_ENCODER(3, SFX_UL_CLASS_D_PACKETLEN)
+SFX_UL_CLASS_ENCODER(4, SFX_UL_CLASS_E_PACKETLEN)
+
+SFX_UL_CLASS_FINISHER(0, SFX_UL_CLASS_A_PACKETLEN)
+SFX_UL_CLASS_FINISHER(1, SFX_UL_CLASS_B_PACKETLEN)
+SFX_UL_CLASS_FINISHER(2, SFX_UL_CLASS_C_PACKETLEN)
+SFX_UL_CLASS_FINISHER(3, SFX_UL_CLASS_D_PACKETLEN)
+SFX_UL_CLASS_FINISHER(4, SFX_UL_CLASS_E_PACKETLEN)
+
+SFX_UL_CLASS_DECODERS(0)
+SFX_UL_CLASS_DECODERS(1)
+SFX_UL_CLASS_DECODERS(2)
+
+const sfx_ul_class_encoder sfx_uplink_class_encoders[SFX_UL_FRAMECLASSES] = {
+	sfx_uplink_encode_class_0, sfx_uplink_encode_class_1, sfx_uplink_encode_class_2,
+	sfx_uplink_encode_class_3, sfx_uplink_encode_class_4
+};
+
+const sfx_ul_class_finisher sfx_uplink_class_finishers[SFX_UL_FRAMECLASSES] = {
+	sfx_uplink_finish_class_0, sfx_uplink_finish_class_1, sfx_uplink_finish_class_2,
+	sfx_uplink_finish_class_3, sfx_uplink_finish_class_4
+};
+
+const sfx_ul_class_decoder sfx_uplink_class_decoders[SFX_UL_TRANSMISSIONS][SFX_UL_FRAMECLASSES] = {
+	{
+		sfx_uplink_decode_class_0_0, sfx_uplink_decode_class_0_1, sfx_uplink_decode_class_0_2,
+		sfx_uplink_decode_class_0_3, sfx_uplink_decode_class_0_4
+	}, {
+		sfx_uplink_decode_class_1_0, sfx_uplink_decode_class_1_1, sfx_uplink_decode_class_1_2,
+		sfx_uplink_decode_class_1_3, sfx_uplink_decode_class_1_4
+	}, {
+		sfx_uplink_decode_class_2_0, sfx_uplink_decode_class_2_1, sfx_uplink_decode_class_2_2,
+		sfx_uplink_decode_class_2_3, sfx_uplink_decode_class_2_4
+	}
+};
+
+const sfx_ul_class_unpacker sfx_uplink_class_unpackers[SFX_UL_TRANSMISSIONS][SFX_UL_FRAMECLASSES] = {
+	{
+		sfx_uplink_unpack_class_0_0, sfx_uplink_unpack_class_0_1, sfx_uplink_unpack_class_0_2,
+		sfx_uplink_unpack_class_0_3, sfx_uplink_unpack_class_0_4
+	}, {
+		sfx_uplink_unpack_class_1_0, sfx_uplink_unpack_class_1_1, sfx_uplink_unpack_class_1_2,
+		sfx_uplink_unpack_class_1_3, sfx_uplink_unpack_class_1_4
+	}, {
+		sfx_uplink_unpack_class_2_0, sfx_uplink_unpack_class_2_1, sfx_uplink_unpack_class_2_2,
+		sfx_uplink_unpack_class_2_3, sfx_uplink_unpack_class_2_4
+	}
+};
+
+/*
+ * Incremental decoder
+ * Frame type is classified as soon as its 3 nibbles are known (nearest frame type, as in ::sfx_uplink_decode), which
+ * determines frame length, frame class and replica. Every complete packet byte is unconvolved (replicas) and added to
+ * the CRC right away and the MAC is computed as soon as the authenticated data (header and payload) is complete,
+ * so that only the comparison of MAC and CRC is left once the last bit arrives.
+ */
+
+/**
+ * @brief initialize incremental uplink decoder, feed bits with ::sfx_uplink_decoder_push_bits
+ * @param decoder decoder state to initialize
+ * @param key NAK of Sigfox object, MAC is checked if not NULL; if the device is not known in advance, the NAK can be
+ * provided later using ::sfx_uplink_decoder_set_key (see ::sfx_uplink_decoder_devid)
+ */
+void sfx_uplink_decoder_init(sfx_ul_decoder *decoder, const uint8_t *key)
+{
+	memset(decoder, 0, sizeof(*decoder));
+	decoder->status = SFX_ULD_ERR_INCOMPLETE;
+
+	if (key)
+		sfx_uplink_decoder_set_key(decoder, key);
+}
+
+static void sfx_uplink_decoder_compute_mac(sfx_ul_decoder *decoder)
+{
+	sfx_mac_workspace workspace;
+	sfx_uplink_get_mac(decoder->packet, decoder->payloadlen, decoder->key, decoder->mac, &workspace);
+	decoder->mac_done = true;
+}
+
+/**
+ * @brief provide NAK for MAC check, e.g. after the device ID became known, must be called before the frame is complete
+ * @param decoder incremental decoder
+ * @param key NAK of Sigfox object
+ */
+void sfx_uplink_decoder_set_key(sfx_ul_decoder *decoder, const uint8_t *key)
+{
+	memcpy(decoder->key, key, sizeof(decoder->key));
+	decoder->has_key = true;
+
+	// authenticated data may already be complete
+	if (decoder->packetbytes > 0 && decoder->packetbytes >= SFX_UL_HEADERLEN + decoder->payloadlen && !decoder->finished)
+		sfx_uplink_decoder_compute_mac(decoder);
+}
+
+static void sfx_uplink_decoder_finish(sfx_ul_decoder *decoder, sfx_uld_err status)
+{
+	decoder->status = status;
+	decoder->finished = true;
+}
+
+/**
+ * @brief process complete (raw) packet byte
+ */
+static void sfx_uplink_decoder_byte(sfx_ul_decoder *decoder, uint8_t raw)
+{
+	uint8_t i = decoder->packetbytes++;
+	uint8_t packetlen = decoder->packetlen;
+
+	if (decoder->replica == 1)
+		raw = unconvcode_07_byte(raw, &decoder->unconv_state);
+	else if (decoder->replica == 2)
+		raw = unconvcode_05_byte(raw, &decoder->unconv_state);
+
+	decoder->packet[i] = raw;
+
+	if (i < packetlen)
+		decoder->crc = renard_crc16_update(decoder->crc, raw);
+
+	// flags determine MAC length, see ::sfx_uplink_decode_class
+	if (i == 0) {
+		uint8_t flags = raw >> 4;
+		decoder->maclen = SFX_UL_MIN_MACLEN + (decoder->frameclass == 0 ? 0 : flags >> 2);
+
+		if (decoder->maclen > packetlen - SFX_UL_HEADERLEN) {
+			sfx_uplink_decoder_finish(decoder, SFX_ULD_ERR_FTYPE_MISMATCH);
+			return;
+		}
+
+		decoder->payloadlen = packetlen - SFX_UL_HEADERLEN - decoder->maclen;
+	}
+
+	// authenticated data complete: compute MAC while the remaining bits are received
+	if (i + 1 == SFX_UL_HEADERLEN + decoder->payloadlen && decoder->has_key)
+		sfx_uplink_decoder_compute_mac(decoder);
+
+	if (i + 1 < packetlen + 2)
+		return;
+
+	/*
+	 * Frame complete: compare CRC and MAC
+	 */
+	if ((uint16_t)~decoder->crc != ((decoder->packet[packetlen] << 8) | decoder->packet[packetlen + 1])) {
+		sfx_uplink_decoder_finish(decoder, SFX_ULD_ERR_CRC_INVALID);
+		return;
+	}
+
+	if (decoder->has_key) {
+		if (!decoder->mac_done)
+			sfx_uplink_decoder_compute_mac(decoder);
+
+		if (!renard_ct_equal(&decoder->packet[packetlen - decoder->maclen], decoder->mac, decoder->maclen)) {
+			sfx_uplink_decoder_finish(decoder, SFX_ULD_ERR_MAC_INVALID);
+			return;
+		}
+	}
+
+	sfx_uplink_decoder_finish(decoder, SFX_ULD_ERR_NONE);
+}
+
+/**
+ * @brief feed a single received nibble to incremental decoder
+ * @param decoder incremental decoder
+ * @param nibble next 4 frame bits (lower 4 bits, MSB first), excluding preamble
+ * @return true if decoding is finished (frame complete or invalid), see ::sfx_uplink_decoder_result
+ */
+bool sfx_uplink_decoder_push_nibble(sfx_ul_decoder *decoder, uint8_t nibble)
+{
+	if (decoder->finished)
+		return true;
+
+	nibble &= 0x0f;
+	uint8_t n = decoder->nibbles++;
+
+	/*
+	 * Frame type: classify as soon as it is complete
+	 */
+	if (n < SFX_UL_FTYPELEN_NIBBLES) {
+		decoder->frametype = (decoder->frametype << 4) | nibble;
+		if (n + 1 < SFX_UL_FTYPELEN_NIBBLES)
+			return false;
+
+		sfx_uplink_classify_frametype(decoder->frametype, &decoder->replica, &decoder->frameclass);
+
+		decoder->packetlen = frametype_to_packetlen[decoder->frameclass];
+		decoder->framelen_nibbles = SFX_UL_FRAMELEN_NIBBLES(decoder->packetlen);
+		return false;
+	}
+
+	/*
+	 * Packet and CRC: byte-aligned after frame type, first nibble of every byte is kept in packet buffer
+	 */
+	if ((n - SFX_UL_FTYPELEN_NIBBLES) % 2 == 0)
+		decoder->packet[decoder->packetbytes] = nibble << 4;
+	else
+		sfx_uplink_decoder_byte(decoder, decoder->packet[decoder->packetbytes] | nibble);
+
+	return decoder->finished;
+}
+
+/**
+ * @brief feed received bits to incremental decoder
+ * @param decoder incremental decoder
+ * @param bits received bits, right-aligned, first received bit is the most significant of the `count` bits
+ * @param count number of bits, at most 32
+ * @return true if decoding is finished (frame complete or invalid), see ::sfx_uplink_decoder_result
+ */
+bool sfx_uplink_decoder_push_bits(sfx_ul_decoder *decoder, uint32_t bits, uint8_t count)
+{
+	while (count > 0 && !decoder->finished) {
+		--count;
+		decoder->current = (decoder->current << 1) | ((bits >> count) & 0x01);
+
+		if (++decoder->currentbits == 4) {
+			sfx_uplink_decoder_push_nibble(decoder, decoder->current);
+			decoder->current = 0;
+			decoder->currentbits = 0;
+		}
+	}
+
+	return decoder->finished;
+}
+
+/**
+ * @brief get device ID of frame that is being decoded, available as soon as the packet header is complete
+ * @param decoder incremental decoder
+ * @param devid output, device ID
+ * @return true if device ID is available
+ */
+bool sfx_uplink_decoder_devid(const sfx_ul_decoder *decoder, uint32_t *devid)
+{
+	if (decoder->packetbytes < SFX_UL_HEADERLEN)
+		return false;
+
+	*devid = ((uint32_t)decoder->packet[2] << 0) | ((uint32_t)decoder->packet[3] << 8) | ((uint32_t)decoder->packet[4] << 16) | ((uint32_t)decoder->packet[5] << 24);
+	return true;
+}
+
+/**
+ * @brief get result of incremental decoding, outputs as in ::sfx_uplink_decode
+ * @param decoder incremental decoder
+ * @param uplink_out output, contents of Sigfox uplink frame
+ * @param common output, device ID and sequence number are written, NAK is not modified
+ * @return ::SFX_ULD_ERR_INCOMPLETE while frame is not complete, otherwise result of decoding; the frame length is implied by the frame type, so ::SFX_ULD_ERR_FTYPE_MISMATCH only occurs for invalid flags
+ */
+sfx_uld_err sfx_uplink_decoder_result(const sfx_ul_decoder *decoder, sfx_ul_plain *uplink_out, sfx_commoninfo *common)
+{
+	if (!decoder->finished)
+		return SFX_ULD_ERR_INCOMPLETE;
+
+	if (decoder->status == SFX_ULD_ERR_FTYPE_MISMATCH)
+		return decoder->status;
+
+	uint8_t flags = decoder->packet[0] >> 4;
+	uplink_out->singlebit = (decoder->frameclass == 0);
+	uplink_out->request_downlink = flags & 0x2 ? true : false;
+	uplink_out->payloadlen = decoder->payloadlen;
+
+	if (decoder->frameclass != 0)
+		memcpy(uplink_out->payload, &decoder->packet[SFX_UL_HEADERLEN], decoder->payloadlen);
+	else
+		uplink_out->payload[0] = flags & 0x4 ? 0x01 : 0x00;
+
+	sfx_uplink_decoder_devid(decoder, &common->devid);
+	common->seqnum = ((decoder->packet[0] & 0x0f) << 8) | decoder->packet[1];
+
+	return decoder->status;
+}
+
+/**
+ * @brief read device ID and sequence number of a raw uplink frame without checking CRC and MAC, e.g. to group the
+ * initial transmission and replicas of an uplink (and copies received by different gateways) before decoding.
+ * Only the header bytes are realigned and, for replicas, convolutionally decoded. The frame type is classified by
+ * ::sfx_uplink_classify like in ::sfx_uplink_decode; bit errors in the header go undetected.
+ * @param encoded raw frame, only first frame is used
+ * @param header output, header of frame
+ * @return ::SFX_ULD_ERR_FRAMELEN_EVEN or ::SFX_ULD_ERR_FTYPE_MISMATCH if the frame length does not match the frame type, ::SFX_ULD_ERR_NONE otherwise
+ */
+sfx_uld_err sfx_uplink_peek(const sfx_ul_encoded *encoded, sfx_ul_header *header)
+{
+	const uint8_t *frame = encoded->frame[0];
+
+	sfx_uld_err err = sfx_uplink_classify(encoded, &header->replica, &header->frameclass);
+	if (err != SFX_ULD_ERR_NONE)
+		return err;
+
+	uint8_t packet[SFX_UL_HEADERLEN];
+	for (uint8_t i = 0; i < SFX_UL_HEADERLEN; ++i)
+		packet[i] = (frame[i + 1] << 4) | (frame[i + 2] >> 4);
+
+	if (header->replica == 1)
+		unconvcode_07(packet, SFX_UL_HEADERLEN);
+	else if (header->replica == 2)
+		unconvcode_05(packet, SFX_UL_HEADERLEN);
+
+	header->devid = ((uint32_t)packet[2] << 0) | ((uint32_t)packet[3] << 8) | ((uint32_t)packet[4] << 16) | ((uint32_t)packet[5] << 24);
+	header->seqnum = ((packet[0] & 0x0f) << 8) | packet[1];
+
+	return SFX_ULD_ERR_NONE;
+}
@@ -0,0 +1,83 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "renard_config.h"
+#include "workspace.h"
+#include "uplink.h"
+#include "common.h"
+
+#ifndef _UPLINK_CLASS_H
+#define _UPLINK_CLASS_H
+
+/*
+ * Internal interface: Uplink encoders / decoders specialized for a single frame class (and replica)
+ * Frame classes are the columns in the 'frametypes' table: single bit (class A), 1 byte (class B),
+ * 4 / 8 / 12 bytes (classes C / D / E)
+ */
+#define SFX_UL_FRAMECLASSES 5
+#define SFX_UL_TRANSMISSIONS 3
+
+// length of packet (flags, SN, device ID, payload and MAC) for every frame class, in bytes
+#define SFX_UL_CLASS_A_PACKETLEN 8
+#define SFX_UL_CLASS_B_PACKETLEN 9
+#define SFX_UL_CLASS_C_PACKETLEN 12
+#define SFX_UL_CLASS_D_PACKETLEN 16
+#define SFX_UL_CLASS_E_PACKETLEN 20
+
+// length of flags, SN and device ID at the beginning of the packet, in bytes
+#define SFX_UL_HEADERLEN ((SFX_UL_FLAGLEN_NIBBLES + SFX_UL_SNLEN_NIBBLES + SFX_UL_DEVIDLEN_NIBBLES) / 2)
+
+// length of byte-aligned packet buffer (packet followed by CRC), in bytes
+#define SFX_UL_CLASS_BUFLEN (SFX_UL_MAX_PACKETLEN + SFX_UL_CRCLEN_NIBBLES / 2)
+
+// length of frame for given packet length, in nibbles, excluding preamble
+#define SFX_UL_FRAMELEN_NIBBLES(packetlen) (SFX_UL_FTYPELEN_NIBBLES + (packetlen) * 2 + SFX_UL_CRCLEN_NIBBLES)
+
+// inlining of the generic implementation into every frame class specialized function, see RENARD_NO_CLASS_INLINE
+#if defined(RENARD_NO_CLASS_INLINE) && defined(__GNUC__)
+#define RENARD_CLASS_INLINE __attribute__((noinline))
+#elif defined(RENARD_NO_CLASS_INLINE)
+#define RENARD_CLASS_INLINE
+#elif defined(__GNUC__)
+#define RENARD_CLASS_INLINE inline __attribute__((always_inline))
+#else
+#define RENARD_CLASS_INLINE inline
+#endif
+
+extern const uint16_t frametypes[SFX_UL_TRANSMISSIONS][SFX_UL_FRAMECLASSES];
+extern const uint8_t frametype_to_packetlen[SFX_UL_FRAMECLASSES];
+
+uint8_t sfx_uplink_get_mac(const uint8_t *packetcontent, uint8_t payloadlen, const uint8_t *key, uint8_t *mac, sfx_mac_workspace *workspace);
+uint8_t sfx_uplink_frameclass(const sfx_ul_plain *uplink);
+void sfx_uplink_prepare_header(const sfx_ul_plain *uplink, const sfx_commoninfo *common, uint8_t *packet);
+void sfx_uplink_classify_frametype(uint16_t frametype, uint8_t *replica_out, uint8_t *frameclass_out);
+sfx_uld_err sfx_uplink_classify(const sfx_ul_encoded *to_decode, uint8_t *replica_out, uint8_t *frameclass_out);
+
+/**
+ * @brief encoder for a single frame class, generates the first `transmissions` frames (initial transmission and replicas)
+ * @attention Input is not validated, payload length must match frame class
+ */
+typedef void (*sfx_ul_class_encoder)(const sfx_ul_plain *uplink, const sfx_commoninfo *common, uint8_t frames[][SFX_UL_MAX_FRAMELEN], uint8_t transmissions, sfx_workspace *workspace);
+
+/**
+ * @brief second half of encoder for a single frame class: adds MAC and CRC to the byte-aligned packet in sfx_workspace::packet that already contains header and payload and generates the first `transmissions` frames
+ */
+typedef void (*sfx_ul_class_finisher)(uint8_t payloadlen, const uint8_t *key, uint8_t frames[][SFX_UL_MAX_FRAMELEN], uint8_t transmissions, sfx_workspace *workspace);
+
+/**
+ * @brief decoder for a single frame class and replica, frame length must already have been checked
+ */
+typedef sfx_uld_err (*sfx_ul_class_decoder)(const uint8_t *frame, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac, sfx_workspace *workspace);
+
+/**
+ * @brief first half of decoder for a single frame class and replica: realigns and unconvolves the packet and reads
+ * header and payload, but does not check CRC and MAC, frame length must already have been checked
+ */
+typedef sfx_uld_err (*sfx_ul_class_unpacker)(const uint8_t *frame, sfx_ul_plain *uplink_out, sfx_commoninfo *common, uint8_t *packet);
+
+extern const sfx_ul_class_encoder sfx_uplink_class_encoders[SFX_UL_FRAMECLASSES];
+extern const sfx_ul_class_finisher sfx_uplink_class_finishers[SFX_UL_FRAMECLASSES];
+extern const sfx_ul_class_decoder sfx_uplink_class_decoders[SFX_UL_TRANSMISSIONS][SFX_UL_FRAMECLASSES];
+extern const sfx_ul_class_unpacker sfx_uplink_class_unpackers[SFX_UL_TRANSMISSIONS][SFX_UL_FRAMECLASSES];
+
+#endif
@@ -0,0 +1,332 @@
+#include <string.h>
+
+#include "uplink_class.h"
+#include "uplink_sched.h"
+#include "uplink.h"
+#include "common.h"
+
+/*
+ * Decode scheduler
+ * Hard decision decoding is cheap and always done on submission. Frames with invalid CRC are queued and decoded by
+ * increasingly expensive techniques (trial decoding of frame types, then single bit error correction) in order of
+ * priority: frames that request a downlink first, then frames whose frame type is closer to a valid one. Escalated
+ * decoding of a frame can be spread across multiple time slices. Under overload, frames are shed instead of growing
+ * the queue, so that the latency of escalated decoding stays bounded by the maximum age.
+ * Frames are kept in one FIFO list per priority. Frames are queued in the current time slice, so every list is sorted
+ * by age: the next frame to decode is the head of the lowest non-empty priority, the frame to shed the tail of the
+ * highest one, and expired frames are found at the heads.
+ */
+
+/// priority offset of frames that do not request a downlink, larger than any frame type Hamming distance
+#define SFX_UL_SCHED_NO_DOWNLINK_PRIORITY 16
+
+#if SFX_UL_SCHED_NO_DOWNLINK_PRIORITY + SFX_UL_FTYPELEN_NIBBLES * 4 >= SFX_UL_SCHED_PRIORITIES
+#error "escalation priorities exceed SFX_UL_SCHED_PRIORITIES"
+#endif
+
+/**
+ * @brief initialize decode scheduler
+ * @param sched scheduler to initialize
+ * @param entries caller-provided queue memory for `capacity` frames
+ * @param capacity maximum number of queued frames, less than ::SFX_UL_SCHED_NONE
+ * @param max_age maximum number of time slices (calls of ::sfx_uplink_sched_run) a frame stays queued
+ * @param lookup NAK lookup for MAC check, may be NULL (MAC is not checked)
+ * @param context context pointer passed to `lookup`
+ * @return false if capacity is invalid
+ */
+bool sfx_uplink_sched_init(sfx_ul_sched *sched, sfx_ul_sched_entry *entries, uint16_t capacity, uint32_t max_age, sfx_ul_keylookup lookup, void *context)
+{
+	uint16_t i;
+
+	if (capacity == 0 || capacity == SFX_UL_SCHED_NONE)
+		return false;
+
+	memset(sched, 0, sizeof(*sched));
+	memset(entries, 0, capacity * sizeof(*entries));
+	sched->entries = entries;
+	sched->capacity = capacity;
+	sched->max_age = max_age;
+	sched->lookup = lookup;
+	sched->context = context;
+
+	for (i = 0; i < SFX_UL_SCHED_PRIORITIES; ++i) {
+		sched->head[i] = SFX_UL_SCHED_NONE;
+		sched->tail[i] = SFX_UL_SCHED_NONE;
+	}
+
+	for (i = 0; i < capacity; ++i)
+		entries[i].next = i + 1 < capacity ? i + 1 : SFX_UL_SCHED_NONE;
+	sched->free = 0;
+
+	return true;
+}
+
+/**
+ * @brief take an unused entry and append it to the queue of the given priority
+ */
+static sfx_ul_sched_entry *sfx_uplink_sched_enqueue(sfx_ul_sched *sched, uint8_t priority)
+{
+	uint16_t index = sched->free;
+	sfx_ul_sched_entry *entry = &sched->entries[index];
+	sched->free = entry->next;
+
+	entry->priority = priority;
+	entry->prev = sched->tail[priority];
+	entry->next = SFX_UL_SCHED_NONE;
+	entry->used = true;
+
+	if (entry->prev == SFX_UL_SCHED_NONE)
+		sched->head[priority] = index;
+	else
+		sched->entries[entry->prev].next = index;
+	sched->tail[priority] = index;
+	sched->nonempty |= (uint32_t)1 << priority;
+
+	sched->queued++;
+
+	return entry;
+}
+
+/**
+ * @brief remove entry from the queue of its priority and return it to the unused entries
+ */
+static void sfx_uplink_sched_release(sfx_ul_sched *sched, uint16_t index)
+{
+	sfx_ul_sched_entry *entry = &sched->entries[index];
+	uint8_t priority = entry->priority;
+
+	if (entry->prev == SFX_UL_SCHED_NONE)
+		sched->head[priority] = entry->next;
+	else
+		sched->entries[entry->prev].next = entry->next;
+
+	if (entry->next == SFX_UL_SCHED_NONE)
+		sched->tail[priority] = entry->prev;
+	else
+		sched->entries[entry->next].prev = entry->prev;
+
+	if (sched->head[priority] == SFX_UL_SCHED_NONE)
+		sched->nonempty &= ~((uint32_t)1 << priority);
+
+	entry->used = false;
+	entry->next = sched->free;
+	sched->free = index;
+
+	sched->queued--;
+}
+
+/**
+ * @brief decode frame without MAC check to obtain device ID, then check MAC if the NAK is known
+ */
+static sfx_uld_err sfx_uplink_sched_decode(sfx_ul_sched *sched, const sfx_ul_encoded *encoded, bool trial, sfx_ul_sched_result *result)
+{
+	sfx_uld_err err;
+
+	memset(&result->uplink, 0, sizeof(result->uplink));
+	memset(&result->common, 0, sizeof(result->common));
+	result->mac_checked = false;
+
+	if (trial)
+		err = sfx_uplink_decode_trial(*encoded, &result->uplink, &result->common, false, SFX_UL_FTYPE_TRIAL_DISTANCE);
+	else
+		err = sfx_uplink_decode(*encoded, &result->uplink, &result->common, false);
+
+	if (err == SFX_ULD_ERR_NONE && sched->lookup && sched->lookup(sched->context, result->common.devid, result->common.key)) {
+		result->mac_checked = true;
+
+		if (trial)
+			err = sfx_uplink_decode_trial(*encoded, &result->uplink, &result->common, true, SFX_UL_FTYPE_TRIAL_DISTANCE);
+		else
+			err = sfx_uplink_decode(*encoded, &result->uplink, &result->common, true);
+	}
+
+	result->status = err;
+
+	return err;
+}
+
+/**
+ * @brief escalation priority of a frame that failed hard decision decoding, lower values are decoded first
+ */
+static uint8_t sfx_uplink_sched_priority(const sfx_ul_encoded *encoded, sfx_uld_err err, const sfx_ul_plain *uplink)
+{
+	const uint8_t *frame = encoded->frame[0];
+	uint16_t frametype = ((frame[0] & 0xf0) << 4) | ((frame[0] & 0x0f) << 4) | ((frame[1] & 0xf0) >> 4);
+	uint8_t distance = SFX_UL_FTYPELEN_NIBBLES * 4;
+	uint8_t replica, frameclass;
+
+	for (replica = 0; replica < SFX_UL_TRANSMISSIONS; ++replica) {
+		for (frameclass = 0; frameclass < SFX_UL_FRAMECLASSES; ++frameclass) {
+			uint8_t d = __builtin_popcount(frametypes[replica][frameclass] ^ frametype);
+			if (d < distance)
+				distance = d;
+		}
+	}
+
+	// downlink request flag is only known if the frame type was plausible, even though the CRC is invalid
+	bool request_downlink = err == SFX_ULD_ERR_CRC_INVALID && uplink->request_downlink;
+
+	return (request_downlink ? 0 : SFX_UL_SCHED_NO_DOWNLINK_PRIORITY) + distance;
+}
+
+/**
+ * @brief check whether frame length belongs to a frame class, otherwise escalated decoding can not recover the frame
+ */
+static bool sfx_uplink_sched_framelen_valid(uint8_t framelen_nibbles)
+{
+	uint8_t frameclass;
+
+	for (frameclass = 0; frameclass < SFX_UL_FRAMECLASSES; ++frameclass)
+		if (framelen_nibbles == SFX_UL_FRAMELEN_NIBBLES(frametype_to_packetlen[frameclass]))
+			return true;
+
+	return false;
+}
+
+/**
+ * @brief submit a received frame: decode by hard decision right away, queue it for escalated decoding if that fails
+ * @param sched decode scheduler
+ * @param encoded raw frame, only the first frame is used, see ::sfx_uplink_decode
+ * @param tag caller-defined identifier of frame, is returned with the result of escalated decoding
+ * @param result output, result of hard decision decoding
+ * @return result of hard decision decoding; unless it is ::SFX_ULD_ERR_NONE or ::SFX_ULD_ERR_MAC_INVALID, the frame
+ * is queued (its final result is returned by ::sfx_uplink_sched_run), shed, or rejected if its length does not
+ * belong to any frame class (see ::sfx_ul_sched_stats)
+ */
+sfx_uld_err sfx_uplink_sched_submit(sfx_ul_sched *sched, const sfx_ul_encoded *encoded, uint32_t tag, sfx_ul_sched_result *result)
+{
+	sched->stats.submitted++;
+	result->tag = tag;
+	result->escalated = false;
+
+	sfx_uld_err err = sfx_uplink_sched_decode(sched, encoded, false, result);
+
+	if (err == SFX_ULD_ERR_NONE || err == SFX_ULD_ERR_MAC_INVALID) {
+		sched->stats.decoded++;
+		return err;
+	}
+
+	if (!sfx_uplink_sched_framelen_valid(encoded->framelen_nibbles)) {
+		sched->stats.rejected++;
+		return err;
+	}
+
+	uint8_t priority = sfx_uplink_sched_priority(encoded, err, &result->uplink);
+
+	/*
+	 * Queue frame, shed lowest priority frame (newest on ties) if queue is full
+	 */
+	if (sched->queued == sched->capacity) {
+		uint8_t lowest = 31 - __builtin_clz(sched->nonempty);
+
+		sched->stats.shed_full++;
+
+		if (lowest <= priority)
+			return err;
+
+		sfx_uplink_sched_release(sched, sched->tail[lowest]);
+	}
+
+	sfx_ul_sched_entry *entry = sfx_uplink_sched_enqueue(sched, priority);
+	entry->encoded = *encoded;
+	entry->tag = tag;
+	entry->slice = sched->slice;
+	entry->stage = SFX_UL_SCHED_STAGE_TRIAL;
+	entry->position = 0;
+
+	sched->stats.escalated++;
+
+	return err;
+}
+
+/**
+ * @brief run escalated decoding for one time slice
+ * Expired frames are shed first, then queued frames are decoded in order of priority (downlink requests first, then
+ * lower frame type Hamming distance, then older frames) until the budget is spent. A frame whose stages are not
+ * finished within the budget is continued in the next time slice.
+ * @param sched decode scheduler
+ * @param budget work budget of this time slice, in units (decoded candidate frames)
+ * @param results output, results of frames whose escalated decoding finished (recovered or failed)
+ * @param max_results maximum number of results
+ * @return number of results
+ * @attention Bit flipping accepts any frame with a valid CRC, a MAC check (NAK lookup) is recommended to reject
+ * miscorrections of frames with multiple bit errors.
+ */
+uint16_t sfx_uplink_sched_run(sfx_ul_sched *sched, uint32_t budget, sfx_ul_sched_result *results, uint16_t max_results)
+{
+	uint16_t count = 0;
+	uint32_t pending;
+
+	sched->slice++;
+
+	// expired frames are the oldest, at the heads of the queues
+	for (pending = sched->nonempty; pending != 0; pending &= pending - 1) {
+		uint8_t priority = __builtin_ctz(pending);
+		uint16_t index;
+
+		while ((index = sched->head[priority]) != SFX_UL_SCHED_NONE && sched->slice - sched->entries[index].slice > sched->max_age) {
+			sfx_uplink_sched_release(sched, index);
+			sched->stats.shed_expired++;
+		}
+	}
+
+	while (budget > 0 && sched->queued > 0 && count < max_results) {
+		uint16_t index = sched->head[__builtin_ctz(sched->nonempty)];
+		sfx_ul_sched_entry *entry = &sched->entries[index];
+		sfx_ul_sched_result *result = &results[count];
+		bool done = false;
+
+		/*
+		 * Trial decoding of frame types within distance
+		 */
+		if (entry->stage == SFX_UL_SCHED_STAGE_TRIAL) {
+			budget -= budget < SFX_UL_SCHED_TRIAL_UNITS ? budget : SFX_UL_SCHED_TRIAL_UNITS;
+			sched->stats.units += SFX_UL_SCHED_TRIAL_UNITS;
+
+			if (sfx_uplink_sched_decode(sched, &entry->encoded, true, result) == SFX_ULD_ERR_NONE) {
+				sched->stats.recovered++;
+				done = true;
+			} else {
+				entry->stage = SFX_UL_SCHED_STAGE_BITFLIP;
+				entry->position = SFX_UL_FTYPELEN_NIBBLES * 4;
+			}
+		}
+
+		/*
+		 * Single bit error correction in packet and CRC (frame type errors are handled by trial decoding)
+		 */
+		while (!done && budget > 0) {
+			uint8_t *frame = entry->encoded.frame[0];
+
+			if (entry->position >= entry->encoded.framelen_nibbles * 4) {
+				sfx_uplink_sched_decode(sched, &entry->encoded, false, result);
+				sched->stats.failed++;
+				done = true;
+				break;
+			}
+
+			uint8_t mask = 0x80 >> (entry->position % 8);
+			frame[entry->position / 8] ^= mask;
+			sfx_uld_err err = sfx_uplink_sched_decode(sched, &entry->encoded, false, result);
+			frame[entry->position / 8] ^= mask;
+
+			entry->position++;
+			budget--;
+			sched->stats.units++;
+
+			if (err == SFX_ULD_ERR_NONE) {
+				sched->stats.recovered++;
+				done = true;
+			}
+		}
+
+		if (done) {
+			result->tag = entry->tag;
+			result->escalated = true;
+			sfx_uplink_sched_release(sched, index);
+			count++;
+		}
+	}
+
+	return count;
+}
@@ -0,0 +1,168 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "uplink.h"
+#include "common.h"
+
+#ifndef _UPLINK_SCHED_H
+#define _UPLINK_SCHED_H
+
+/*
+ * Decode scheduler: every frame is decoded by hard decision (::sfx_uplink_decode) right away, frames that fail are
+ * queued for escalated decoding, which is run within a work budget per time slice, see ::sfx_uplink_sched_run.
+ * Work is measured in units, one unit corresponds to decoding a single candidate frame (CRC check, MAC check if the
+ * CRC is valid and the NAK is known).
+ */
+
+/// escalation stage: trial decoding of all frame types within ::SFX_UL_FTYPE_TRIAL_DISTANCE, see ::sfx_uplink_decode_trial
+#define SFX_UL_SCHED_STAGE_TRIAL 0
+
+/// escalation stage: correction of a single bit error by flipping every bit of packet and CRC
+#define SFX_UL_SCHED_STAGE_BITFLIP 1
+
+/// work units of trial decoding stage
+#define SFX_UL_SCHED_TRIAL_UNITS 3
+
+/// number of escalation priorities, see sfx_ul_sched_entry::priority
+#define SFX_UL_SCHED_PRIORITIES 32
+
+/// end of list marker of queue entry indices, also the exclusive upper bound of the queue capacity
+#define SFX_UL_SCHED_NONE 0xffff
+
+/**
+ * @brief NAK lookup, e.g. in a key table of the network
+ * @param context context pointer passed to ::sfx_uplink_sched_init
+ * @param devid device ID of decoded frame
+ * @param key output, NAK of device
+ * @return true if NAK is known, then the MAC is checked
+ */
+typedef bool (*sfx_ul_keylookup)(void *context, uint32_t devid, uint8_t *key);
+
+/**
+ * @brief frame that is queued for escalated decoding
+ */
+typedef struct _s_sfx_ul_sched_entry {
+	/// raw frame as received, only the first frame is used
+	sfx_ul_encoded encoded;
+
+	/// caller-defined identifier of frame, e.g. index in capture or timestamp
+	uint32_t tag;
+
+	/// time slice in which the frame was queued
+	uint32_t slice;
+
+	/// escalation priority, lower values are decoded first
+	uint8_t priority;
+
+	/// current escalation stage, SFX_UL_SCHED_STAGE_*
+	uint8_t stage;
+
+	/// bit flipping stage: position of next bit to flip
+	uint16_t position;
+
+	/// neighbours in queue of same priority (oldest first) or ::SFX_UL_SCHED_NONE, `next` also links unused entries
+	uint16_t prev;
+	uint16_t next;
+
+	/// indicates whether entry is in use
+	bool used;
+} sfx_ul_sched_entry;
+
+/**
+ * @brief decoding result of a single frame
+ */
+typedef struct _s_sfx_ul_sched_result {
+	/// identifier of frame, see ::sfx_uplink_sched_submit
+	uint32_t tag;
+
+	/// result of decoding, see ::sfx_uplink_decode
+	sfx_uld_err status;
+
+	/// indicates whether the MAC was checked (NAK known)
+	bool mac_checked;
+
+	/// indicates whether the frame was recovered by escalated decoding
+	bool escalated;
+
+	/// contents of uplink frame
+	sfx_ul_plain uplink;
+
+	/// device ID and sequence number of uplink frame
+	sfx_commoninfo common;
+} sfx_ul_sched_result;
+
+/**
+ * @brief counters of decode scheduler, every submitted frame is accounted for exactly once:
+ * submitted == decoded + rejected + recovered + failed + shed_full + shed_expired + sfx_ul_sched::queued
+ */
+typedef struct _s_sfx_ul_sched_stats {
+	/// number of submitted frames
+	uint32_t submitted;
+
+	/// number of frames that were decoded by hard decision on submission
+	uint32_t decoded;
+
+	/// number of frames that were rejected on submission because their length does not belong to any frame class
+	uint32_t rejected;
+
+	/// number of frames that were queued for escalated decoding
+	uint32_t escalated;
+
+	/// number of escalated frames that were recovered
+	uint32_t recovered;
+
+	/// number of escalated frames for which all stages failed
+	uint32_t failed;
+
+	/// number of frames that were shed because the queue was full (lowest priority frame is shed)
+	uint32_t shed_full;
+
+	/// number of frames that were shed because they were not recovered within the maximum age
+	uint32_t shed_expired;
+
+	/// total number of work units spent on escalated decoding
+	uint64_t units;
+} sfx_ul_sched_stats;
+
+/**
+ * @brief decode scheduler, see ::sfx_uplink_sched_init
+ */
+typedef struct _s_sfx_ul_sched {
+	/// caller-provided queue memory
+	sfx_ul_sched_entry *entries;
+
+	/// number of entries in queue memory
+	uint16_t capacity;
+
+	/// number of queued frames
+	uint16_t queued;
+
+	/// queue of every priority in order of submission: first (oldest) and last (newest) entry or ::SFX_UL_SCHED_NONE
+	uint16_t head[SFX_UL_SCHED_PRIORITIES];
+	uint16_t tail[SFX_UL_SCHED_PRIORITIES];
+
+	/// bit `n` is set if the queue of priority `n` is not empty
+	uint32_t nonempty;
+
+	/// first unused entry or ::SFX_UL_SCHED_NONE
+	uint16_t free;
+
+	/// current time slice, incremented by every call of ::sfx_uplink_sched_run
+	uint32_t slice;
+
+	/// maximum number of time slices a frame stays queued
+	uint32_t max_age;
+
+	/// NAK lookup, may be NULL
+	sfx_ul_keylookup lookup;
+	void *context;
+
+	/// counters
+	sfx_ul_sched_stats stats;
+} sfx_ul_sched;
+
+bool sfx_uplink_sched_init(sfx_ul_sched *sched, sfx_ul_sched_entry *entries, uint16_t capacity, uint32_t max_age, sfx_ul_keylookup lookup, void *context);
+sfx_uld_err sfx_uplink_sched_submit(sfx_ul_sched *sched, const sfx_ul_encoded *encoded, uint32_t tag, sfx_ul_sched_result *result);
+uint16_t sfx_uplink_sched_run(sfx_ul_sched *sched, uint32_t budget, sfx_ul_sched_result *results, uint16_t max_results);
+
+#endif
@@ -0,0 +1,133 @@
+#include <inttypes.h>
+#include <stdbool.h>
+
+#include "uplink.h"
+#include "downlink.h"
+#include "common.h"
+
+#ifndef _WORKSPACE_H
+#define _WORKSPACE_H
+
+/*
+ * Workspace API: variants of the encoding / decoding functions that take all of their scratch buffers from a single
+ * caller-provided ::sfx_workspace instead of the stack, and take inputs by pointer instead of by value. A workspace
+ * can be reused for any number of calls (e.g. one static workspace per task), but must not be used by two calls at
+ * the same time. The functions without workspace parameter allocate a workspace on the stack and call these.
+ *
+ * The remaining stack use of every function is a small, fixed frame per call level plus the AES implementation
+ * (see `make size-report`), call depth does not depend on inputs.
+ */
+
+/**
+ * @brief scratch buffers of MAC computation (AES-CBC)
+ */
+typedef struct _s_sfx_mac_workspace {
+	/// authenticated data, padded to full AES blocks
+	uint8_t input[32];
+
+	/// AES-CBC output, the MAC is taken from the last block
+	uint8_t output[32];
+} sfx_mac_workspace;
+
+/**
+ * @brief scratch buffers of all encoding / decoding functions of the workspace API
+ */
+typedef struct _s_sfx_workspace {
+	/// uplink: byte-aligned packet (flags, SN, device ID, payload and MAC) followed by CRC
+	uint8_t packet[SFX_UL_MAX_PACKETLEN + SFX_UL_CRCLEN_NIBBLES / 2];
+
+	/// uplink encoding: convolutionally coded copy of `packet` for a replica
+	uint8_t coded[SFX_UL_MAX_PACKETLEN + SFX_UL_CRCLEN_NIBBLES / 2];
+
+	/// uplink: MAC computed from packet
+	uint8_t mac[SFX_UL_MAX_MACLEN];
+
+	/// downlink decoding: descrambled frame
+	uint8_t frame[SFX_DL_FRAMELEN];
+
+	/// MAC computation
+	sfx_mac_workspace aes;
+
+	/// trial decoding: outputs of current candidate
+	sfx_ul_plain trial_uplink;
+	sfx_commoninfo trial_common;
+} sfx_workspace;
+
+/// size of ::sfx_workspace in bytes, for static allocation / stack budgeting
+#define SFX_WORKSPACE_SIZE (sizeof(sfx_workspace))
+
+/**
+ * @brief candidate codeword of soft-decision downlink decoding
+ */
+typedef struct _s_sfx_dl_soft_candidate {
+	/// corrected BCH(15,11) codeword
+	uint16_t code;
+
+	/// sum of reliabilities of bits that differ from the hard decision
+	uint16_t metric;
+} sfx_dl_soft_candidate;
+
+/**
+ * @brief candidate frame of soft-decision downlink decoding, assembled from the best candidate of every codeword
+ */
+typedef struct _s_sfx_dl_soft_combination {
+	/// metric increase compared to frame assembled from best candidates
+	uint16_t delta;
+
+	/// replaced codewords, `codeword * SFX_DL_SOFT_CANDIDATES + candidate` or 0xff if unused
+	uint8_t replaced[2];
+} sfx_dl_soft_combination;
+
+/**
+ * @brief scratch buffers of soft-decision downlink decoding, see ::sfx_downlink_decode_soft_ws
+ * Kept separate from ::sfx_workspace, which would otherwise grow for all other functions.
+ */
+typedef struct _s_sfx_dl_soft_workspace {
+	/// hard decisions, descrambled
+	uint8_t hard[SFX_DL_FRAMELEN];
+
+	/// candidate frame currently being checked
+	uint8_t frame[SFX_DL_FRAMELEN];
+
+	/// distinct candidates of every interleaved codeword, sorted by metric
+	sfx_dl_soft_candidate candidates[8][SFX_DL_SOFT_CANDIDATES];
+	uint8_t candidate_count[8];
+
+	/// candidate frames in order of increasing metric
+	sfx_dl_soft_combination combinations[SFX_DL_SOFT_MAX_BUDGET];
+
+	/// MAC computation
+	sfx_mac_workspace aes;
+} sfx_dl_soft_workspace;
+
+/// size of ::sfx_dl_soft_workspace in bytes, for static allocation / stack budgeting
+#define SFX_DL_SOFT_WORKSPACE_SIZE (sizeof(sfx_dl_soft_workspace))
+
+/*
+ * Steps of downlink encoding, for encoders that compute the CRC-8 of many frames at once (::renard_crc8_multi):
+ * ::sfx_downlink_encode_mac, CRC-8 of payload and MAC stored at ::SFX_DL_CRCOFFSET, ::sfx_downlink_encode_fec
+ */
+
+/// number of frames whose CRC-8 is computed at once by batch downlink encoders
+#define SFX_DL_BATCH_CRC_CHUNK 16
+
+void sfx_downlink_encode_mac(const uint8_t *payload, const sfx_commoninfo *common, uint8_t *frame, sfx_mac_workspace *workspace);
+void sfx_downlink_encode_fec(uint8_t *frame, const sfx_commoninfo *common);
+
+sfx_ule_err sfx_uplink_encode_ws(const sfx_ul_plain *uplink, const sfx_commoninfo *common, sfx_ul_encoded *encoded, sfx_workspace *workspace);
+sfx_ule_err sfx_uplink_encode_onair_ws(const sfx_ul_plain *uplink, const sfx_commoninfo *common, bool dbpsk, uint8_t *onair, uint8_t *onairlen_bytes, sfx_workspace *workspace);
+sfx_ule_err sfx_uplink_stream_init_ws(sfx_ul_stream *stream, const sfx_ul_plain *uplink, const sfx_commoninfo *common, bool dbpsk, sfx_workspace *workspace);
+sfx_ule_err sfx_uplink_precompute_ws(const sfx_ul_plain *uplink, const sfx_commoninfo *common, bool fixed_payload, sfx_ul_precomputed *precomputed, sfx_workspace *workspace);
+sfx_ule_err sfx_uplink_precompute_window_ws(const sfx_ul_plain *uplink, const sfx_commoninfo *common, bool fixed_payload, sfx_ul_precomputed *precomputed, uint16_t count, sfx_workspace *workspace);
+sfx_ule_err sfx_uplink_finalize_ws(const sfx_ul_precomputed *precomputed, const uint8_t *payload, sfx_ul_encoded *encoded, sfx_workspace *workspace);
+sfx_uld_err sfx_uplink_decode_ws(const sfx_ul_encoded *to_decode, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac, sfx_workspace *workspace);
+sfx_uld_err sfx_uplink_decode_trial_ws(const sfx_ul_encoded *to_decode, sfx_ul_plain *uplink_out, sfx_commoninfo *common, bool check_mac, uint8_t max_distance, sfx_workspace *workspace);
+sfx_uld_err sfx_uplink_check_mac_ws(const sfx_ul_packet *packet, const sfx_ul_plain *uplink, const uint8_t *key, sfx_workspace *workspace);
+
+void sfx_downlink_encode_ws(const sfx_dl_plain *to_encode, const sfx_commoninfo *common, sfx_dl_encoded *encoded, sfx_workspace *workspace);
+void sfx_downlink_decode_ws(const sfx_dl_encoded *to_decode, const sfx_commoninfo *common, sfx_dl_plain *decoded, sfx_workspace *workspace);
+void sfx_downlink_encode_onair_ws(const sfx_dl_plain *to_encode, const sfx_commoninfo *common, uint8_t *onair, uint8_t offset_bits, sfx_workspace *workspace);
+void sfx_downlink_encode_batch_ws(const sfx_dl_plain *to_encode, const sfx_commoninfo *common, uint16_t count, uint8_t *onair, uint16_t stride_bytes, uint8_t offset_bits, sfx_workspace *workspace);
+uint8_t sfx_downlink_decode_soft_ws(const int8_t *softbits, const sfx_commoninfo *common, sfx_dl_plain *decoded, uint8_t budget, sfx_dl_soft_workspace *workspace);
+
+#endif
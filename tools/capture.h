@@ -0,0 +1,214 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "uplink.h"
+#include "downlink.h"
+
+#ifndef _CAPTURE_H
+#define _CAPTURE_H
+
+/*
+ * Binary capture file format for archived raw uplink / downlink frames
+ *
+ * Layout: header (::sfx_capture_header), records (fixed size, ::sfx_capture_record, optionally followed
+ * by soft bits), index (::sfx_capture_index_entry, one entry every `index_interval` records).
+ * All values are stored in little endian byte order, all structs are naturally aligned without padding
+ * so that files can be memory-mapped and accessed in place on little endian hosts.
+ */
+#define SFX_CAPTURE_MAGIC "RNRDCAP"
+#define SFX_CAPTURE_VERSION 1
+
+/// header flag: every record is followed by soft bits, one signed byte per frame bit (positive for 1, negative for 0, see ::sfx_downlink_decode_soft)
+#define SFX_CAPTURE_FLAG_SOFTBITS 0x01
+
+/// maximum number of frame bytes in a record (uplink or downlink frame, without preamble)
+#define SFX_CAPTURE_MAX_FRAMELEN SFX_UL_MAX_FRAMELEN
+
+/// number of soft bits stored per record if ::SFX_CAPTURE_FLAG_SOFTBITS is set
+#define SFX_CAPTURE_SOFTBITS (SFX_CAPTURE_MAX_FRAMELEN * 8)
+
+/// default distance between index entries, in records
+#define SFX_CAPTURE_INDEX_INTERVAL 4096
+
+typedef struct _s_sfx_capture_header {
+	/// ::SFX_CAPTURE_MAGIC, zero-terminated
+	char magic[8];
+
+	/// ::SFX_CAPTURE_VERSION
+	uint32_t version;
+
+	/// combination of SFX_CAPTURE_FLAG_* values
+	uint32_t flags;
+
+	/// number of records in file
+	uint64_t record_count;
+
+	/// size of a single record in bytes, including soft bits
+	uint32_t record_size;
+
+	/// distance between index entries, in records
+	uint32_t index_interval;
+
+	/// offset of index from beginning of file, in bytes, 0 if there is no index
+	uint64_t index_offset;
+} sfx_capture_header;
+
+/// record type: uplink frame, see ::sfx_ul_encoded
+#define SFX_CAPTURE_UPLINK 0
+
+/// record type: downlink frame, see ::sfx_dl_encoded
+#define SFX_CAPTURE_DOWNLINK 1
+
+typedef struct _s_sfx_capture_record {
+	/// reception timestamp, in microseconds since the Unix epoch
+	uint64_t timestamp;
+
+	/// identifier of receiving gateway / base station
+	uint32_t gateway;
+
+	/// downlinks only: device ID of addressed Sigfox object (required for descrambling)
+	uint32_t devid;
+
+	/// downlinks only: sequence number of corresponding uplink (required for descrambling)
+	uint16_t seqnum;
+
+	/// ::SFX_CAPTURE_UPLINK or ::SFX_CAPTURE_DOWNLINK
+	uint8_t type;
+
+	/// uplinks: length of frame in nibbles, see sfx_ul_encoded::framelen_nibbles, downlinks: ::SFX_DL_FRAMELEN * 2
+	uint8_t framelen_nibbles;
+
+	/// raw frame without preamble
+	uint8_t frame[SFX_CAPTURE_MAX_FRAMELEN];
+
+	/// reserved, must be zero
+	uint8_t reserved[4];
+} sfx_capture_record;
+
+typedef struct _s_sfx_capture_index_entry {
+	/// timestamp of first record covered by index entry
+	uint64_t timestamp;
+
+	/// number of first record covered by index entry
+	uint64_t record;
+} sfx_capture_index_entry;
+
+/*
+ * Columnar output format of decoded records
+ * Layout: header (::sfx_decoded_header) followed by one array per column, every column is aligned
+ * to ::SFX_DECODED_ALIGN bytes. Column n starts at `offsets[n]` and has `count` elements.
+ */
+#define SFX_DECODED_MAGIC "RNRDDEC"
+#define SFX_DECODED_VERSION 1
+#define SFX_DECODED_ALIGN 64
+
+enum {
+	SFX_DECODED_COL_TIMESTAMP = 0,	// uint64_t
+	SFX_DECODED_COL_GATEWAY,	// uint32_t
+	SFX_DECODED_COL_STATUS,		// uint8_t, uplinks: ::sfx_uld_err, downlinks: 0
+	SFX_DECODED_COL_FLAGS,		// uint8_t, combination of SFX_DECODED_FLAG_* values
+	SFX_DECODED_COL_DEVID,		// uint32_t
+	SFX_DECODED_COL_SEQNUM,		// uint16_t
+	SFX_DECODED_COL_PAYLOADLEN,	// uint8_t
+	SFX_DECODED_COL_PAYLOAD,	// uint8_t[SFX_UL_MAX_PAYLOADLEN]
+	SFX_DECODED_COLUMNS
+};
+
+#define SFX_DECODED_FLAG_DOWNLINK 0x01
+#define SFX_DECODED_FLAG_SINGLEBIT 0x02
+#define SFX_DECODED_FLAG_REQUEST_DOWNLINK 0x04
+#define SFX_DECODED_FLAG_MAC_CHECKED 0x08
+#define SFX_DECODED_FLAG_CRC_OK 0x10
+#define SFX_DECODED_FLAG_MAC_OK 0x20
+#define SFX_DECODED_FLAG_FEC_CORRECTED 0x40
+
+typedef struct _s_sfx_decoded_header {
+	/// ::SFX_DECODED_MAGIC, zero-terminated
+	char magic[8];
+
+	/// ::SFX_DECODED_VERSION
+	uint32_t version;
+
+	/// number of columns, ::SFX_DECODED_COLUMNS
+	uint32_t columns;
+
+	/// number of decoded records
+	uint64_t count;
+
+	/// offset of every column from beginning of file, in bytes
+	uint64_t offsets[SFX_DECODED_COLUMNS];
+} sfx_decoded_header;
+
+/// size of a single element of every column, in bytes
+static const uint8_t sfx_decoded_colsize[SFX_DECODED_COLUMNS] = { 8, 4, 1, 1, 4, 2, 1, SFX_UL_MAX_PAYLOADLEN };
+
+/**
+ * @brief initialize capture file header
+ * @param header output, capture file header
+ * @param flags combination of SFX_CAPTURE_FLAG_* values
+ */
+static inline void sfx_capture_header_init(sfx_capture_header *header, uint32_t flags)
+{
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, SFX_CAPTURE_MAGIC, sizeof(SFX_CAPTURE_MAGIC));
+	header->version = SFX_CAPTURE_VERSION;
+	header->flags = flags;
+	header->record_size = sizeof(sfx_capture_record) + ((flags & SFX_CAPTURE_FLAG_SOFTBITS) ? SFX_CAPTURE_SOFTBITS : 0);
+	header->index_interval = SFX_CAPTURE_INDEX_INTERVAL;
+}
+
+/**
+ * @brief check whether capture file header is valid and supported
+ * The header is read from untrusted files, so all sizes are checked without overflowing arithmetic.
+ * @param header capture file header
+ * @param filesize total size of capture file in bytes
+ * @return true if header is valid and all records (and index, if present) are within `filesize`
+ */
+static inline bool sfx_capture_header_valid(const sfx_capture_header *header, uint64_t filesize)
+{
+	if (filesize < sizeof(*header) || memcmp(header->magic, SFX_CAPTURE_MAGIC, sizeof(SFX_CAPTURE_MAGIC)) != 0)
+		return false;
+	if (header->version != SFX_CAPTURE_VERSION || header->record_size < sizeof(sfx_capture_record))
+		return false;
+	if (header->record_count > (filesize - sizeof(*header)) / header->record_size)
+		return false;
+
+	if (header->index_offset != 0) {
+		// index entries are accessed in place, so the index has to be aligned
+		if (header->index_interval == 0 || header->index_offset % sizeof(uint64_t) != 0 || header->index_offset > filesize)
+			return false;
+
+		uint64_t index_count = header->record_count / header->index_interval + (header->record_count % header->index_interval != 0);
+		if (index_count > (filesize - header->index_offset) / sizeof(sfx_capture_index_entry))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * @brief get record from memory-mapped capture file
+ * @param header capture file header at beginning of file
+ * @param n number of record
+ * @return pointer to record
+ */
+static inline sfx_capture_record *sfx_capture_record_get(const sfx_capture_header *header, uint64_t n)
+{
+	return (sfx_capture_record *)((uint8_t *)header + sizeof(*header) + n * header->record_size);
+}
+
+/**
+ * @brief number of index entries in capture file with given header
+ * @param header capture file header
+ * @return number of index entries
+ */
+static inline uint64_t sfx_capture_index_count(const sfx_capture_header *header)
+{
+	if (header->index_offset == 0)
+		return 0;
+
+	return header->record_count / header->index_interval + (header->record_count % header->index_interval != 0);
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*
+ * check-agg: replica aggregator (::sfx_uplink_agg_push, ::sfx_uplink_agg_advance) fed with the transmissions of many
+ * devices as received by several gateways, out of order, with losses, invalid frames and a table that fills up: every
+ * group is emitted once, for the right reason, and holds exactly the accepted frames of one uplink, which all decode
+ * (::sfx_uplink_decode) to the transmitted contents
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "check.h"
+#include "uplink_agg.h"
+#include "uplink.h"
+#include "common.h"
+
+#define TICKS 400
+#define MAX_UPLINKS_PER_TICK 40
+#define MAX_GATEWAYS 3
+#define UPLINKS (TICKS * MAX_UPLINKS_PER_TICK)
+#define FRAMES (UPLINKS * MAX_GATEWAYS * 3)
+
+#define GROUPS 192
+#define COPIES 1024
+#define BUCKETS 256
+#define WHEEL_SLOTS 16
+#define TIMEOUT 8
+#define MIN_COPIES 6
+
+typedef struct {
+	sfx_ul_plain uplink;
+	sfx_commoninfo common;
+	uint8_t accepted;
+	uint8_t emitted;
+	uint8_t grouped;
+} transmission;
+
+typedef struct {
+	uint32_t tick;
+	uint32_t tag;
+	sfx_ul_encoded frame;
+} reception;
+
+static transmission transmissions[UPLINKS];
+static reception receptions[FRAMES];
+static uint32_t order[FRAMES];
+static sfx_ul_agg agg;
+static uint64_t emitted_copies;
+
+static void check_emit(void *context, const sfx_ul_agg_group *group, const sfx_ul_agg_copy *const copies[], uint8_t reason)
+{
+	uint8_t replicas = 0;
+	(void)context;
+
+	CHECK(group->count > 0 && group->count <= SFX_UL_AGG_MAX_COPIES);
+	if (group->count == 0 || group->count > SFX_UL_AGG_MAX_COPIES)
+		return;
+
+	// complete groups are emitted as soon as they are complete, the others when their timeout expires
+	if (reason == SFX_UL_AGG_EMIT_COMPLETE)
+		CHECK(group->replicas == 0x07 && group->count >= MIN_COPIES && agg.now - group->first < TIMEOUT);
+	else
+		CHECK(reason == SFX_UL_AGG_EMIT_TIMEOUT && (group->replicas != 0x07 || group->count < MIN_COPIES) && agg.now - group->first == TIMEOUT);
+
+	uint32_t index = copies[0]->tag >> 2;
+	CHECK(index < UPLINKS);
+	if (index >= UPLINKS)
+		return;
+
+	transmission *sent = &transmissions[index];
+	CHECK(sent->emitted++ == 0);
+	CHECK(group->devid == sent->common.devid && group->seqnum == sent->common.seqnum);
+
+	for (uint8_t i = 0; i < group->count; ++i) {
+		sfx_ul_encoded encoded;
+		sfx_ul_plain uplink;
+		sfx_commoninfo common;
+
+		CHECK(copies[i]->tag >> 2 == index && copies[i]->replica == (copies[i]->tag & 0x03));
+		replicas |= 1 << copies[i]->replica;
+
+		memset(&encoded, 0, sizeof(encoded));
+		memcpy(encoded.frame[0], copies[i]->frame, SFX_UL_MAX_FRAMELEN);
+		encoded.framelen_nibbles = copies[i]->framelen_nibbles;
+		memset(&common, 0, sizeof(common));
+		memcpy(common.key, sent->common.key, sizeof(common.key));
+		sfx_uld_err err = sfx_uplink_decode(encoded, &uplink, &common, true);
+		CHECK(check_same_uplink(err, &uplink, &common, SFX_ULD_ERR_NONE, &sent->uplink, &sent->common));
+	}
+
+	CHECK(group->replicas == replicas);
+	sent->grouped = group->count;
+	emitted_copies += group->count;
+}
+
+int main(void)
+{
+	static sfx_ul_agg_group groups[GROUPS];
+	static sfx_ul_agg_copy copies[COPIES];
+	static uint32_t buckets[BUCKETS], wheel[WHEEL_SLOTS];
+	static uint32_t per_tick[TICKS + TIMEOUT + 1];
+	uint32_t uplinks = 0, frames = 0, accepted = 0;
+
+	/*
+	 * Every uplink is received by up to three gateways, frames arrive within the timeout but out of order
+	 */
+	for (uint32_t tick = 0; tick < TICKS; ++tick) {
+		for (uint32_t count = check_rng() % (MAX_UPLINKS_PER_TICK + 1); count > 0; --count) {
+			transmission *sent = &transmissions[uplinks];
+			sfx_ul_encoded encoded;
+
+			check_random_uplink(&sent->uplink, &sent->common);
+			CHECK(sfx_uplink_encode(sent->uplink, sent->common, &encoded) == SFX_ULE_ERR_NONE);
+
+			for (uint8_t gateway = 1 + check_rng() % MAX_GATEWAYS; gateway > 0; --gateway) {
+				for (uint8_t replica = 0; replica < 3; ++replica) {
+					if (check_rng() % 10 == 0)
+						continue;
+
+					reception *received = &receptions[frames++];
+					received->tick = tick + check_rng() % TIMEOUT;
+					received->tag = (uplinks << 2) | replica;
+					check_receive_uplink(&encoded, replica, 0, &received->frame);
+
+					// frame length that does not match the frame type
+					if (check_rng() % 100 == 0)
+						received->frame.framelen_nibbles--;
+
+					per_tick[received->tick + 1]++;
+				}
+			}
+
+			uplinks++;
+		}
+	}
+
+	// sort receptions by tick
+	for (uint32_t tick = 1; tick <= TICKS + TIMEOUT; ++tick)
+		per_tick[tick] += per_tick[tick - 1];
+	for (uint32_t i = 0; i < frames; ++i)
+		order[per_tick[receptions[i].tick]++] = i;
+
+	CHECK(!sfx_uplink_agg_init(&agg, groups, GROUPS, copies, COPIES, buckets, BUCKETS, wheel, TIMEOUT, TIMEOUT, MIN_COPIES, check_emit, NULL));
+	CHECK(sfx_uplink_agg_init(&agg, groups, GROUPS, copies, COPIES, buckets, BUCKETS, wheel, WHEEL_SLOTS, TIMEOUT, MIN_COPIES, check_emit, NULL));
+
+	uint32_t next = 0;
+	for (uint32_t tick = 0; tick <= TICKS + 2 * TIMEOUT; ++tick) {
+		sfx_uplink_agg_advance(&agg, tick);
+
+		for (; next < frames && receptions[order[next]].tick == tick; ++next) {
+			const reception *received = &receptions[order[next]];
+			if (sfx_uplink_agg_push(&agg, &received->frame, received->tag)) {
+				transmissions[received->tag >> 2].accepted++;
+				accepted++;
+			}
+		}
+	}
+
+	// all groups have been emitted, every accepted frame is in the group of its uplink
+	CHECK(next == frames && agg.active == 0);
+	for (uint32_t i = 0; i < uplinks; ++i)
+		CHECK(transmissions[i].grouped == transmissions[i].accepted);
+
+	const sfx_ul_agg_stats *stats = &agg.stats;
+	CHECK(stats->pushed == frames && emitted_copies == accepted);
+	CHECK(stats->pushed == stats->invalid + stats->late + stats->dropped + accepted);
+	CHECK(stats->invalid > 0 && stats->late > 0 && stats->dropped > 0 && stats->complete > 0 && stats->expired > 0);
+
+	return check_report("check-agg");
+}
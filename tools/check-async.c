@@ -0,0 +1,216 @@
+/*
+ * check-async: requests of all operations with every key option, processed by the worker threads of the asynchronous
+ * interface (::sfx_async_submit, ::sfx_async_reap) while the rings fill up, complete exactly once with the results of
+ * ::sfx_uplink_decode, ::sfx_uplink_encode, ::sfx_downlink_decode and ::sfx_downlink_encode
+ */
+#define _GNU_SOURCE
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "check.h"
+#include "async.h"
+#include "uplink.h"
+#include "downlink.h"
+#include "common.h"
+
+#define REQUESTS 40000
+#define SQ_CAPACITY 64
+#define CQ_CAPACITY 128
+#define WORKERS 3
+#define MAX_SUBMIT 48
+#define MAX_REAP 32
+
+static sfx_async_request requests[REQUESTS];
+static uint8_t completed[REQUESTS];
+
+// NAK derived from device ID, unknown for every eighth device ID; called from worker threads, so it has no state
+static bool check_lookup(void *context, uint32_t devid, uint8_t *key)
+{
+	(void)context;
+
+	for (uint8_t i = 0; i < 16; ++i)
+		key[i] = (devid >> (8 * (i % 4))) ^ (i * 0x3b);
+
+	return (devid & 0x07) != 0;
+}
+
+static void check_uplink_decode(const sfx_async_request *request, const sfx_async_completion *completion)
+{
+	sfx_ul_plain expected;
+	sfx_commoninfo common = request->common;
+	bool mac_checked = (request->flags & SFX_ASYNC_FLAG_CHECK_MAC) != 0;
+
+	sfx_uld_err err = sfx_uplink_decode(request->in.ul_encoded, &expected, &common, mac_checked && !(request->flags & SFX_ASYNC_FLAG_LOOKUP_KEY));
+	if (request->flags & SFX_ASYNC_FLAG_LOOKUP_KEY) {
+		mac_checked = err == SFX_ULD_ERR_NONE && check_lookup(NULL, common.devid, common.key);
+		if (mac_checked)
+			err = sfx_uplink_decode(request->in.ul_encoded, &expected, &common, true);
+	}
+
+	sfx_commoninfo decoded = {.devid = completion->devid, .seqnum = completion->seqnum};
+	CHECK(completion->mac_checked == mac_checked);
+	CHECK(check_same_uplink(completion->status, &completion->out.ul_plain, &decoded, err, &expected, &common));
+}
+
+static void check_uplink_encode(const sfx_async_request *request, const sfx_async_completion *completion)
+{
+	sfx_ul_encoded expected;
+
+	memset(&expected, 0, sizeof(expected));
+	sfx_ule_err err = sfx_uplink_encode(request->in.ul_plain, request->common, &expected);
+
+	CHECK(completion->status == err);
+	CHECK(completion->devid == request->common.devid && completion->seqnum == request->common.seqnum);
+	if (err == SFX_ULE_ERR_NONE) {
+		const sfx_ul_encoded *encoded = &completion->out.ul_encoded;
+		uint8_t transmissions = request->in.ul_plain.replicas ? 3 : 1;
+
+		CHECK(encoded->framelen_nibbles == expected.framelen_nibbles);
+		for (uint8_t i = 0; i < transmissions; ++i)
+			CHECK(memcmp(encoded->frame[i], expected.frame[i], (expected.framelen_nibbles + 1) / 2) == 0);
+	}
+}
+
+static void check_downlink_decode(const sfx_async_request *request, const sfx_async_completion *completion)
+{
+	sfx_dl_plain expected;
+	sfx_commoninfo common = request->common;
+	bool mac_checked = !(request->flags & SFX_ASYNC_FLAG_LOOKUP_KEY) || check_lookup(NULL, common.devid, common.key);
+
+	sfx_downlink_decode(request->in.dl_encoded, common, &expected);
+
+	const sfx_dl_plain *decoded = &completion->out.dl_plain;
+	CHECK(completion->mac_checked == mac_checked);
+	CHECK(completion->devid == request->common.devid && completion->seqnum == request->common.seqnum);
+	CHECK(decoded->crc_ok == expected.crc_ok && decoded->fec_corrected == expected.fec_corrected);
+	CHECK(!expected.crc_ok || memcmp(decoded->payload, expected.payload, SFX_DL_PAYLOADLEN) == 0);
+	CHECK(!mac_checked || decoded->mac_ok == expected.mac_ok);
+}
+
+static void check_downlink_encode(const sfx_async_request *request, const sfx_async_completion *completion)
+{
+	sfx_dl_encoded expected;
+
+	sfx_downlink_encode(request->in.dl_plain, request->common, &expected);
+	CHECK(completion->devid == request->common.devid && completion->seqnum == request->common.seqnum);
+	CHECK(memcmp(completion->out.dl_encoded.frame, expected.frame, SFX_DL_FRAMELEN) == 0);
+}
+
+static void check_random_request(uint64_t user_data, sfx_async_request *request)
+{
+	static const uint8_t flags[] = {0, SFX_ASYNC_FLAG_CHECK_MAC, SFX_ASYNC_FLAG_LOOKUP_KEY};
+	sfx_ul_plain uplink;
+	sfx_ul_encoded encoded;
+	sfx_dl_plain downlink;
+	sfx_dl_encoded dl_encoded;
+
+	memset(request, 0, sizeof(*request));
+	request->user_data = user_data;
+	request->opcode = check_rng() % 4;
+
+	// NAK of request is sometimes wrong, so that invalid MACs are checked as well
+	check_random_uplink(&uplink, &request->common);
+	check_lookup(NULL, request->common.devid, request->common.key);
+	if (check_rng() % 8 == 0)
+		request->common.key[check_rng() % 16] ^= 0x01;
+
+	memset(&downlink, 0, sizeof(downlink));
+	check_rng_fill(downlink.payload, SFX_DL_PAYLOADLEN);
+
+	switch (request->opcode) {
+	case SFX_ASYNC_UPLINK_DECODE:
+		request->flags = flags[check_rng() % 3];
+		sfx_uplink_encode(uplink, request->common, &encoded);
+		check_receive_uplink(&encoded, check_rng() % 3, check_rng() % 4 == 0 ? 1 + check_rng() % 2 : 0, &request->in.ul_encoded);
+		break;
+	case SFX_ASYNC_UPLINK_ENCODE:
+		// some invalid payload lengths
+		if (check_rng() % 16 == 0)
+			uplink.payloadlen = SFX_UL_MAX_PAYLOADLEN + 1;
+		uplink.replicas = check_rng() & 0x01;
+		request->in.ul_plain = uplink;
+		break;
+	case SFX_ASYNC_DOWNLINK_DECODE:
+		request->flags = flags[check_rng() % 3] & ~SFX_ASYNC_FLAG_CHECK_MAC;
+		sfx_downlink_encode(downlink, request->common, &dl_encoded);
+		for (uint8_t errors = check_rng() % 4 == 0 ? 1 + check_rng() % 3 : 0; errors > 0; --errors)
+			dl_encoded.frame[check_rng() % SFX_DL_FRAMELEN] ^= 1 << (check_rng() % 8);
+		request->in.dl_encoded = dl_encoded;
+		break;
+	case SFX_ASYNC_DOWNLINK_ENCODE:
+		request->in.dl_plain = downlink;
+		break;
+	}
+}
+
+int main(void)
+{
+	static uint8_t sq_buffer[SFX_ASYNC_SQ_BUFSIZE(SQ_CAPACITY)] RENARD_CACHELINE_ALIGNED;
+	static uint8_t cq_buffer[SFX_ASYNC_CQ_BUFSIZE(CQ_CAPACITY)] RENARD_CACHELINE_ALIGNED;
+	static sfx_async ctx;
+	sfx_async_completion completions[MAX_REAP];
+	uint32_t submitted = 0, reaped = 0;
+
+	for (uint32_t i = 0; i < REQUESTS; ++i)
+		check_random_request(i, &requests[i]);
+
+	CHECK(!sfx_async_init(&ctx, sq_buffer, SQ_CAPACITY, cq_buffer, CQ_CAPACITY, 0, check_lookup, NULL));
+	CHECK(!sfx_async_init(&ctx, sq_buffer, SQ_CAPACITY, cq_buffer, CQ_CAPACITY - 1, WORKERS, check_lookup, NULL));
+	if (!sfx_async_init(&ctx, sq_buffer, SQ_CAPACITY, cq_buffer, CQ_CAPACITY, WORKERS, check_lookup, NULL)) {
+		CHECK(false);
+		return check_report("check-async");
+	}
+
+	struct pollfd event = {.fd = sfx_async_eventfd(&ctx), .events = POLLIN};
+
+	while (reaped < REQUESTS) {
+		uint32_t count = REQUESTS - submitted < MAX_SUBMIT ? REQUESTS - submitted : MAX_SUBMIT;
+		if (count > 0)
+			submitted += sfx_async_submit(&ctx, &requests[submitted], 1 + check_rng() % count);
+		CHECK(ctx.inflight <= CQ_CAPACITY);
+
+		// wait for completions like an event loop, then reap in chunks
+		uint64_t value;
+		if (poll(&event, 1, 100) > 0)
+			(void)!read(event.fd, &value, sizeof(value));
+
+		while ((count = sfx_async_reap(&ctx, completions, 1 + check_rng() % MAX_REAP)) > 0) {
+			for (uint32_t i = 0; i < count; ++i) {
+				const sfx_async_completion *completion = &completions[i];
+
+				CHECK(completion->user_data < submitted);
+				if (completion->user_data >= submitted)
+					continue;
+
+				const sfx_async_request *request = &requests[completion->user_data];
+				CHECK(completed[completion->user_data]++ == 0);
+				CHECK(completion->opcode == request->opcode);
+
+				switch (request->opcode) {
+				case SFX_ASYNC_UPLINK_DECODE:
+					check_uplink_decode(request, completion);
+					break;
+				case SFX_ASYNC_UPLINK_ENCODE:
+					check_uplink_encode(request, completion);
+					break;
+				case SFX_ASYNC_DOWNLINK_DECODE:
+					check_downlink_decode(request, completion);
+					break;
+				case SFX_ASYNC_DOWNLINK_ENCODE:
+					check_downlink_encode(request, completion);
+					break;
+				}
+			}
+
+			reaped += count;
+		}
+	}
+
+	CHECK(submitted == REQUESTS && reaped == REQUESTS && ctx.inflight == 0);
+	sfx_async_destroy(&ctx);
+
+	return check_report("check-async");
+}
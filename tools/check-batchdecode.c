@@ -0,0 +1,70 @@
+/*
+ * check-batchdecode: batch uplink decoding (::sfx_uplink_decode_batch, multi-buffer CRC-16) and the MAC check of its
+ * results (::sfx_uplink_check_mac) against ::sfx_uplink_decode of every single frame
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "check.h"
+#include "uplink.h"
+#include "common.h"
+
+#define ROUNDS 100
+#define MAX_BATCH 300
+
+int main(void)
+{
+	static sfx_ul_encoded received[MAX_BATCH];
+	static const sfx_ul_encoded *frames[MAX_BATCH];
+	static sfx_ul_plain uplinks[MAX_BATCH];
+	static sfx_commoninfo commons[MAX_BATCH];
+	static sfx_ul_packet packets[MAX_BATCH];
+	static sfx_uld_err status[MAX_BATCH];
+	static uint8_t keys[MAX_BATCH][16];
+
+	for (uint32_t round = 0; round < ROUNDS; ++round) {
+		uint16_t count = check_rng() % (MAX_BATCH + 1);
+
+		for (uint16_t i = 0; i < count; ++i) {
+			sfx_ul_plain uplink;
+			sfx_commoninfo common;
+			sfx_ul_encoded encoded;
+
+			check_random_uplink(&uplink, &common);
+			memcpy(keys[i], common.key, sizeof(keys[i]));
+			CHECK(sfx_uplink_encode(uplink, common, &encoded) == SFX_ULE_ERR_NONE);
+
+			// wrong NAK for some frames, so that MAC mismatches are checked as well
+			if (check_rng() % 4 == 0)
+				keys[i][0] ^= 0x01;
+
+			// mostly valid frames, some with bit errors, a few with wrong length
+			check_receive_uplink(&encoded, check_rng() % 3, check_rng() % 4 == 0 ? 1 + check_rng() % 3 : 0, &received[i]);
+			if (check_rng() % 50 == 0)
+				received[i].framelen_nibbles += 1 + check_rng() % 2;
+
+			frames[i] = &received[i];
+		}
+
+		sfx_uplink_decode_batch(frames, count, uplinks, commons, packets, status);
+
+		for (uint16_t i = 0; i < count; ++i) {
+			sfx_ul_plain uplink;
+			sfx_commoninfo common;
+
+			memset(&common, 0, sizeof(common));
+			memcpy(common.key, keys[i], sizeof(common.key));
+
+			sfx_uld_err err = sfx_uplink_decode(received[i], &uplink, &common, false);
+			CHECK(check_same_uplink(err, &uplink, &common, status[i], &uplinks[i], &commons[i]));
+
+			if (err == SFX_ULD_ERR_NONE && status[i] == SFX_ULD_ERR_NONE) {
+				sfx_uld_err mac_err = sfx_uplink_decode(received[i], &uplink, &common, true);
+				CHECK(sfx_uplink_check_mac(&packets[i], &uplinks[i], keys[i]) == mac_err);
+			}
+		}
+	}
+
+	return check_report("check-batchdecode");
+}
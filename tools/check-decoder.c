@@ -0,0 +1,89 @@
+/*
+ * check-decoder: incremental uplink decoding (::sfx_uplink_decoder_push_bits, ::sfx_uplink_decoder_push_nibble) of
+ * frames fed in random chunks, with bit errors, wrong NAKs and NAKs provided once the device ID is known, against
+ * ::sfx_uplink_decode of the complete frame
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "check.h"
+#include "uplink.h"
+#include "common.h"
+
+#define FRAMES 20000
+
+static uint8_t frame_bit(const sfx_ul_encoded *frame, uint16_t position)
+{
+	return (frame->frame[0][position / 8] >> (7 - position % 8)) & 0x01;
+}
+
+int main(void)
+{
+	for (uint32_t frame = 0; frame < FRAMES; ++frame) {
+		sfx_ul_plain uplink;
+		sfx_commoninfo common;
+		sfx_ul_encoded encoded, received;
+		uint8_t key[16];
+
+		check_random_uplink(&uplink, &common);
+		CHECK(sfx_uplink_encode(uplink, common, &encoded) == SFX_ULE_ERR_NONE);
+		check_receive_uplink(&encoded, check_rng() % 3, check_rng() % 4 == 0 ? 1 : 0, &received);
+
+		// wrong NAK for some frames, so that MAC mismatches are checked as well
+		memcpy(key, common.key, sizeof(key));
+		if (check_rng() % 4 == 0)
+			key[check_rng() % sizeof(key)] ^= 0x01;
+
+		sfx_ul_plain expected;
+		sfx_commoninfo expected_common;
+		memset(&expected_common, 0, sizeof(expected_common));
+		memcpy(expected_common.key, key, sizeof(key));
+		sfx_uld_err expected_err = sfx_uplink_decode(received, &expected, &expected_common, true);
+
+		// NAK either known in advance or looked up once the device ID has been decoded
+		sfx_ul_decoder decoder;
+		bool late_key = check_rng() & 0x01;
+		bool nibblewise = check_rng() % 4 == 0;
+		bool finished = false;
+		uint16_t position = 0, length = received.framelen_nibbles * 4;
+
+		sfx_uplink_decoder_init(&decoder, late_key ? NULL : key);
+
+		while (!finished && position < length) {
+			sfx_ul_plain incomplete;
+			sfx_commoninfo incomplete_common;
+			uint8_t count = nibblewise ? 4 : 1 + check_rng() % 32;
+			uint32_t bits = 0;
+
+			CHECK(sfx_uplink_decoder_result(&decoder, &incomplete, &incomplete_common) == SFX_ULD_ERR_INCOMPLETE);
+
+			if (count > length - position)
+				count = length - position;
+			for (uint8_t i = 0; i < count; ++i)
+				bits = (bits << 1) | frame_bit(&received, position + i);
+
+			finished = nibblewise ? sfx_uplink_decoder_push_nibble(&decoder, bits) : sfx_uplink_decoder_push_bits(&decoder, bits, count);
+			position += count;
+
+			uint32_t devid;
+			if (late_key && sfx_uplink_decoder_devid(&decoder, &devid)) {
+				CHECK(expected_err != SFX_ULD_ERR_NONE || devid == expected_common.devid);
+				sfx_uplink_decoder_set_key(&decoder, key);
+				late_key = false;
+			}
+		}
+
+		sfx_ul_plain decoded;
+		sfx_commoninfo decoded_common;
+		memset(&decoded_common, 0, sizeof(decoded_common));
+		sfx_uld_err err = sfx_uplink_decoder_result(&decoder, &decoded, &decoded_common);
+
+		// frame length is implied by the frame type, so decoding may only end early for invalid frame types
+		CHECK(finished);
+		CHECK(position == length || err == SFX_ULD_ERR_FTYPE_MISMATCH);
+		CHECK(check_same_uplink(err, &decoded, &decoded_common, expected_err, &expected, &expected_common));
+	}
+
+	return check_report("check-decoder");
+}
@@ -0,0 +1,135 @@
+/*
+ * check-keystream: devices encrypt payloads with directly computed keystream blocks (::sfx_crypto_keystream), a server
+ * decodes the frames (::sfx_uplink_decode, ::sfx_downlink_decode) and decrypts them with blocks from a sliding
+ * keystream cache (::sfx_keystream_cache_lookup, ::sfx_keystream_cache_get), which must yield the original payloads
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "check.h"
+#include "payload_crypto.h"
+#include "uplink.h"
+#include "downlink.h"
+#include "common.h"
+
+#define DEVICES 40
+#define FRAMES 300
+#define MAX_CAPACITY 256
+
+int main(void)
+{
+	static uint8_t ul_blocks[MAX_CAPACITY][SFX_KEYSTREAM_LEN], dl_blocks[MAX_CAPACITY][SFX_KEYSTREAM_LEN];
+
+	for (uint32_t device = 0; device < DEVICES; ++device) {
+		sfx_keystream_cache ul_cache, dl_cache;
+		sfx_ul_plain uplink;
+		sfx_commoninfo common;
+		uint8_t kenc[16];
+
+		check_random_uplink(&uplink, &common);
+		sfx_crypto_derive_key(&common, kenc);
+
+		uint16_t capacity = 1 << (check_rng() % 9);
+		uint32_t counter = SFX_CRYPTO_COUNTER(check_rng() % 4, check_rng());
+
+		CHECK(!sfx_keystream_cache_init(&ul_cache, &common, false, counter, ul_blocks, capacity * 3));
+		CHECK(sfx_keystream_cache_init(&ul_cache, &common, false, counter, ul_blocks, capacity));
+		CHECK(sfx_keystream_cache_init(&dl_cache, &common, true, counter, dl_blocks, capacity));
+
+		for (uint32_t frame = 0; frame < FRAMES; ++frame) {
+			uint8_t ul_keystream[SFX_KEYSTREAM_LEN], dl_keystream[SFX_KEYSTREAM_LEN];
+
+			// device skips some sequence numbers, e.g. frames that were not received
+			uint32_t gap = check_rng() % 4 == 0 ? check_rng() % 8 : 0;
+			counter = ul_cache.first + gap;
+
+			/*
+			 * Device: encrypt uplink with directly computed keystream, encode with 12-bit sequence number
+			 */
+			sfx_ul_plain original, encrypted;
+			sfx_ul_encoded encoded;
+
+			check_random_uplink(&original, &(sfx_commoninfo){0});
+			encrypted = original;
+			sfx_crypto_keystream(kenc, common.devid, counter, false, ul_keystream);
+			sfx_uplink_payload_crypt(&encrypted, ul_keystream);
+			for (uint8_t i = 0; i < (original.singlebit ? 0 : original.payloadlen); ++i)
+				CHECK(encrypted.payload[i] == (original.payload[i] ^ ul_keystream[i]));
+
+			common.seqnum = counter & 0xfff;
+			CHECK(sfx_uplink_encode(encrypted, common, &encoded) == SFX_ULE_ERR_NONE);
+
+			/*
+			 * Server: decode uplink, look up keystream block by sequence number, decrypt
+			 */
+			sfx_ul_plain decoded;
+			sfx_commoninfo server;
+			uint32_t resolved;
+
+			memset(&server, 0, sizeof(server));
+			memcpy(server.key, common.key, sizeof(server.key));
+			CHECK(sfx_uplink_decode(encoded, &decoded, &server, true) == SFX_ULD_ERR_NONE);
+			CHECK(server.seqnum == common.seqnum);
+
+			const uint8_t *block = sfx_keystream_cache_lookup(&ul_cache, server.seqnum, &resolved);
+			CHECK((block != NULL) == (gap < capacity));
+			CHECK(sfx_crypto_counter_resolve(ul_cache.first, server.seqnum) == counter);
+			if (!block) {
+				CHECK(sfx_keystream_cache_get(&ul_cache, counter) == NULL);
+				sfx_keystream_cache_advance(&ul_cache, counter + 1);
+				sfx_keystream_cache_advance(&dl_cache, counter + 1);
+				continue;
+			}
+
+			CHECK(resolved == counter);
+			CHECK(memcmp(block, ul_keystream, SFX_KEYSTREAM_LEN) == 0);
+			sfx_uplink_payload_crypt(&decoded, block);
+			CHECK(decoded.singlebit == original.singlebit && decoded.payloadlen == original.payloadlen &&
+					memcmp(decoded.payload, original.payload, original.singlebit ? 1 : original.payloadlen) == 0);
+
+			/*
+			 * Server: encrypt downlink with cached block of the uplink's counter, device decodes and decrypts
+			 */
+			if (original.request_downlink) {
+				sfx_dl_plain response, received;
+				sfx_dl_encoded dl_encoded;
+				uint8_t payload[SFX_DL_PAYLOADLEN];
+
+				check_rng_fill(payload, sizeof(payload));
+				memset(&response, 0, sizeof(response));
+				memcpy(response.payload, payload, sizeof(payload));
+
+				const uint8_t *dl_block = sfx_keystream_cache_get(&dl_cache, counter);
+				CHECK(dl_block != NULL && memcmp(dl_block, block, SFX_KEYSTREAM_LEN) != 0);
+				if (dl_block) {
+					sfx_downlink_payload_crypt(&response, dl_block);
+					sfx_downlink_encode(response, common, &dl_encoded);
+
+					sfx_downlink_decode(dl_encoded, common, &received);
+					CHECK(received.crc_ok && received.mac_ok);
+					sfx_crypto_keystream(kenc, common.devid, counter, true, dl_keystream);
+					sfx_downlink_payload_crypt(&received, dl_keystream);
+					CHECK(memcmp(received.payload, payload, sizeof(payload)) == 0);
+				}
+			}
+
+			// slide window past the received frame, only blocks that were not cached before are computed
+			uint32_t advanced = counter + 1 - ul_cache.first;
+			uint16_t expected = advanced < capacity ? advanced : capacity;
+			CHECK(sfx_keystream_cache_advance(&ul_cache, counter + 1) == expected);
+			CHECK(sfx_keystream_cache_advance(&dl_cache, counter + 1) == expected);
+			CHECK(sfx_keystream_cache_get(&ul_cache, counter) == NULL);
+			CHECK(sfx_keystream_cache_get(&ul_cache, counter + 1 + capacity) == NULL);
+
+			// every block in the window matches a directly computed block
+			uint32_t probe = counter + 1 + check_rng() % capacity;
+			sfx_crypto_keystream(kenc, common.devid, probe, false, ul_keystream);
+			sfx_crypto_keystream(kenc, common.devid, probe, true, dl_keystream);
+			CHECK(memcmp(sfx_keystream_cache_get(&ul_cache, probe), ul_keystream, SFX_KEYSTREAM_LEN) == 0);
+			CHECK(memcmp(sfx_keystream_cache_get(&dl_cache, probe), dl_keystream, SFX_KEYSTREAM_LEN) == 0);
+		}
+	}
+
+	return check_report("check-keystream");
+}
@@ -0,0 +1,198 @@
+/*
+ * check-pack: random payload schemas (::sfx_payload_schema_init) with linear and delta fields of every width: values
+ * packed with ::sfx_payload_pack, sent through ::sfx_uplink_encode / ::sfx_uplink_decode and unpacked with
+ * ::sfx_payload_unpack equal the quantized, clamped values of a reference model, including delta fields that step
+ * beyond the range of `int32_t`
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "check.h"
+#include "payload_pack.h"
+#include "uplink_class.h"
+#include "uplink.h"
+#include "common.h"
+
+#define SCHEMAS 50000
+#define MAX_FIELDS 12
+
+/**
+ * @brief reference quantization: round to nearest multiple of scale (halves away from zero), saturate or reject
+ * @return false if value is out of range and field does not saturate
+ */
+static bool check_quantize(const sfx_payload_field *field, int64_t previous, int32_t value, int64_t *reconstructed)
+{
+	bool delta = field->encoding == SFX_PAYLOAD_DELTA;
+	int64_t base = delta ? previous : field->offset;
+	int64_t difference = (int64_t)value - base;
+	int64_t code = difference >= 0 ? (difference + field->scale / 2) / field->scale : -((-difference + field->scale / 2) / field->scale);
+	int64_t min = delta ? -(1LL << (field->bits - 1)) : 0;
+	int64_t max = delta ? (1LL << (field->bits - 1)) - 1 : (1LL << field->bits) - 1;
+
+	if (code < min || code > max) {
+		if (!field->saturate)
+			return false;
+		code = code < min ? min : max;
+	}
+
+	*reconstructed = base + code * field->scale;
+	if (*reconstructed > INT32_MAX)
+		*reconstructed = INT32_MAX;
+	if (*reconstructed < INT32_MIN)
+		*reconstructed = INT32_MIN;
+
+	return true;
+}
+
+static void check_random_field(sfx_payload_field *field, uint8_t bits, bool first)
+{
+	field->bits = bits;
+	field->encoding = !first && check_rng() % 3 == 0 ? SFX_PAYLOAD_DELTA : SFX_PAYLOAD_LINEAR;
+	field->saturate = check_rng() & 0x01;
+
+	// large steps of delta fields reach beyond the range of int32_t
+	field->scale = 1;
+	if (check_rng() % 4 == 0)
+		field->scale += check_rng() % (field->encoding == SFX_PAYLOAD_DELTA && check_rng() % 4 == 0 ? 1000000000 : 100);
+
+	field->offset = (int32_t)(check_rng() % 2000) - 1000;
+	if (bits >= 30)
+		field->offset = bits == 32 ? INT32_MIN : -(1 << 29);
+
+	// largest value of linear fields must be representable, see ::sfx_payload_schema_init
+	if (field->encoding == SFX_PAYLOAD_LINEAR && field->offset + ((1LL << bits) - 1) * field->scale > INT32_MAX)
+		field->scale = 1;
+}
+
+static int32_t check_random_value(const sfx_payload_field *field, int64_t previous)
+{
+	// mostly representable values, some beyond the range of the field, some extremes
+	switch (check_rng() % 16) {
+	case 0:
+		return INT32_MAX;
+	case 1:
+		return INT32_MIN;
+	}
+
+	int64_t span = (1LL << field->bits) * field->scale;
+	if (span > (1LL << 31))
+		span = 1LL << 31;
+	if (check_rng() % 8 == 0)
+		span += span / 4;
+
+	int64_t value = field->encoding == SFX_PAYLOAD_DELTA ? previous - span / 2 : field->offset;
+	value += (int64_t)(((uint64_t)check_rng() << 32 | check_rng()) % (uint64_t)span);
+
+	return value > INT32_MAX ? INT32_MAX : value < INT32_MIN ? INT32_MIN : value;
+}
+
+int main(void)
+{
+	sfx_commoninfo common;
+	sfx_ul_plain unused;
+
+	check_random_uplink(&unused, &common);
+
+	for (uint32_t round = 0; round < SCHEMAS; ++round) {
+		sfx_payload_field fields[MAX_FIELDS];
+		sfx_payload_schema schema;
+		uint8_t count = 0;
+		uint16_t bits = 0;
+
+		// single-bit schemas and every frame class
+		if (check_rng() % 20 == 0) {
+			fields[count++] = (sfx_payload_field)SFX_PAYLOAD_UINT(1);
+			bits = 1;
+		} else {
+			uint16_t budget = 1 + check_rng() % SFX_PAYLOAD_MAX_BITS;
+			while (count < MAX_FIELDS && bits < budget) {
+				uint8_t width = 1 + check_rng() % SFX_PAYLOAD_FIELD_MAX_BITS;
+				if (width > budget - bits)
+					width = budget - bits;
+				check_random_field(&fields[count], width, count == 0);
+				bits += width;
+				count++;
+			}
+		}
+
+		CHECK(sfx_payload_schema_init(&schema, fields, count) == SFX_PACK_ERR_NONE);
+		CHECK(schema.bits == bits && schema.singlebit == (bits == 1));
+		CHECK(schema.payloadlen == (bits == 1 ? 0 : (bits + 7) / 8));
+
+		/*
+		 * Reference values of unpacker, or range error
+		 */
+		int32_t values[MAX_FIELDS], unpacked[MAX_FIELDS];
+		int64_t expected[MAX_FIELDS], previous = 0;
+		bool representable = true;
+
+		for (uint8_t i = 0; i < count; ++i) {
+			values[i] = check_random_value(&fields[i], previous);
+			if (representable && !check_quantize(&fields[i], previous, values[i], &expected[i]))
+				representable = false;
+			previous = representable ? expected[i] : values[i];
+		}
+
+		sfx_ul_plain uplink;
+		memset(&uplink, 0xa5, sizeof(uplink));
+		uplink.request_downlink = check_rng() & 0x01;
+		uplink.replicas = true;
+		sfx_ul_plain before = uplink;
+
+		sfx_pack_err err = sfx_payload_pack(&schema, values, &uplink);
+		if (!representable) {
+			// uplink is not modified if a value is rejected
+			CHECK(err == SFX_PACK_ERR_RANGE && memcmp(&uplink, &before, sizeof(uplink)) == 0);
+			continue;
+		}
+
+		CHECK(err == SFX_PACK_ERR_NONE);
+		CHECK(uplink.payloadlen == schema.payloadlen && uplink.singlebit == schema.singlebit);
+		CHECK(uplink.request_downlink == before.request_downlink && uplink.replicas);
+		CHECK(sfx_uplink_frameclass(&uplink) == schema.frameclass);
+
+		/*
+		 * Packed payload survives encoding and decoding, unpacked values match reference
+		 */
+		sfx_ul_encoded encoded;
+		sfx_ul_plain decoded;
+		sfx_commoninfo received;
+
+		common.seqnum = (common.seqnum + 1) & 0xfff;
+		CHECK(sfx_uplink_encode(uplink, common, &encoded) == SFX_ULE_ERR_NONE);
+		memset(&received, 0, sizeof(received));
+		memcpy(received.key, common.key, sizeof(received.key));
+		CHECK(sfx_uplink_decode(encoded, &decoded, &received, true) == SFX_ULD_ERR_NONE);
+
+		CHECK(sfx_payload_unpack(&schema, &decoded, unpacked) == SFX_PACK_ERR_NONE);
+		for (uint8_t i = 0; i < count; ++i)
+			CHECK(unpacked[i] == expected[i]);
+
+		// reconstructed values are exactly representable, packing them again yields the same payload
+		sfx_ul_plain repacked;
+		CHECK(sfx_payload_pack(&schema, unpacked, &repacked) == SFX_PACK_ERR_NONE);
+		CHECK(memcmp(repacked.payload, uplink.payload, schema.singlebit ? 1 : schema.payloadlen) == 0);
+
+		// payload of a different length does not match the schema
+		decoded.payloadlen = schema.singlebit ? 1 : schema.payloadlen % SFX_UL_MAX_PAYLOADLEN + 1;
+		decoded.singlebit = false;
+		CHECK(sfx_payload_unpack(&schema, &decoded, unpacked) == SFX_PACK_ERR_LENGTH);
+	}
+
+	// invalid schemas: empty, too long, zero width or scale, linear field beyond int32_t
+	sfx_payload_field invalid[4] = {SFX_PAYLOAD_UINT(32), SFX_PAYLOAD_UINT(32), SFX_PAYLOAD_UINT(32), SFX_PAYLOAD_UINT(1)};
+	sfx_payload_schema schema;
+	CHECK(sfx_payload_schema_init(&schema, invalid, 0) == SFX_PACK_ERR_SCHEMA);
+	CHECK(sfx_payload_schema_init(&schema, &invalid[0], 1) == SFX_PACK_ERR_SCHEMA);
+	invalid[0].offset = invalid[1].offset = invalid[2].offset = INT32_MIN;
+	CHECK(sfx_payload_schema_init(&schema, invalid, 3) == SFX_PACK_ERR_NONE);
+	CHECK(sfx_payload_schema_init(&schema, invalid, 4) == SFX_PACK_ERR_SCHEMA);
+	invalid[3].scale = 0;
+	CHECK(sfx_payload_schema_init(&schema, &invalid[3], 1) == SFX_PACK_ERR_SCHEMA);
+	invalid[3].scale = 1;
+	invalid[3].bits = 0;
+	CHECK(sfx_payload_schema_init(&schema, &invalid[3], 1) == SFX_PACK_ERR_SCHEMA);
+
+	return check_report("check-pack");
+}
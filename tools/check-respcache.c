@@ -0,0 +1,100 @@
+/*
+ * check-respcache: downlink responses served from the response cache (::sfx_downlink_cache_get) for uplinks decoded
+ * with ::sfx_uplink_decode are identical to frames encoded with ::sfx_downlink_encode and decode correctly with
+ * ::sfx_downlink_decode, while the window slides, is refilled with limited budgets and the payload changes
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "check.h"
+#include "uplink.h"
+#include "downlink.h"
+#include "common.h"
+
+#define DEVICES 40
+#define FRAMES 300
+#define MAX_CAPACITY 256
+
+int main(void)
+{
+	static sfx_dl_encoded frames[MAX_CAPACITY];
+
+	for (uint32_t device = 0; device < DEVICES; ++device) {
+		sfx_dl_cache cache;
+		sfx_ul_plain uplink;
+		sfx_commoninfo common;
+		uint8_t payload[SFX_DL_PAYLOADLEN];
+
+		check_random_uplink(&uplink, &common);
+		check_rng_fill(payload, sizeof(payload));
+
+		uint16_t capacity = 1 << (check_rng() % 9);
+		uint16_t ready = 0;
+
+		CHECK(!sfx_downlink_cache_init(&cache, &common, payload, common.seqnum, frames, capacity * 3));
+		CHECK(sfx_downlink_cache_init(&cache, &common, payload, common.seqnum, frames, capacity));
+
+		for (uint32_t frame = 0; frame < FRAMES; ++frame) {
+			// background encoding with a limited budget, the cache never encodes more frames than its window holds
+			uint16_t budget = check_rng() % (capacity + 2);
+			uint16_t refilled = budget < capacity - ready ? budget : capacity - ready;
+			CHECK(sfx_downlink_cache_refill(&cache, budget) == refilled);
+			ready += refilled;
+
+			// application changes downlink payload now and then, which invalidates all cached frames
+			if (check_rng() % 32 == 0) {
+				bool changed = check_rng() & 0x01;
+				if (changed)
+					payload[check_rng() % sizeof(payload)] ^= 1 << (check_rng() % 8);
+				CHECK(sfx_downlink_cache_set_payload(&cache, payload) == changed);
+				if (changed)
+					ready = 0;
+			}
+
+			// device skips some sequence numbers, including sequence number wraparound
+			uint16_t gap = check_rng() % 4 == 0 ? check_rng() % 8 : 0;
+			common.seqnum = (cache.first + gap) & 0xfff;
+
+			/*
+			 * Server: decode uplink with downlink request, serve response from cache
+			 */
+			sfx_ul_encoded encoded;
+			sfx_ul_plain decoded;
+			sfx_commoninfo server;
+
+			uplink.request_downlink = true;
+			CHECK(sfx_uplink_encode(uplink, common, &encoded) == SFX_ULE_ERR_NONE);
+			memset(&server, 0, sizeof(server));
+			memcpy(server.key, common.key, sizeof(server.key));
+			CHECK(sfx_uplink_decode(encoded, &decoded, &server, true) == SFX_ULD_ERR_NONE);
+			CHECK(decoded.request_downlink && server.devid == common.devid && server.seqnum == common.seqnum);
+
+			const sfx_dl_encoded *cached = sfx_downlink_cache_get(&cache, server.seqnum);
+			CHECK((cached != NULL) == (gap < ready));
+
+			if (cached) {
+				sfx_dl_plain response, received;
+				sfx_dl_encoded expected;
+
+				memset(&response, 0, sizeof(response));
+				memcpy(response.payload, payload, sizeof(payload));
+				sfx_downlink_encode(response, server, &expected);
+				CHECK(memcmp(cached->frame, expected.frame, SFX_DL_FRAMELEN) == 0);
+
+				// device decodes the response with its own sequence number
+				sfx_downlink_decode(*cached, common, &received);
+				CHECK(received.crc_ok && received.mac_ok && !received.fec_corrected);
+				CHECK(memcmp(received.payload, payload, sizeof(payload)) == 0);
+			}
+
+			// slide window past the received uplink, frames that remain in the window stay valid
+			sfx_downlink_cache_advance(&cache, server.seqnum + 1);
+			ready = gap + 1 < ready ? ready - gap - 1 : 0;
+			CHECK(cache.ready == ready && cache.first == ((server.seqnum + 1) & 0xfff));
+			CHECK(sfx_downlink_cache_get(&cache, server.seqnum) == NULL);
+		}
+	}
+
+	return check_report("check-respcache");
+}
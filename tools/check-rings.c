@@ -0,0 +1,216 @@
+/*
+ * check-rings: frame records passed through the lock-free rings (::renard_spsc_ring, ::renard_mpmc_ring) by
+ * concurrent producer and consumer threads arrive complete, exactly once and (SPSC) in order; consumers decode every
+ * record and the results are compared with ::sfx_uplink_decode of the original frame
+ */
+#define _GNU_SOURCE
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "check.h"
+#include "ring.h"
+#include "uplink.h"
+#include "common.h"
+
+#define FRAMES 20000
+#define SPSC_CAPACITY 64
+#define MPMC_CAPACITY 32
+#define MPMC_PRODUCERS 3
+#define MPMC_CONSUMERS 3
+
+// received frames (with random bit errors) and the results of decoding them directly
+static sfx_frame_record records[FRAMES];
+static sfx_uld_err expected_err[FRAMES];
+static sfx_ul_plain expected_uplink[FRAMES];
+static sfx_commoninfo expected_common[FRAMES];
+
+// written by consumers, evaluated after all threads have finished
+static uint32_t received_count[FRAMES];
+static bool received_ok[FRAMES];
+static bool received_in_order = true;
+
+static renard_spsc_ring spsc;
+static renard_mpmc_ring mpmc;
+static uint32_t mpmc_consumed;
+
+static void consume(const sfx_frame_record *record)
+{
+	sfx_ul_plain uplink;
+	sfx_commoninfo common;
+	uint32_t index = record->timestamp;
+
+	memset(&common, 0, sizeof(common));
+	sfx_uld_err err = sfx_uplink_decode(record->frame.uplink, &uplink, &common, false);
+
+	__atomic_fetch_add(&received_count[index], 1, __ATOMIC_RELAXED);
+	received_ok[index] = record->gateway == index && !record->is_downlink &&
+			check_same_uplink(err, &uplink, &common, expected_err[index], &expected_uplink[index], &expected_common[index]);
+}
+
+static void *spsc_producer(void *arg)
+{
+	uint32_t next = 0;
+	(void)arg;
+
+	// alternate between zero-copy reservation and copying push
+	while (next < FRAMES) {
+		if (next % 2 == 0) {
+			uint32_t count = FRAMES - next;
+			sfx_frame_record *slots = renard_spsc_reserve(&spsc, &count);
+			for (uint32_t i = 0; i < count; ++i)
+				slots[i] = records[next + i];
+			renard_spsc_commit(&spsc, count);
+			next += count;
+			if (count == 0)
+				sched_yield();
+		} else {
+			uint32_t count = FRAMES - next < 7 ? FRAMES - next : 7;
+			count = renard_spsc_push(&spsc, &records[next], count);
+			next += count;
+			if (count == 0)
+				sched_yield();
+		}
+	}
+
+	return NULL;
+}
+
+static void *spsc_consumer(void *arg)
+{
+	sfx_frame_record batch[5];
+	uint32_t next = 0;
+	(void)arg;
+
+	while (next < FRAMES) {
+		uint32_t count = FRAMES - next;
+
+		if (next % 2 == 0) {
+			sfx_frame_record *slots = renard_spsc_peek(&spsc, &count);
+			for (uint32_t i = 0; i < count; ++i) {
+				received_in_order &= slots[i].timestamp == next + i;
+				consume(&slots[i]);
+			}
+			renard_spsc_release(&spsc, count);
+		} else {
+			count = renard_spsc_pop(&spsc, batch, 5);
+			for (uint32_t i = 0; i < count; ++i) {
+				received_in_order &= batch[i].timestamp == next + i;
+				consume(&batch[i]);
+			}
+		}
+
+		next += count;
+		if (count == 0)
+			sched_yield();
+	}
+
+	return NULL;
+}
+
+static void *mpmc_producer(void *arg)
+{
+	uintptr_t producer = (uintptr_t)arg;
+
+	for (uint32_t index = producer; index < FRAMES;) {
+		uint32_t ticket;
+		sfx_frame_record *slot = renard_mpmc_reserve(&mpmc, &ticket);
+		if (!slot) {
+			sched_yield();
+			continue;
+		}
+
+		*slot = records[index];
+		renard_mpmc_commit(&mpmc, ticket);
+		index += MPMC_PRODUCERS;
+	}
+
+	return NULL;
+}
+
+static void *mpmc_consumer(void *arg)
+{
+	sfx_frame_record record;
+	(void)arg;
+
+	while (__atomic_load_n(&mpmc_consumed, __ATOMIC_ACQUIRE) < FRAMES) {
+		if (renard_mpmc_pop(&mpmc, &record, 1) == 0) {
+			sched_yield();
+			continue;
+		}
+
+		consume(&record);
+		__atomic_fetch_add(&mpmc_consumed, 1, __ATOMIC_RELEASE);
+	}
+
+	return NULL;
+}
+
+static void check_received(void)
+{
+	for (uint32_t i = 0; i < FRAMES; ++i) {
+		CHECK(received_count[i] == 1);
+		CHECK(received_ok[i]);
+	}
+
+	memset(received_count, 0, sizeof(received_count));
+	memset(received_ok, 0, sizeof(received_ok));
+}
+
+int main(void)
+{
+	static uint8_t spsc_buffer[RENARD_SPSC_BUFSIZE(SPSC_CAPACITY, sizeof(sfx_frame_record))];
+	static uint8_t mpmc_buffer[RENARD_MPMC_BUFSIZE(MPMC_CAPACITY, sizeof(sfx_frame_record))];
+	pthread_t producers[MPMC_PRODUCERS], consumers[MPMC_CONSUMERS];
+
+	for (uint32_t i = 0; i < FRAMES; ++i) {
+		sfx_ul_plain uplink;
+		sfx_commoninfo common;
+		sfx_ul_encoded encoded;
+
+		check_random_uplink(&uplink, &common);
+		CHECK(sfx_uplink_encode(uplink, common, &encoded) == SFX_ULE_ERR_NONE);
+
+		memset(&records[i], 0, sizeof(records[i]));
+		records[i].timestamp = i;
+		records[i].gateway = i;
+		check_receive_uplink(&encoded, check_rng() % 3, check_rng() % 8 == 0 ? 1 : 0, &records[i].frame.uplink);
+
+		memset(&expected_common[i], 0, sizeof(expected_common[i]));
+		expected_err[i] = sfx_uplink_decode(records[i].frame.uplink, &expected_uplink[i], &expected_common[i], false);
+	}
+
+	/*
+	 * SPSC: one producer, one consumer, order is preserved
+	 */
+	CHECK(!renard_spsc_init(&spsc, spsc_buffer, SPSC_CAPACITY - 1, sizeof(sfx_frame_record)));
+	CHECK(renard_spsc_init(&spsc, spsc_buffer, SPSC_CAPACITY, sizeof(sfx_frame_record)));
+
+	pthread_create(&producers[0], NULL, spsc_producer, NULL);
+	pthread_create(&consumers[0], NULL, spsc_consumer, NULL);
+	pthread_join(producers[0], NULL);
+	pthread_join(consumers[0], NULL);
+
+	CHECK(received_in_order);
+	check_received();
+
+	/*
+	 * MPMC: several producers and consumers, every record arrives exactly once
+	 */
+	CHECK(renard_mpmc_init(&mpmc, mpmc_buffer, MPMC_CAPACITY, sizeof(sfx_frame_record)));
+
+	for (uintptr_t i = 0; i < MPMC_PRODUCERS; ++i)
+		pthread_create(&producers[i], NULL, mpmc_producer, (void *)i);
+	for (uintptr_t i = 0; i < MPMC_CONSUMERS; ++i)
+		pthread_create(&consumers[i], NULL, mpmc_consumer, NULL);
+	for (uintptr_t i = 0; i < MPMC_PRODUCERS; ++i)
+		pthread_join(producers[i], NULL);
+	for (uintptr_t i = 0; i < MPMC_CONSUMERS; ++i)
+		pthread_join(consumers[i], NULL);
+
+	check_received();
+
+	return check_report("check-rings");
+}
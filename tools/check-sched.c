@@ -0,0 +1,191 @@
+/*
+ * check-sched: decode scheduler (::sfx_uplink_sched_submit, ::sfx_uplink_sched_run) under overload with a small queue
+ * and varying budgets: hard decision results match ::sfx_uplink_decode, recovered frames match the transmitted
+ * uplinks, every frame is reported at most once, the counters account for every frame and the per-priority queues
+ * stay consistent
+ */
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "check.h"
+#include "uplink_sched.h"
+#include "uplink.h"
+#include "common.h"
+
+#define DEVICES 64
+#define FRAMES 20000
+#define CAPACITY 16
+#define MAX_AGE 4
+#define MAX_RESULTS 8
+
+typedef struct {
+	uint32_t devid;
+	uint8_t key[16];
+	bool known;
+} device;
+
+typedef struct {
+	sfx_ul_plain uplink;
+	sfx_commoninfo common;
+	uint8_t index;
+	uint8_t biterrors;
+	uint8_t reported;
+	bool queued;
+} transmission;
+
+static device devices[DEVICES];
+static transmission transmissions[FRAMES];
+
+// NAKs of a quarter of the devices are unknown, their frames are accepted without MAC check
+static bool check_lookup(void *context, uint32_t devid, uint8_t *key)
+{
+	(void)context;
+
+	for (uint16_t i = 0; i < DEVICES; ++i) {
+		if (devices[i].devid == devid && devices[i].known) {
+			memcpy(key, devices[i].key, sizeof(devices[i].key));
+			return true;
+		}
+	}
+
+	return false;
+}
+
+// per-priority lists are doubly linked, sorted by age and match the nonempty mask, unused entries are on the free list
+static bool check_queues(const sfx_ul_sched *sched)
+{
+	uint16_t queued = 0, unused = 0;
+
+	for (uint8_t priority = 0; priority < SFX_UL_SCHED_PRIORITIES; ++priority) {
+		uint16_t prev = SFX_UL_SCHED_NONE;
+
+		if ((sched->head[priority] != SFX_UL_SCHED_NONE) != ((sched->nonempty >> priority) & 0x01))
+			return false;
+
+		for (uint16_t index = sched->head[priority]; index != SFX_UL_SCHED_NONE; prev = index, index = sched->entries[index].next) {
+			const sfx_ul_sched_entry *entry = &sched->entries[index];
+
+			if (!entry->used || entry->priority != priority || entry->prev != prev)
+				return false;
+			if (prev != SFX_UL_SCHED_NONE && (int32_t)(entry->slice - sched->entries[prev].slice) < 0)
+				return false;
+			queued++;
+		}
+
+		if (sched->tail[priority] != prev)
+			return false;
+	}
+
+	for (uint16_t index = sched->free; index != SFX_UL_SCHED_NONE; index = sched->entries[index].next) {
+		if (sched->entries[index].used)
+			return false;
+		unused++;
+	}
+
+	return queued == sched->queued && unused == sched->capacity - sched->queued;
+}
+
+static void check_result(const sfx_ul_sched_result *result, uint32_t recovered[2])
+{
+	CHECK(result->tag < FRAMES);
+	if (result->tag >= FRAMES)
+		return;
+
+	transmission *sent = &transmissions[result->tag];
+	CHECK(sent->queued && sent->reported == 0);
+	CHECK(result->escalated);
+	sent->reported++;
+
+	recovered[result->status == SFX_ULD_ERR_NONE]++;
+
+	/*
+	 * Bit flipping may miscorrect frames with multiple bit errors, only the MAC check rejects those reliably. A single
+	 * bit error in a replica also becomes multiple bit errors once the convolutional code is inverted.
+	 */
+	if (result->status == SFX_ULD_ERR_NONE && (result->mac_checked || (sent->biterrors <= 1 && sent->index == 0)))
+		CHECK(check_same_uplink(result->status, &result->uplink, &result->common, SFX_ULD_ERR_NONE, &sent->uplink, &sent->common));
+}
+
+int main(void)
+{
+	static sfx_ul_sched_entry entries[CAPACITY];
+	sfx_ul_sched_result results[MAX_RESULTS];
+	uint32_t recovered[2] = {0, 0};
+	sfx_ul_sched sched;
+
+	for (uint16_t i = 0; i < DEVICES; ++i) {
+		devices[i].devid = check_rng();
+		devices[i].known = i % 4 != 0;
+		check_rng_fill(devices[i].key, sizeof(devices[i].key));
+	}
+
+	CHECK(!sfx_uplink_sched_init(&sched, entries, 0, MAX_AGE, check_lookup, NULL));
+	CHECK(sfx_uplink_sched_init(&sched, entries, CAPACITY, MAX_AGE, check_lookup, NULL));
+	CHECK(check_queues(&sched));
+
+	for (uint32_t tag = 0; tag < FRAMES; ++tag) {
+		transmission *sent = &transmissions[tag];
+		const device *sender = &devices[check_rng() % DEVICES];
+		sfx_ul_encoded encoded, received;
+
+		check_random_uplink(&sent->uplink, &sent->common);
+		sent->common.devid = sender->devid;
+		memcpy(sent->common.key, sender->key, sizeof(sent->common.key));
+		CHECK(sfx_uplink_encode(sent->uplink, sent->common, &encoded) == SFX_ULE_ERR_NONE);
+
+		// mostly valid frames, many with bit errors anywhere in the frame, a few with wrong length
+		sent->index = check_rng() % 3;
+		sent->biterrors = check_rng() % 2 ? check_rng() % 4 : 0;
+		check_receive_uplink(&encoded, sent->index, sent->biterrors, &received);
+		if (check_rng() % 50 == 0)
+			received.framelen_nibbles -= 2;
+
+		/*
+		 * Hard decision decoding on submission, as by ::sfx_uplink_decode with MAC check if the NAK is known
+		 */
+		sfx_ul_sched_result result;
+		sfx_ul_plain expected;
+		sfx_commoninfo expected_common;
+		uint16_t queued = sched.queued;
+
+		memset(&expected_common, 0, sizeof(expected_common));
+		sfx_uld_err expected_err = sfx_uplink_decode(received, &expected, &expected_common, false);
+		bool mac_checked = expected_err == SFX_ULD_ERR_NONE && check_lookup(NULL, expected_common.devid, expected_common.key);
+		if (mac_checked)
+			expected_err = sfx_uplink_decode(received, &expected, &expected_common, true);
+
+		sfx_uld_err err = sfx_uplink_sched_submit(&sched, &received, tag, &result);
+		CHECK(result.tag == tag && !result.escalated && result.status == err && result.mac_checked == mac_checked);
+		CHECK(check_same_uplink(err, &result.uplink, &result.common, expected_err, &expected, &expected_common));
+
+		sent->queued = err != SFX_ULD_ERR_NONE && err != SFX_ULD_ERR_MAC_INVALID;
+		CHECK(sent->queued || sched.queued == queued);
+		CHECK(check_queues(&sched));
+
+		// escalated decoding with varying budgets, often too small to keep up
+		if (check_rng() % 3 == 0) {
+			uint16_t count = sfx_uplink_sched_run(&sched, check_rng() % 150, results, 1 + check_rng() % MAX_RESULTS);
+			for (uint16_t i = 0; i < count; ++i)
+				check_result(&results[i], recovered);
+			CHECK(check_queues(&sched));
+		}
+	}
+
+	// drain queue, frames either finish or expire
+	for (uint32_t slice = 0; slice <= MAX_AGE; ++slice) {
+		uint16_t count;
+		while ((count = sfx_uplink_sched_run(&sched, 100000, results, MAX_RESULTS)) > 0)
+			for (uint16_t i = 0; i < count; ++i)
+				check_result(&results[i], recovered);
+	}
+	CHECK(sched.queued == 0 && check_queues(&sched));
+
+	const sfx_ul_sched_stats *stats = &sched.stats;
+	CHECK(stats->submitted == FRAMES);
+	CHECK(stats->recovered == recovered[1] && stats->failed == recovered[0]);
+	CHECK(stats->submitted == stats->decoded + stats->rejected + stats->recovered + stats->failed + stats->shed_full + stats->shed_expired + sched.queued);
+	CHECK(stats->recovered > 0 && stats->shed_full > 0);
+
+	return check_report("check-sched");
+}
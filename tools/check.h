@@ -0,0 +1,124 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "uplink.h"
+#include "common.h"
+
+#ifndef _CHECK_H
+#define _CHECK_H
+
+/*
+ * Helpers of the self-checking drivers (tools/check-*.c) that are run by `make check`: every driver exercises one
+ * API with deterministic pseudo-random inputs, compares its results against the plain encoders / decoders
+ * (::sfx_uplink_decode, ::sfx_downlink_decode) and exits with failure if any check failed.
+ */
+
+/// number of failed checks
+static uint32_t check_failures = 0;
+
+/// number of evaluated checks
+static uint32_t check_count = 0;
+
+/**
+ * @brief evaluate a condition, report the location if it does not hold and continue, so that all failures are listed
+ */
+#define CHECK(condition) do { \
+		check_count++; \
+		if (!(condition)) { \
+			if (check_failures++ < 20) \
+				fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+		} \
+	} while (0)
+
+static uint64_t check_rng_state = 1;
+
+/**
+ * @brief deterministic pseudo-random number generator (64-bit LCG, upper bits), so that failures are reproducible
+ */
+static inline uint32_t check_rng(void)
+{
+	check_rng_state = check_rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return check_rng_state >> 33;
+}
+
+static inline void check_rng_fill(uint8_t *buffer, uint16_t length)
+{
+	for (uint16_t i = 0; i < length; ++i)
+		buffer[i] = check_rng();
+}
+
+/**
+ * @brief random uplink of any frame class (single-bit frames included) and random device ID, sequence number and NAK
+ * @param uplink output, contents of uplink, replicas are requested
+ * @param common output, Sigfox object
+ */
+static inline void check_random_uplink(sfx_ul_plain *uplink, sfx_commoninfo *common)
+{
+	memset(uplink, 0, sizeof(*uplink));
+	memset(common, 0, sizeof(*common));
+
+	uplink->payloadlen = check_rng() % (SFX_UL_MAX_PAYLOADLEN + 1);
+	uplink->singlebit = uplink->payloadlen == 0;
+	check_rng_fill(uplink->payload, uplink->payloadlen);
+	if (uplink->singlebit)
+		uplink->payload[0] = check_rng() & 0x01;
+	uplink->request_downlink = check_rng() & 0x01;
+	uplink->replicas = true;
+
+	common->devid = check_rng();
+	common->seqnum = check_rng() & 0xfff;
+	check_rng_fill(common->key, sizeof(common->key));
+}
+
+/**
+ * @brief copy one transmission of an encoded uplink to the first frame of `out` and flip random bits
+ * @param encoded encoded uplink, see ::sfx_uplink_encode
+ * @param transmission index of transmission to copy (0: initial transmission, 1 / 2: replicas)
+ * @param biterrors number of bits to flip, anywhere in the frame including the frame type
+ * @param out output, frame as received
+ */
+static inline void check_receive_uplink(const sfx_ul_encoded *encoded, uint8_t transmission, uint8_t biterrors, sfx_ul_encoded *out)
+{
+	memset(out, 0, sizeof(*out));
+	memcpy(out->frame[0], encoded->frame[transmission], SFX_UL_MAX_FRAMELEN);
+	out->framelen_nibbles = encoded->framelen_nibbles;
+
+	for (uint8_t i = 0; i < biterrors; ++i) {
+		uint16_t bit = check_rng() % (encoded->framelen_nibbles * 4);
+		out->frame[0][bit / 8] ^= 0x80 >> (bit % 8);
+	}
+}
+
+/**
+ * @brief compare the results of decoding an uplink: status, device ID, sequence number and contents
+ * @return true if both results are identical
+ */
+static inline bool check_same_uplink(sfx_uld_err err_a, const sfx_ul_plain *a, const sfx_commoninfo *common_a, sfx_uld_err err_b, const sfx_ul_plain *b, const sfx_commoninfo *common_b)
+{
+	if (err_a != err_b)
+		return false;
+
+	// contents are only defined if the CRC is valid
+	if (err_a != SFX_ULD_ERR_NONE && err_a != SFX_ULD_ERR_MAC_INVALID)
+		return true;
+
+	return a->singlebit == b->singlebit && a->request_downlink == b->request_downlink && a->payloadlen == b->payloadlen &&
+			memcmp(a->payload, b->payload, a->singlebit ? 1 : a->payloadlen) == 0 &&
+			common_a->devid == common_b->devid && common_a->seqnum == common_b->seqnum;
+}
+
+/**
+ * @brief print summary of driver
+ * @param name name of driver
+ * @return exit status of driver
+ */
+static inline int check_report(const char *name)
+{
+	printf("%-20s %u checks, %u failed: %s\n", name, check_count, check_failures, check_failures ? "FAILED" : "ok");
+	return check_failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+#endif
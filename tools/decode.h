@@ -0,0 +1,142 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "uplink.h"
+#include "downlink.h"
+#include "capture.h"
+#include "keys.h"
+
+#ifndef _DECODE_H
+#define _DECODE_H
+
+/**
+ * @brief decoded capture record in row form, the columns of the columnar output format (see capture.h) in one struct
+ */
+typedef struct _s_sfx_decoded_record {
+	uint64_t timestamp;
+	uint32_t gateway;
+	uint32_t devid;
+	uint16_t seqnum;
+
+	/// uplinks: ::sfx_uld_err, downlinks: 0
+	uint8_t status;
+
+	/// combination of SFX_DECODED_FLAG_* values
+	uint8_t flags;
+
+	uint8_t payloadlen;
+	uint8_t payload[SFX_UL_MAX_PAYLOADLEN];
+	uint8_t reserved[7];
+} sfx_decoded_record;
+
+/**
+ * @brief ground truth for a generated capture record (see renard-generate.c), truth files are arrays of this struct
+ * in the same order as the records of the corresponding capture file
+ */
+typedef struct _s_sfx_truth_record {
+	/// expected decoding result, MAC is expected to be valid if the device's NAK is known
+	sfx_decoded_record expected;
+
+	/// number of bit errors injected into frame, including burst and frame type errors
+	uint16_t biterrors;
+
+	/// indicates whether frame type field was corrupted
+	uint8_t ftype_corrupted;
+
+	/// indicates whether a burst error was injected
+	uint8_t burst;
+
+	/// reserved, must be zero
+	uint8_t reserved[4];
+} sfx_truth_record;
+
+/**
+ * @brief decode a single capture record; uplink MACs and downlink MACs are checked if the device's NAK is in the key table
+ * @param record capture record
+ * @param keys table of known NAKs
+ * @param out output, decoded record
+ * @return true if frame was decoded and its CRC is valid
+ */
+static inline bool sfx_decode_record(const sfx_capture_record *record, const sfx_keytable *keys, sfx_decoded_record *out)
+{
+	sfx_commoninfo common;
+
+	memset(out, 0, sizeof(*out));
+	memset(&common, 0, sizeof(common));
+	out->timestamp = record->timestamp;
+	out->gateway = record->gateway;
+
+	if (record->type == SFX_CAPTURE_UPLINK) {
+		sfx_ul_encoded encoded;
+		sfx_ul_plain plain;
+
+		memcpy(encoded.frame[0], record->frame, SFX_UL_MAX_FRAMELEN);
+		encoded.framelen_nibbles = record->framelen_nibbles;
+
+		// Decode once without MAC check to obtain device ID, then check MAC if key is known
+		out->status = sfx_uplink_decode_trial(encoded, &plain, &common, false, SFX_UL_FTYPE_TRIAL_DISTANCE);
+		if (out->status == SFX_ULD_ERR_NONE && sfx_keytable_lookup(keys, common.devid, common.key)) {
+			out->flags |= SFX_DECODED_FLAG_MAC_CHECKED;
+			out->status = sfx_uplink_decode_trial(encoded, &plain, &common, true, SFX_UL_FTYPE_TRIAL_DISTANCE);
+		}
+
+		if (out->status == SFX_ULD_ERR_NONE || out->status == SFX_ULD_ERR_MAC_INVALID) {
+			out->flags |= SFX_DECODED_FLAG_CRC_OK;
+			out->flags |= plain.singlebit ? SFX_DECODED_FLAG_SINGLEBIT : 0;
+			out->flags |= plain.request_downlink ? SFX_DECODED_FLAG_REQUEST_DOWNLINK : 0;
+			out->flags |= out->status == SFX_ULD_ERR_NONE && (out->flags & SFX_DECODED_FLAG_MAC_CHECKED) ? SFX_DECODED_FLAG_MAC_OK : 0;
+			out->payloadlen = plain.singlebit ? 1 : plain.payloadlen;
+			memcpy(out->payload, plain.payload, out->payloadlen);
+		}
+	} else {
+		sfx_dl_encoded encoded;
+		sfx_dl_plain plain;
+
+		common.devid = record->devid;
+		common.seqnum = record->seqnum;
+		if (sfx_keytable_lookup(keys, common.devid, common.key))
+			out->flags |= SFX_DECODED_FLAG_MAC_CHECKED;
+
+		memcpy(encoded.frame, record->frame, SFX_DL_FRAMELEN);
+		sfx_downlink_decode(encoded, common, &plain);
+
+		out->flags |= SFX_DECODED_FLAG_DOWNLINK;
+		out->flags |= plain.crc_ok ? SFX_DECODED_FLAG_CRC_OK : 0;
+		out->flags |= plain.mac_ok && (out->flags & SFX_DECODED_FLAG_MAC_CHECKED) ? SFX_DECODED_FLAG_MAC_OK : 0;
+		out->flags |= plain.fec_corrected ? SFX_DECODED_FLAG_FEC_CORRECTED : 0;
+		out->payloadlen = SFX_DL_PAYLOADLEN;
+		memcpy(out->payload, plain.payload, SFX_DL_PAYLOADLEN);
+	}
+
+	out->devid = common.devid;
+	out->seqnum = common.seqnum;
+
+	return (out->flags & SFX_DECODED_FLAG_CRC_OK) != 0;
+}
+
+/**
+ * @brief check whether decoded record matches ground truth: CRC valid, same device, sequence number and payload,
+ * and valid MAC if it was checked
+ * @param decoded decoded record, see ::sfx_decode_record
+ * @param expected expected decoding result, see sfx_truth_record::expected
+ * @return true if record was decoded correctly
+ */
+static inline bool sfx_decoded_matches(const sfx_decoded_record *decoded, const sfx_decoded_record *expected)
+{
+	if (!(decoded->flags & SFX_DECODED_FLAG_CRC_OK))
+		return false;
+
+	if ((decoded->flags & SFX_DECODED_FLAG_MAC_CHECKED) && !(decoded->flags & SFX_DECODED_FLAG_MAC_OK))
+		return false;
+
+	uint8_t compared = SFX_DECODED_FLAG_DOWNLINK | SFX_DECODED_FLAG_SINGLEBIT | SFX_DECODED_FLAG_REQUEST_DOWNLINK;
+	if ((decoded->flags & compared) != (expected->flags & compared))
+		return false;
+
+	return decoded->devid == expected->devid && decoded->seqnum == expected->seqnum &&
+			decoded->payloadlen == expected->payloadlen &&
+			memcmp(decoded->payload, expected->payload, decoded->payloadlen) == 0;
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#ifndef _KEYS_H
+#define _KEYS_H
+
+/*
+ * Device ID -> NAK lookup table for tools, loaded from a text file with one
+ * "<devid hex> <NAK hex>" pair per line, e.g. "004d33db 479e4480fd7596d6a4fb8f2bd38c21e9"
+ */
+typedef struct _s_sfx_keyentry {
+	uint32_t devid;
+	uint8_t key[16];
+} sfx_keyentry;
+
+typedef struct _s_sfx_keytable {
+	/// entries sorted by device ID
+	sfx_keyentry *entries;
+	size_t count;
+} sfx_keytable;
+
+static int sfx_keyentry_compare(const void *a, const void *b)
+{
+	uint32_t da = ((const sfx_keyentry *)a)->devid;
+	uint32_t db = ((const sfx_keyentry *)b)->devid;
+
+	return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+/**
+ * @brief load key table from text file
+ * @param table output, key table, free with ::sfx_keytable_free
+ * @param filename path to key file
+ * @return true on success, false if file could not be read or contains an invalid line
+ */
+static inline bool sfx_keytable_load(sfx_keytable *table, const char *filename)
+{
+	FILE *file = fopen(filename, "r");
+	if (!file)
+		return false;
+
+	size_t capacity = 0;
+	char line[128];
+	table->entries = NULL;
+	table->count = 0;
+
+	while (fgets(line, sizeof(line), file)) {
+		char keyhex[33];
+		unsigned int devid;
+
+		if (line[0] == '#' || line[0] == '\n')
+			continue;
+
+		if (sscanf(line, "%x %32s", &devid, keyhex) != 2 || strlen(keyhex) != 32)
+			goto error;
+
+		if (table->count == capacity) {
+			capacity = capacity ? capacity * 2 : 64;
+			sfx_keyentry *entries = realloc(table->entries, capacity * sizeof(sfx_keyentry));
+			if (!entries)
+				goto error;
+			table->entries = entries;
+		}
+
+		sfx_keyentry *entry = &table->entries[table->count++];
+		entry->devid = devid;
+		for (int i = 0; i < 16; ++i) {
+			unsigned int byte;
+			sscanf(&keyhex[i * 2], "%2x", &byte);
+			entry->key[i] = byte;
+		}
+	}
+
+	fclose(file);
+	qsort(table->entries, table->count, sizeof(sfx_keyentry), sfx_keyentry_compare);
+
+	return true;
+
+error:
+	fclose(file);
+	free(table->entries);
+	table->entries = NULL;
+	table->count = 0;
+	return false;
+}
+
+/**
+ * @brief look up NAK of given device
+ * @param table key table
+ * @param devid device ID
+ * @param key output, NAK of device, only written if device was found
+ * @return true if device was found
+ */
+static inline bool sfx_keytable_lookup(const sfx_keytable *table, uint32_t devid, uint8_t *key)
+{
+	sfx_keyentry search = { .devid = devid };
+
+	if (table->count == 0)
+		return false;
+
+	const sfx_keyentry *entry = bsearch(&search, table->entries, table->count, sizeof(sfx_keyentry), sfx_keyentry_compare);
+	if (!entry)
+		return false;
+
+	memcpy(key, entry->key, 16);
+	return true;
+}
+
+static inline void sfx_keytable_free(sfx_keytable *table)
+{
+	free(table->entries);
+	table->entries = NULL;
+	table->count = 0;
+}
+
+#endif
@@ -0,0 +1,62 @@
+#include <inttypes.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+#ifndef _NET_H
+#define _NET_H
+
+/*
+ * Socket helpers shared by ingest daemon and replayer
+ * Every datagram carries exactly one capture record (see capture.h).
+ */
+
+/// default UDP port for raw frames from gateways
+#define SFX_INGEST_DEFAULT_PORT 16401
+
+/// maximum number of datagrams per recvmmsg / sendmmsg call
+#define SFX_NET_MAX_BATCH 1024
+
+/**
+ * @brief current time in microseconds since the Unix epoch, used for capture record timestamps
+ */
+static inline uint64_t sfx_now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_REALTIME, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/**
+ * @brief fill socket address for UDP (if `unixpath` is NULL) or Unix domain datagram socket
+ * @return length of address, 0 if address is invalid
+ */
+static inline socklen_t sfx_net_address(struct sockaddr_storage *addr, const char *unixpath, const char *host, uint16_t port)
+{
+	memset(addr, 0, sizeof(*addr));
+
+	if (unixpath) {
+		struct sockaddr_un *un = (struct sockaddr_un *)addr;
+		if (strlen(unixpath) >= sizeof(un->sun_path))
+			return 0;
+		un->sun_family = AF_UNIX;
+		strcpy(un->sun_path, unixpath);
+		return sizeof(*un);
+	}
+
+	struct sockaddr_in *in = (struct sockaddr_in *)addr;
+	in->sin_family = AF_INET;
+	in->sin_port = htons(port);
+	if (inet_pton(AF_INET, host, &in->sin_addr) != 1)
+		return 0;
+
+	return sizeof(*in);
+}
+
+#endif
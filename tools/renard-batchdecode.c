@@ -0,0 +1,251 @@
+/*
+ * renard-batchdecode: decode archived captures (see capture.h) in parallel
+ *
+ * The capture file is memory-mapped and split into equally sized record ranges, one per worker thread.
+ * Every worker writes its results in place into the memory-mapped columnar output file.
+ */
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "uplink.h"
+#include "downlink.h"
+#include "capture.h"
+#include "decode.h"
+#include "keys.h"
+
+#define MAX_WORKERS 256
+
+typedef struct {
+	const sfx_capture_header *capture;
+	const sfx_keytable *keys;
+	uint8_t *columns[SFX_DECODED_COLUMNS];
+	uint64_t first;
+	uint64_t outfirst;
+	uint64_t count;
+	uint64_t decoded_ok;
+} worker;
+
+static void decode_record(worker *w, const sfx_capture_record *record, uint64_t out)
+{
+	sfx_decoded_record decoded;
+
+	if (sfx_decode_record(record, w->keys, &decoded))
+		w->decoded_ok++;
+
+	((uint64_t *)w->columns[SFX_DECODED_COL_TIMESTAMP])[out] = decoded.timestamp;
+	((uint32_t *)w->columns[SFX_DECODED_COL_GATEWAY])[out] = decoded.gateway;
+	w->columns[SFX_DECODED_COL_STATUS][out] = decoded.status;
+	w->columns[SFX_DECODED_COL_FLAGS][out] = decoded.flags;
+	((uint32_t *)w->columns[SFX_DECODED_COL_DEVID])[out] = decoded.devid;
+	((uint16_t *)w->columns[SFX_DECODED_COL_SEQNUM])[out] = decoded.seqnum;
+	w->columns[SFX_DECODED_COL_PAYLOADLEN][out] = decoded.payloadlen;
+	memcpy(&w->columns[SFX_DECODED_COL_PAYLOAD][out * SFX_UL_MAX_PAYLOADLEN], decoded.payload, SFX_UL_MAX_PAYLOADLEN);
+}
+
+static void *worker_run(void *arg)
+{
+	worker *w = arg;
+
+	for (uint64_t i = 0; i < w->count; ++i)
+		decode_record(w, sfx_capture_record_get(w->capture, w->first + i), w->outfirst + i);
+
+	return NULL;
+}
+
+/**
+ * @brief find first record with timestamp >= `timestamp`, records have to be ordered by timestamp
+ */
+static uint64_t find_record(const sfx_capture_header *capture, uint64_t timestamp)
+{
+	uint64_t lo = 0;
+	uint64_t hi = capture->record_count;
+
+	// Narrow down search range using index, then bisect records
+	uint64_t index_count = sfx_capture_index_count(capture);
+	if (index_count > 0) {
+		const sfx_capture_index_entry *index = (const sfx_capture_index_entry *)((const uint8_t *)capture + capture->index_offset);
+		uint64_t ilo = 0, ihi = index_count;
+		while (ilo < ihi) {
+			uint64_t mid = (ilo + ihi) / 2;
+			if (index[mid].timestamp < timestamp)
+				ilo = mid + 1;
+			else
+				ihi = mid;
+		}
+
+		// index entries are not trusted, they only narrow the range if they are consistent
+		if (ilo > 0 && index[ilo - 1].record <= capture->record_count)
+			lo = index[ilo - 1].record;
+		if (ilo < index_count && index[ilo].record <= capture->record_count)
+			hi = index[ilo].record;
+		if (lo > hi) {
+			lo = 0;
+			hi = capture->record_count;
+		}
+	}
+
+	while (lo < hi) {
+		uint64_t mid = (lo + hi) / 2;
+		if (sfx_capture_record_get(capture, mid)->timestamp < timestamp)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-j workers] [-k keyfile] [-f from_us] [-t to_us] <capture> <output>\n", name);
+	fprintf(stderr, "  -j workers  number of decoder threads (default: number of CPUs)\n");
+	fprintf(stderr, "  -k keyfile  text file with one \"<devid hex> <NAK hex>\" pair per line, enables MAC checking\n");
+	fprintf(stderr, "  -f from_us  only decode records with timestamp >= from_us (records must be time-ordered)\n");
+	fprintf(stderr, "  -t to_us    only decode records with timestamp < to_us (records must be time-ordered)\n");
+}
+
+int main(int argc, char **argv)
+{
+	long workers = sysconf(_SC_NPROCESSORS_ONLN);
+	const char *keyfile = NULL;
+	uint64_t from = 0;
+	uint64_t to = UINT64_MAX;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "j:k:f:t:h")) != -1) {
+		switch (opt) {
+		case 'j': workers = strtol(optarg, NULL, 0); break;
+		case 'k': keyfile = optarg; break;
+		case 'f': from = strtoull(optarg, NULL, 0); break;
+		case 't': to = strtoull(optarg, NULL, 0); break;
+		default: usage(argv[0]); return EXIT_FAILURE;
+		}
+	}
+
+	if (argc - optind != 2) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (workers < 1)
+		workers = 1;
+	if (workers > MAX_WORKERS)
+		workers = MAX_WORKERS;
+
+	sfx_keytable keys = { 0 };
+	if (keyfile && !sfx_keytable_load(&keys, keyfile)) {
+		fprintf(stderr, "Could not read key file %s\n", keyfile);
+		return EXIT_FAILURE;
+	}
+
+	/*
+	 * Map capture file
+	 */
+	int infd = open(argv[optind], O_RDONLY);
+	struct stat st;
+	if (infd < 0 || fstat(infd, &st) != 0) {
+		perror(argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	const sfx_capture_header *capture = st.st_size > 0 ? mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, infd, 0) : MAP_FAILED;
+	if (capture == MAP_FAILED || !sfx_capture_header_valid(capture, st.st_size)) {
+		fprintf(stderr, "%s: not a valid capture file\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+	madvise((void *)capture, st.st_size, MADV_SEQUENTIAL);
+
+	uint64_t first = from > 0 ? find_record(capture, from) : 0;
+	uint64_t last = to < UINT64_MAX ? find_record(capture, to) : capture->record_count;
+	uint64_t count = last > first ? last - first : 0;
+
+	/*
+	 * Create and map columnar output file
+	 */
+	sfx_decoded_header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, SFX_DECODED_MAGIC, sizeof(SFX_DECODED_MAGIC));
+	header.version = SFX_DECODED_VERSION;
+	header.columns = SFX_DECODED_COLUMNS;
+	header.count = count;
+
+	uint64_t outsize = sizeof(header);
+	for (int col = 0; col < SFX_DECODED_COLUMNS; ++col) {
+		outsize = (outsize + SFX_DECODED_ALIGN - 1) / SFX_DECODED_ALIGN * SFX_DECODED_ALIGN;
+		header.offsets[col] = outsize;
+		outsize += count * sfx_decoded_colsize[col];
+	}
+
+	int outfd = open(argv[optind + 1], O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (outfd < 0 || ftruncate(outfd, outsize) != 0) {
+		perror(argv[optind + 1]);
+		return EXIT_FAILURE;
+	}
+
+	uint8_t *output = mmap(NULL, outsize, PROT_READ | PROT_WRITE, MAP_SHARED, outfd, 0);
+	if (output == MAP_FAILED) {
+		perror(argv[optind + 1]);
+		return EXIT_FAILURE;
+	}
+	memcpy(output, &header, sizeof(header));
+
+	/*
+	 * Decode in parallel, output row is relative to first decoded record
+	 */
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	static worker w[MAX_WORKERS];
+	static pthread_t threads[MAX_WORKERS];
+	static bool started[MAX_WORKERS];
+	uint64_t chunk = (count + workers - 1) / workers;
+	for (long i = 0; i < workers; ++i) {
+		w[i].capture = capture;
+		w[i].keys = &keys;
+		w[i].outfirst = i * chunk < count ? i * chunk : count;
+		w[i].first = first + w[i].outfirst;
+		w[i].count = w[i].outfirst + chunk < count ? chunk : count - w[i].outfirst;
+		w[i].decoded_ok = 0;
+
+		for (int col = 0; col < SFX_DECODED_COLUMNS; ++col)
+			w[i].columns[col] = output + header.offsets[col];
+
+		started[i] = pthread_create(&threads[i], NULL, worker_run, &w[i]) == 0;
+	}
+
+	// ranges of workers whose thread could not be created are decoded on the main thread
+	uint64_t decoded_ok = 0;
+	for (long i = 0; i < workers; ++i) {
+		if (started[i])
+			pthread_join(threads[i], NULL);
+		else
+			worker_run(&w[i]);
+		decoded_ok += w[i].decoded_ok;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) * 1e-9;
+
+	fprintf(stderr, "decoded %" PRIu64 " records (%" PRIu64 " valid) in %.3f s with %ld workers, %.0f records/s\n",
+			count, decoded_ok, seconds, workers, seconds > 0 ? count / seconds : 0.0);
+
+	munmap(output, outsize);
+	close(outfd);
+	munmap((void *)capture, st.st_size);
+	close(infd);
+	sfx_keytable_free(&keys);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,279 @@
+/*
+ * renard-dlsched: offline simulation and benchmark of the downlink scheduler (see src/downlink_sched.h)
+ *
+ * Simulates a population of virtual devices on a virtual clock: at every tick, a number of uplinks with downlink
+ * request arrive, each opens a receive window a fixed number of ticks later. The network's processing delay is
+ * random, so every response is submitted with the remaining time until its deadline; a fraction of responses is
+ * delayed beyond its deadline (rejected as late). Stalls of the server, during which the clock advances without the
+ * scheduler running, make the scheduler skip ticks and miss deadlines. The time spent in the scheduler (submission,
+ * timing wheel and encoding) is measured on the host clock, the simulated time itself costs nothing.
+ *
+ * With option -v, every emitted frame is decoded and checked against the scheduled payload, and every response is
+ * checked to be emitted at most `lead` ticks ahead of its deadline (due) or after it (missed).
+ */
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include "downlink_sched.h"
+#include "downlink.h"
+
+typedef struct {
+	sfx_dl_sched sched;
+	uint32_t tick;
+	bool verify;
+	uint64_t verified;
+	uint64_t errors;
+} simulation;
+
+typedef struct {
+	sfx_commoninfo common;
+	uint8_t payload[SFX_DL_PAYLOADLEN];
+	uint32_t deadline;
+	uint32_t tag;
+} arrival;
+
+/*
+ * Traffic model parameters
+ */
+static uint32_t devices = 1000000;
+static uint32_t devid_base = 0x00100000;
+static uint64_t seed = 1;
+
+static uint16_t *seqnums;
+
+static uint64_t splitmix64(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+	return x ^ (x >> 31);
+}
+
+static uint64_t rng_next(uint64_t *state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545f4914f6cdd1d;
+}
+
+static bool rng_chance(uint64_t *state, double probability)
+{
+	return (rng_next(state) >> 11) * (1.0 / 9007199254740992.0) < probability;
+}
+
+static void device_key(uint32_t devid, uint8_t *key)
+{
+	uint64_t a = splitmix64(seed ^ ((uint64_t)devid << 1));
+	uint64_t b = splitmix64(a);
+	memcpy(key, &a, 8);
+	memcpy(key + 8, &b, 8);
+}
+
+/**
+ * @brief downlink payload of a device for an uplink sequence number, so that emitted frames can be verified
+ */
+static void response_payload(uint32_t devid, uint16_t seqnum, uint8_t *payload)
+{
+	uint64_t value = splitmix64(((uint64_t)devid << 16) ^ seqnum ^ (seed << 48));
+	memcpy(payload, &value, SFX_DL_PAYLOADLEN);
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static void emit(void *context, const sfx_dl_sched_response responses[], uint32_t count, uint8_t reason)
+{
+	simulation *sim = context;
+
+	if (!sim->verify)
+		return;
+
+	for (uint32_t i = 0; i < count; ++i) {
+		const sfx_dl_sched_entry *entry = responses[i].entry;
+		int32_t remaining = entry->deadline - sim->tick;
+
+		if (reason == SFX_DL_SCHED_EMIT_MISSED) {
+			sim->errors += remaining > 0;
+			continue;
+		}
+
+		if (remaining <= 0 || (uint32_t)remaining > sim->sched.lead)
+			sim->errors++;
+
+		sfx_dl_plain decoded;
+		uint8_t payload[SFX_DL_PAYLOADLEN];
+		sfx_downlink_decode(responses[i].frame, entry->common, &decoded);
+		response_payload(entry->common.devid, entry->common.seqnum, payload);
+		if (!decoded.crc_ok || !decoded.mac_ok || memcmp(decoded.payload, payload, SFX_DL_PAYLOADLEN) != 0)
+			sim->errors++;
+		sim->verified++;
+	}
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options]\n", name);
+	fprintf(stderr, "Traffic model (times in ticks of the virtual clock):\n");
+	fprintf(stderr, "  -n count    number of uplinks with downlink request (default: 10000000)\n");
+	fprintf(stderr, "  -d devices  number of virtual devices (default: 1000000)\n");
+	fprintf(stderr, "  -r rate     uplinks with downlink request per tick (default: 1000)\n");
+	fprintf(stderr, "  -w ticks    time from uplink to transmit deadline of the response (default: 2000)\n");
+	fprintf(stderr, "  -p ticks    maximum network processing delay, uniformly distributed (default: 500)\n");
+	fprintf(stderr, "  -L prob     probability of a response being delayed beyond its deadline (default: 0.001)\n");
+	fprintf(stderr, "  -S p:len    probability per tick of a server stall of len ticks (default: 0.0001:20)\n");
+	fprintf(stderr, "  -s seed     random seed, also determines NAKs (default: 1)\n");
+	fprintf(stderr, "Scheduler:\n");
+	fprintf(stderr, "  -l ticks    lead time, responses are encoded this many ticks before their deadline (default: 10)\n");
+	fprintf(stderr, "  -b count    maximum number of responses per batch (default: 256)\n");
+	fprintf(stderr, "  -c count    maximum number of pending responses (default: rate * (w + 1))\n");
+	fprintf(stderr, "  -v          decode and check every emitted frame\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t count = 10000000;
+	uint32_t rate = 1000;
+	uint32_t window = 2000;
+	uint32_t processing = 500;
+	double late_probability = 0.001;
+	double stall_probability = 0.0001;
+	uint32_t stall_length = 20;
+	uint32_t lead = 10;
+	uint32_t batch_size = 256;
+	uint32_t capacity = 0;
+	static simulation sim;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:d:r:w:p:L:S:s:l:b:c:vh")) != -1) {
+		switch (opt) {
+		case 'n': count = strtoull(optarg, NULL, 0); break;
+		case 'd': devices = strtoul(optarg, NULL, 0); break;
+		case 'r': rate = strtoul(optarg, NULL, 0); break;
+		case 'w': window = strtoul(optarg, NULL, 0); break;
+		case 'p': processing = strtoul(optarg, NULL, 0); break;
+		case 'L': late_probability = strtod(optarg, NULL); break;
+		case 'S':
+			if (sscanf(optarg, "%lf:%u", &stall_probability, &stall_length) != 2) {
+				fprintf(stderr, "Invalid stall specification: %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 's': seed = strtoull(optarg, NULL, 0); break;
+		case 'l': lead = strtoul(optarg, NULL, 0); break;
+		case 'b': batch_size = strtoul(optarg, NULL, 0); break;
+		case 'c': capacity = strtoul(optarg, NULL, 0); break;
+		case 'v': sim.verify = true; break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if (devices < 1)
+		devices = 1;
+	if (rate < 1)
+		rate = 1;
+	if (processing >= window)
+		processing = window - 1;
+	if (capacity == 0)
+		capacity = rate * (window + 1);
+
+	sfx_dl_sched_entry *entries = malloc(capacity * sizeof(sfx_dl_sched_entry));
+	sfx_dl_sched_response *batch = malloc(batch_size * sizeof(sfx_dl_sched_response));
+	arrival *arrivals = malloc(rate * sizeof(arrival));
+	seqnums = malloc(devices * sizeof(uint16_t));
+	if (!entries || !batch || !arrivals || !seqnums) {
+		perror("malloc");
+		return EXIT_FAILURE;
+	}
+
+	if (!sfx_downlink_sched_init(&sim.sched, entries, capacity, batch, batch_size, lead, 0, emit, &sim)) {
+		fprintf(stderr, "Invalid scheduler parameters\n");
+		return EXIT_FAILURE;
+	}
+
+	uint64_t state = splitmix64(seed) | 1;
+	for (uint32_t d = 0; d < devices; ++d)
+		seqnums[d] = rng_next(&state) & 0xfff;
+
+	/*
+	 * Virtual clock: every tick, `rate` responses are submitted, then the scheduler advances to the next tick.
+	 * During a stall, responses keep arriving (they are submitted late), but the scheduler does not run.
+	 */
+	uint64_t submit_ns = 0;
+	uint64_t advance_ns = 0;
+	uint64_t max_advance_ns = 0;
+	uint32_t stalled = 0;
+	uint64_t submitted = 0;
+
+	while (submitted < count || sim.sched.pending > 0) {
+		uint32_t arrived = 0;
+
+		for (; arrived < rate && submitted < count; ++arrived, ++submitted) {
+			arrival *a = &arrivals[arrived];
+			uint32_t d = rng_next(&state) % devices;
+			uint32_t delay = rng_next(&state) % (processing + 1);
+			if (rng_chance(&state, late_probability))
+				delay = window;
+
+			a->common.devid = devid_base + d;
+			a->common.seqnum = seqnums[d];
+			seqnums[d] = (seqnums[d] + 1) & 0xfff;
+			device_key(a->common.devid, a->common.key);
+			response_payload(a->common.devid, a->common.seqnum, a->payload);
+			a->deadline = sim.tick + window - delay;
+			a->tag = d;
+		}
+
+		uint64_t start = now_ns();
+		for (uint32_t i = 0; i < arrived; ++i)
+			sfx_downlink_sched_submit(&sim.sched, &arrivals[i].common, arrivals[i].payload, arrivals[i].deadline, arrivals[i].tag);
+		submit_ns += now_ns() - start;
+
+		sim.tick++;
+		if (stalled == 0 && rng_chance(&state, stall_probability))
+			stalled = stall_length;
+
+		if (stalled > 0) {
+			stalled--;
+			continue;
+		}
+
+		start = now_ns();
+		sfx_downlink_sched_advance(&sim.sched, sim.tick);
+		uint64_t elapsed = now_ns() - start;
+		advance_ns += elapsed;
+		if (elapsed > max_advance_ns)
+			max_advance_ns = elapsed;
+	}
+
+	const sfx_dl_sched_stats *stats = &sim.sched.stats;
+	printf("simulated %" PRIu32 " ticks, %" PRIu32 " devices, %" PRIu32 " pending responses max\n", sim.tick, devices, capacity);
+	printf("submitted %" PRIu64 ", encoded %" PRIu64 " in %" PRIu64 " batches, late %" PRIu64 ", missed %" PRIu64 ", dropped %" PRIu64 "\n",
+		stats->submitted, stats->encoded, stats->batches, stats->late, stats->missed, stats->dropped);
+	printf("scheduler time: submit %.1f ns/response, advance (incl. encoding) %.1f ns/response, longest tick %.3f ms\n",
+		(double)submit_ns / stats->submitted, (double)advance_ns / stats->submitted, max_advance_ns / 1e6);
+	printf("throughput %.0f responses/s\n", stats->submitted / ((submit_ns + advance_ns) / 1e9));
+
+	if (sim.verify)
+		printf("verified %" PRIu64 " frames, %" PRIu64 " errors\n", sim.verified, sim.errors);
+
+	bool consistent = stats->submitted == stats->late + stats->dropped + stats->encoded + stats->missed;
+	if (!consistent)
+		fprintf(stderr, "inconsistent counters\n");
+
+	return consistent && sim.errors == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,616 @@
+/*
+ * renard-generate: synthetic Sigfox traffic generator with channel error models, for load and yield testing
+ *
+ * Simulates a population of virtual devices (device ID, NAK derived from device ID and seed, sequence number state),
+ * encodes uplinks with replicas and downlinks for uplinks that request one, injects random bit errors, burst errors
+ * and frame type corruption and writes the frames to a capture file (see capture.h) with timestamps spaced according
+ * to the target frame rate. Every record is paired with its ground truth (see decode.h, ::sfx_truth_record) so that
+ * decode yield can be measured versus bit error rate, either offline or in-process (option -y).
+ *
+ * Generator threads own disjoint sets of devices and pass frames to the writer through a renard_mpmc_ring, so the
+ * record order depends on thread scheduling if more than one generator thread is used.
+ */
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sched.h>
+#include <time.h>
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include "uplink.h"
+#include "downlink.h"
+#include "ring.h"
+#include "capture.h"
+#include "decode.h"
+#include "keys.h"
+#include "net.h"
+
+#define MAX_WORKERS 64
+#define RING_CAPACITY 8192
+#define WORKER_BATCH 64
+
+// yield statistics are broken down by number of bit errors per frame: 0, 1, 2, 3-4, 5-8, 9-16, 17-32, > 32
+#define ERROR_BUCKETS 8
+
+typedef struct {
+	sfx_capture_record record;
+	sfx_truth_record truth;
+} generated;
+
+typedef struct {
+	uint64_t frames;
+	uint64_t decoded_ok;
+} yield_bucket;
+
+typedef struct {
+	pthread_t thread;
+	uint32_t index;
+	uint64_t rng;
+	uint64_t quota;
+	uint64_t bits;
+	uint64_t biterrors;
+	yield_bucket yield[ERROR_BUCKETS];
+	yield_bucket ftype_corrupted;
+	yield_bucket burst;
+} worker;
+
+/*
+ * Traffic and channel model parameters
+ */
+static uint32_t devices = 1000000;
+static uint32_t devid_base = 0x00100000;
+static uint64_t seed = 1;
+static uint32_t gateways = 1;
+static uint32_t mix[SFX_UL_MAX_PAYLOADLEN + 1];
+static uint32_t mix_total = 0;
+static double downlink_probability = 0.01;
+static bool replicas = true;
+static double ber = 0;
+static double burst_probability = 0;
+static uint32_t burst_length = 0;
+static double ftype_probability = 0;
+static bool measure_yield = false;
+
+static long nworkers = 1;
+static worker workers[MAX_WORKERS];
+static uint16_t *seqnums;
+static sfx_keytable keys;
+static renard_mpmc_ring ring;
+static int active_workers;
+
+/**
+ * @brief SplitMix64, used for deriving per-device NAKs and per-thread random number generator seeds
+ */
+static uint64_t splitmix64(uint64_t x)
+{
+	x += 0x9e3779b97f4a7c15;
+	x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+	x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+	return x ^ (x >> 31);
+}
+
+/**
+ * @brief xorshift64* random number generator
+ */
+static uint64_t rng_next(uint64_t *state)
+{
+	*state ^= *state >> 12;
+	*state ^= *state << 25;
+	*state ^= *state >> 27;
+	return *state * 0x2545f4914f6cdd1d;
+}
+
+/**
+ * @brief random event with given probability
+ */
+static bool rng_chance(uint64_t *state, double probability)
+{
+	return (rng_next(state) >> 11) * (1.0 / 9007199254740992.0) < probability;
+}
+
+static void device_key(uint32_t devid, uint8_t *key)
+{
+	uint64_t a = splitmix64(seed ^ ((uint64_t)devid << 1));
+	uint64_t b = splitmix64(a);
+	memcpy(key, &a, 8);
+	memcpy(key + 8, &b, 8);
+}
+
+static uint8_t error_bucket(uint16_t biterrors)
+{
+	uint8_t bucket = 0;
+
+	if (biterrors < 3)
+		return biterrors;
+
+	for (bucket = 3, biterrors = (biterrors - 1) >> 2; biterrors > 0 && bucket < ERROR_BUCKETS - 1; biterrors >>= 1)
+		bucket++;
+
+	return bucket;
+}
+
+/**
+ * @brief inject channel errors into frame according to channel model
+ * @param w generator thread, for random numbers and statistics
+ * @param frame frame to corrupt
+ * @param bits length of frame in bits
+ * @param truth output, ground truth, error counters are updated
+ * @param ftype_bits number of leading frame type bits that can be corrupted, 0 for downlinks
+ */
+static void inject_errors(worker *w, uint8_t *frame, uint16_t bits, sfx_truth_record *truth, uint8_t ftype_bits)
+{
+	uint8_t original[SFX_CAPTURE_MAX_FRAMELEN];
+	memcpy(original, frame, (bits + 7) / 8);
+
+	if (ber > 0)
+		for (uint16_t i = 0; i < bits; ++i)
+			if (rng_chance(&w->rng, ber))
+				frame[i / 8] ^= 0x80 >> (i % 8);
+
+	// burst: every bit inside burst is replaced by a random bit
+	if (burst_length > 0 && rng_chance(&w->rng, burst_probability)) {
+		uint16_t length = burst_length < bits ? burst_length : bits;
+		uint16_t start = rng_next(&w->rng) % (bits - length + 1);
+		for (uint16_t i = start; i < start + length; ++i)
+			if (rng_next(&w->rng) & 0x100)
+				frame[i / 8] ^= 0x80 >> (i % 8);
+		truth->burst = 1;
+	}
+
+	if (ftype_bits > 0 && rng_chance(&w->rng, ftype_probability)) {
+		uint8_t i = rng_next(&w->rng) % ftype_bits;
+		frame[i / 8] ^= 0x80 >> (i % 8);
+	}
+
+	for (uint16_t i = 0; i < (bits + 7) / 8; ++i)
+		truth->biterrors += __builtin_popcount(frame[i] ^ original[i]);
+
+	for (uint8_t i = 0; i < ftype_bits; ++i)
+		if ((frame[i / 8] ^ original[i / 8]) & (0x80 >> (i % 8)))
+			truth->ftype_corrupted = 1;
+
+	w->bits += bits;
+	w->biterrors += truth->biterrors;
+}
+
+static void yield_count(worker *w, generated *g)
+{
+	sfx_decoded_record decoded;
+	bool ok = sfx_decode_record(&g->record, &keys, &decoded) && sfx_decoded_matches(&decoded, &g->truth.expected);
+
+	yield_bucket *buckets[3] = { &w->yield[error_bucket(g->truth.biterrors)],
+			g->truth.ftype_corrupted ? &w->ftype_corrupted : NULL, g->truth.burst ? &w->burst : NULL };
+
+	for (int i = 0; i < 3; ++i) {
+		if (!buckets[i])
+			continue;
+		buckets[i]->frames++;
+		buckets[i]->decoded_ok += ok;
+	}
+}
+
+/**
+ * @brief push generated records to writer, wait while ring is full
+ */
+static void flush(generated *batch, uint32_t count)
+{
+	uint32_t pushed = 0;
+
+	while (pushed < count) {
+		pushed += renard_mpmc_push(&ring, batch + pushed, count - pushed);
+		if (pushed < count)
+			sched_yield();
+	}
+}
+
+static void *worker_run(void *arg)
+{
+	worker *w = arg;
+	generated batch[WORKER_BATCH];
+	uint32_t count = 0;
+	uint64_t produced = 0;
+
+	// devices d with d % nworkers == index belong to this thread
+	uint32_t owned = devices / nworkers + (w->index < devices % nworkers ? 1 : 0);
+
+	while (produced < w->quota && owned > 0) {
+		sfx_commoninfo common;
+		uint32_t device = (rng_next(&w->rng) % owned) * nworkers + w->index;
+		common.devid = devid_base + device;
+		common.seqnum = seqnums[device];
+		seqnums[device] = (seqnums[device] + 1) & 0xfff;
+		device_key(common.devid, common.key);
+
+		/*
+		 * Uplink with payload length according to mix, length 0 is a single-bit uplink
+		 */
+		sfx_ul_plain uplink;
+		memset(&uplink, 0, sizeof(uplink));
+
+		uint32_t pick = rng_next(&w->rng) % mix_total;
+		while (pick >= mix[uplink.payloadlen])
+			pick -= mix[uplink.payloadlen++];
+
+		uplink.singlebit = uplink.payloadlen == 0;
+		uplink.request_downlink = rng_chance(&w->rng, downlink_probability);
+		uplink.replicas = replicas;
+
+		uint64_t random = rng_next(&w->rng);
+		for (uint8_t i = 0; i < uplink.payloadlen; ++i)
+			uplink.payload[i] = random >> (8 * (i % 8)) ^ i;
+		if (uplink.singlebit)
+			uplink.payload[0] = random & 0x01;
+
+		sfx_ul_encoded encoded;
+		sfx_uplink_encode(uplink, common, &encoded);
+
+		generated g;
+		memset(&g, 0, sizeof(g));
+		g.record.type = SFX_CAPTURE_UPLINK;
+		g.record.gateway = rng_next(&w->rng) % gateways;
+		g.record.framelen_nibbles = encoded.framelen_nibbles;
+		g.truth.expected.gateway = g.record.gateway;
+		g.truth.expected.devid = common.devid;
+		g.truth.expected.seqnum = common.seqnum;
+		g.truth.expected.flags = SFX_DECODED_FLAG_CRC_OK | SFX_DECODED_FLAG_MAC_CHECKED | SFX_DECODED_FLAG_MAC_OK;
+		g.truth.expected.flags |= uplink.singlebit ? SFX_DECODED_FLAG_SINGLEBIT : 0;
+		g.truth.expected.flags |= uplink.request_downlink ? SFX_DECODED_FLAG_REQUEST_DOWNLINK : 0;
+		g.truth.expected.payloadlen = uplink.singlebit ? 1 : uplink.payloadlen;
+		memcpy(g.truth.expected.payload, uplink.payload, g.truth.expected.payloadlen);
+
+		for (uint8_t replica = 0; replica < (replicas ? 3 : 1) && produced < w->quota; ++replica) {
+			generated r = g;
+			memcpy(r.record.frame, encoded.frame[replica], SFX_UL_MAX_FRAMELEN);
+			inject_errors(w, r.record.frame, encoded.framelen_nibbles * 4, &r.truth, SFX_UL_FTYPELEN_NIBBLES * 4);
+
+			if (measure_yield)
+				yield_count(w, &r);
+
+			batch[count++] = r;
+			produced++;
+			if (count == WORKER_BATCH) {
+				flush(batch, count);
+				count = 0;
+			}
+		}
+
+		/*
+		 * Downlink response
+		 */
+		if (!uplink.request_downlink || produced >= w->quota)
+			continue;
+
+		sfx_dl_plain downlink;
+		memset(&downlink, 0, sizeof(downlink));
+		random = rng_next(&w->rng);
+		memcpy(downlink.payload, &random, SFX_DL_PAYLOADLEN);
+
+		sfx_dl_encoded dlencoded;
+		sfx_downlink_encode(downlink, common, &dlencoded);
+
+		memset(&g, 0, sizeof(g));
+		g.record.type = SFX_CAPTURE_DOWNLINK;
+		g.record.gateway = rng_next(&w->rng) % gateways;
+		g.record.devid = common.devid;
+		g.record.seqnum = common.seqnum;
+		g.record.framelen_nibbles = SFX_DL_FRAMELEN * 2;
+		memcpy(g.record.frame, dlencoded.frame, SFX_DL_FRAMELEN);
+		g.truth.expected.gateway = g.record.gateway;
+		g.truth.expected.devid = common.devid;
+		g.truth.expected.seqnum = common.seqnum;
+		g.truth.expected.flags = SFX_DECODED_FLAG_DOWNLINK | SFX_DECODED_FLAG_CRC_OK | SFX_DECODED_FLAG_MAC_CHECKED | SFX_DECODED_FLAG_MAC_OK;
+		g.truth.expected.payloadlen = SFX_DL_PAYLOADLEN;
+		memcpy(g.truth.expected.payload, downlink.payload, SFX_DL_PAYLOADLEN);
+		inject_errors(w, g.record.frame, SFX_DL_FRAMELEN * 8, &g.truth, 0);
+
+		if (measure_yield)
+			yield_count(w, &g);
+
+		batch[count++] = g;
+		produced++;
+		if (count == WORKER_BATCH) {
+			flush(batch, count);
+			count = 0;
+		}
+	}
+
+	flush(batch, count);
+	__atomic_fetch_sub(&active_workers, 1, __ATOMIC_RELEASE);
+
+	return NULL;
+}
+
+/**
+ * @brief parse payload length mix, comma-separated list of <payload length>:<weight> pairs
+ */
+static bool parse_mix(const char *spec)
+{
+	memset(mix, 0, sizeof(mix));
+	mix_total = 0;
+
+	while (*spec) {
+		char *end;
+		unsigned long length = strtoul(spec, &end, 0);
+		if (*end != ':' || length > SFX_UL_MAX_PAYLOADLEN)
+			return false;
+
+		unsigned long weight = strtoul(end + 1, &end, 0);
+		mix[length] += weight;
+		mix_total += weight;
+
+		if (*end != ',' && *end != '\0')
+			return false;
+		spec = *end ? end + 1 : end;
+	}
+
+	return mix_total > 0;
+}
+
+static bool write_keyfile(const char *filename)
+{
+	FILE *f = fopen(filename, "w");
+	if (!f)
+		return false;
+
+	for (size_t d = 0; d < keys.count; ++d) {
+		fprintf(f, "%08x ", keys.entries[d].devid);
+		for (int i = 0; i < 16; ++i)
+			fprintf(f, "%02x", keys.entries[d].key[i]);
+		fprintf(f, "\n");
+	}
+
+	return fclose(f) == 0;
+}
+
+static void print_yield(const char *label, const yield_bucket *bucket)
+{
+	if (bucket->frames > 0)
+		fprintf(stderr, "  %-16s %12" PRIu64 " frames, yield %7.3f %%\n", label, bucket->frames, 100.0 * bucket->decoded_ok / bucket->frames);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options]\n", name);
+	fprintf(stderr, "Traffic model:\n");
+	fprintf(stderr, "  -n records  number of capture records (uplink replicas and downlinks) to generate (default: 1000000)\n");
+	fprintf(stderr, "  -d devices  number of virtual devices (default: 1000000)\n");
+	fprintf(stderr, "  -D devid    device ID of first virtual device (default: 0x00100000)\n");
+	fprintf(stderr, "  -m mix      uplink payload length mix, <length>:<weight>,... length 0 = single-bit (default: uniform 0..12)\n");
+	fprintf(stderr, "  -q prob     probability of an uplink requesting a downlink (default: 0.01)\n");
+	fprintf(stderr, "  -1          no replicas, only initial transmission of every uplink\n");
+	fprintf(stderr, "  -g count    number of gateways, every frame is assigned to a random gateway (default: 1)\n");
+	fprintf(stderr, "  -r rate     frames per second, determines timestamp spacing (default: 10000)\n");
+	fprintf(stderr, "  -T start    timestamp of first record in microseconds since the Unix epoch (default: now)\n");
+	fprintf(stderr, "  -s seed     random seed, also determines NAKs (default: 1)\n");
+	fprintf(stderr, "Channel model:\n");
+	fprintf(stderr, "  -e ber      bit error rate of independent bit errors (default: 0)\n");
+	fprintf(stderr, "  -b p:len    probability per frame of a burst error of len random bits\n");
+	fprintf(stderr, "  -f prob     probability per uplink frame of a bit error inside the frame type field\n");
+	fprintf(stderr, "Output:\n");
+	fprintf(stderr, "  -o file     capture file (see tools/capture.h)\n");
+	fprintf(stderr, "  -t file     ground truth file, one sfx_truth_record per capture record (see tools/decode.h)\n");
+	fprintf(stderr, "  -k file     key file of all virtual devices, for renard-batchdecode / renard-ingest\n");
+	fprintf(stderr, "  -y          decode every frame in-process and report yield versus number of bit errors\n");
+	fprintf(stderr, "  -j workers  number of generator threads (default: number of CPUs)\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint64_t records = 1000000;
+	double rate = 10000;
+	uint64_t start = sfx_now_us();
+	const char *capturefile = NULL;
+	const char *truthfile = NULL;
+	const char *keyfile = NULL;
+	int opt;
+
+	nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+	for (uint8_t i = 0; i <= SFX_UL_MAX_PAYLOADLEN; ++i)
+		mix[i] = 1;
+	mix_total = SFX_UL_MAX_PAYLOADLEN + 1;
+
+	while ((opt = getopt(argc, argv, "n:d:D:m:q:1g:r:T:s:e:b:f:o:t:k:yj:h")) != -1) {
+		switch (opt) {
+		case 'n': records = strtoull(optarg, NULL, 0); break;
+		case 'd': devices = strtoul(optarg, NULL, 0); break;
+		case 'D': devid_base = strtoul(optarg, NULL, 0); break;
+		case 'm':
+			if (!parse_mix(optarg)) {
+				fprintf(stderr, "Invalid payload length mix: %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'q': downlink_probability = strtod(optarg, NULL); break;
+		case '1': replicas = false; break;
+		case 'g': gateways = strtoul(optarg, NULL, 0); break;
+		case 'r': rate = strtod(optarg, NULL); break;
+		case 'T': start = strtoull(optarg, NULL, 0); break;
+		case 's': seed = strtoull(optarg, NULL, 0); break;
+		case 'e': ber = strtod(optarg, NULL); break;
+		case 'b':
+			if (sscanf(optarg, "%lf:%u", &burst_probability, &burst_length) != 2) {
+				fprintf(stderr, "Invalid burst error specification: %s\n", optarg);
+				return EXIT_FAILURE;
+			}
+			break;
+		case 'f': ftype_probability = strtod(optarg, NULL); break;
+		case 'o': capturefile = optarg; break;
+		case 't': truthfile = optarg; break;
+		case 'k': keyfile = optarg; break;
+		case 'y': measure_yield = true; break;
+		case 'j': nworkers = strtol(optarg, NULL, 0); break;
+		default: usage(argv[0]); return EXIT_FAILURE;
+		}
+	}
+
+	if (!capturefile && !truthfile && !keyfile && !measure_yield) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (nworkers < 1)
+		nworkers = 1;
+	if (nworkers > MAX_WORKERS)
+		nworkers = MAX_WORKERS;
+	if (devices < 1)
+		devices = 1;
+	if (gateways < 1)
+		gateways = 1;
+	if (rate <= 0)
+		rate = 10000;
+
+	/*
+	 * Key table of all virtual devices, used for key file and in-process yield measurement
+	 */
+	keys.entries = malloc(devices * sizeof(sfx_keyentry));
+	keys.count = devices;
+	for (uint32_t d = 0; d < devices; ++d) {
+		keys.entries[d].devid = devid_base + d;
+		device_key(devid_base + d, keys.entries[d].key);
+	}
+	qsort(keys.entries, keys.count, sizeof(sfx_keyentry), sfx_keyentry_compare);
+
+	if (keyfile && !write_keyfile(keyfile)) {
+		perror(keyfile);
+		return EXIT_FAILURE;
+	}
+
+	FILE *capture = capturefile ? fopen(capturefile, "wb") : NULL;
+	FILE *truth = truthfile ? fopen(truthfile, "wb") : NULL;
+	if ((capturefile && !capture) || (truthfile && !truth)) {
+		perror("output");
+		return EXIT_FAILURE;
+	}
+
+	/*
+	 * Device state, random initial sequence numbers
+	 */
+	seqnums = malloc(devices * sizeof(uint16_t));
+	uint64_t state = splitmix64(seed);
+	for (uint32_t d = 0; d < devices; ++d)
+		seqnums[d] = rng_next(&state) & 0xfff;
+
+	static uint8_t ringbuffer[RENARD_MPMC_BUFSIZE(RING_CAPACITY, sizeof(generated))] __attribute__((aligned(RENARD_CACHELINE)));
+	renard_mpmc_init(&ring, ringbuffer, RING_CAPACITY, sizeof(generated));
+
+	sfx_capture_header header;
+	sfx_capture_header_init(&header, 0);
+	header.record_count = records;
+	sfx_capture_index_entry *index = calloc(records / header.index_interval + 1, sizeof(sfx_capture_index_entry));
+
+	if (capture)
+		fwrite(&header, sizeof(header), 1, capture);
+
+	struct timespec begin, end;
+	clock_gettime(CLOCK_MONOTONIC, &begin);
+
+	active_workers = nworkers;
+	for (long i = 0; i < nworkers; ++i) {
+		workers[i].index = i;
+		workers[i].rng = splitmix64(seed + 1 + i) | 1;
+		workers[i].quota = records / nworkers + (i < (long)(records % nworkers) ? 1 : 0);
+		pthread_create(&workers[i].thread, NULL, worker_run, &workers[i]);
+	}
+
+	/*
+	 * Writer: assign timestamps in order of arrival, build index
+	 */
+	static generated items[1024];
+	uint64_t written = 0;
+
+	while (written < records) {
+		bool finished = __atomic_load_n(&active_workers, __ATOMIC_ACQUIRE) == 0;
+		uint32_t count = renard_mpmc_pop(&ring, items, 1024);
+
+		if (count == 0) {
+			if (finished)
+				break;
+			sched_yield();
+			continue;
+		}
+
+		for (uint32_t i = 0; i < count; ++i, ++written) {
+			uint64_t timestamp = start + (uint64_t)(written * 1e6 / rate);
+			items[i].record.timestamp = timestamp;
+			items[i].truth.expected.timestamp = timestamp;
+
+			if (written % header.index_interval == 0) {
+				index[written / header.index_interval].timestamp = timestamp;
+				index[written / header.index_interval].record = written;
+			}
+
+			if (capture)
+				fwrite(&items[i].record, sizeof(sfx_capture_record), 1, capture);
+			if (truth)
+				fwrite(&items[i].truth, sizeof(sfx_truth_record), 1, truth);
+		}
+	}
+
+	for (long i = 0; i < nworkers; ++i)
+		pthread_join(workers[i].thread, NULL);
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (capture) {
+		header.record_count = written;
+		header.index_offset = sizeof(header) + written * sizeof(sfx_capture_record);
+		fwrite(index, sizeof(sfx_capture_index_entry), sfx_capture_index_count(&header), capture);
+		fseek(capture, 0, SEEK_SET);
+		fwrite(&header, sizeof(header), 1, capture);
+		if (fclose(capture) != 0)
+			perror(capturefile);
+	}
+
+	if (truth && fclose(truth) != 0)
+		perror(truthfile);
+
+	/*
+	 * Report
+	 */
+	uint64_t bits = 0, biterrors = 0;
+	yield_bucket yield[ERROR_BUCKETS], ftype_corrupted = { 0, 0 }, burst = { 0, 0 }, total = { 0, 0 };
+	memset(yield, 0, sizeof(yield));
+
+	for (long i = 0; i < nworkers; ++i) {
+		bits += workers[i].bits;
+		biterrors += workers[i].biterrors;
+		for (int b = 0; b < ERROR_BUCKETS; ++b) {
+			yield[b].frames += workers[i].yield[b].frames;
+			yield[b].decoded_ok += workers[i].yield[b].decoded_ok;
+			total.frames += workers[i].yield[b].frames;
+			total.decoded_ok += workers[i].yield[b].decoded_ok;
+		}
+		ftype_corrupted.frames += workers[i].ftype_corrupted.frames;
+		ftype_corrupted.decoded_ok += workers[i].ftype_corrupted.decoded_ok;
+		burst.frames += workers[i].burst.frames;
+		burst.decoded_ok += workers[i].burst.decoded_ok;
+	}
+
+	double seconds = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) * 1e-9;
+	fprintf(stderr, "generated %" PRIu64 " records in %.3f s (%.0f records/s), %ld threads, measured BER %.3g\n",
+			written, seconds, written / seconds, nworkers, bits > 0 ? (double)biterrors / bits : 0.0);
+
+	if (measure_yield) {
+		static const char *labels[ERROR_BUCKETS] = { "0 bit errors", "1 bit error", "2 bit errors", "3-4 bit errors",
+				"5-8 bit errors", "9-16 bit errors", "17-32 bit errors", "> 32 bit errors" };
+
+		fprintf(stderr, "decode yield:\n");
+		for (int b = 0; b < ERROR_BUCKETS; ++b)
+			print_yield(labels[b], &yield[b]);
+		print_yield("frame type error", &ftype_corrupted);
+		print_yield("burst error", &burst);
+		print_yield("total", &total);
+	}
+
+	free(index);
+	free(seqnums);
+	sfx_keytable_free(&keys);
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,359 @@
+/*
+ * renard-ingest: reference ingest daemon, decodes raw frames received from gateways over UDP or a
+ * Unix domain datagram socket
+ *
+ * Every datagram carries one capture record (see capture.h). Worker threads share the receiving socket,
+ * receive batches of datagrams with recvmmsg, decode the whole batch and emit the decoded records
+ * (see decode.h) in one write to an output file or one sendmmsg to a Unix domain datagram socket.
+ * Throughput and latency (capture record timestamp to end of decoding) are reported periodically.
+ */
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "capture.h"
+#include "decode.h"
+#include "keys.h"
+#include "net.h"
+
+#define MAX_WORKERS 64
+
+// latency histogram with 1 us resolution, last bucket collects everything above
+#define LATENCY_BUCKETS 65536
+
+typedef struct {
+	pthread_t thread;
+	uint64_t received;
+	uint64_t decoded_ok;
+	uint64_t malformed;
+	uint64_t latency[LATENCY_BUCKETS];
+} worker;
+
+static volatile sig_atomic_t stop = 0;
+
+static int infd = -1;
+static int outfd = -1;
+static bool output_is_socket = false;
+static uint32_t batch = 64;
+static sfx_keytable keys;
+static worker workers[MAX_WORKERS];
+
+static void on_signal(int signum)
+{
+	(void)signum;
+	stop = 1;
+}
+
+static void *worker_run(void *arg)
+{
+	worker *w = arg;
+
+	static __thread sfx_capture_record records[SFX_NET_MAX_BATCH];
+	static __thread sfx_decoded_record decoded[SFX_NET_MAX_BATCH];
+	struct mmsghdr msgs[SFX_NET_MAX_BATCH];
+	struct iovec iovecs[SFX_NET_MAX_BATCH];
+
+	memset(msgs, 0, sizeof(msgs));
+	for (uint32_t i = 0; i < batch; ++i) {
+		iovecs[i].iov_base = &records[i];
+		iovecs[i].iov_len = sizeof(records[i]);
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	while (!stop) {
+		int n = recvmmsg(infd, msgs, batch, MSG_WAITFORONE, NULL);
+		if (n <= 0)
+			continue;
+
+		/*
+		 * Decode whole batch, skip datagrams that don't contain exactly one record
+		 */
+		uint32_t count = 0;
+		for (int i = 0; i < n; ++i) {
+			if (msgs[i].msg_len != sizeof(sfx_capture_record)) {
+				__atomic_fetch_add(&w->malformed, 1, __ATOMIC_RELAXED);
+				continue;
+			}
+
+			if (sfx_decode_record(&records[i], &keys, &decoded[count]))
+				__atomic_fetch_add(&w->decoded_ok, 1, __ATOMIC_RELAXED);
+			count++;
+		}
+
+		uint64_t now = sfx_now_us();
+		for (uint32_t i = 0; i < count; ++i) {
+			uint64_t latency = now > decoded[i].timestamp ? now - decoded[i].timestamp : 0;
+			__atomic_fetch_add(&w->latency[latency < LATENCY_BUCKETS ? latency : LATENCY_BUCKETS - 1], 1, __ATOMIC_RELAXED);
+		}
+		__atomic_fetch_add(&w->received, count, __ATOMIC_RELAXED);
+
+		/*
+		 * Emit decoded batch
+		 */
+		if (outfd < 0 || count == 0)
+			continue;
+
+		if (output_is_socket) {
+			struct mmsghdr outmsgs[SFX_NET_MAX_BATCH];
+			struct iovec outvecs[SFX_NET_MAX_BATCH];
+
+			memset(outmsgs, 0, count * sizeof(outmsgs[0]));
+			for (uint32_t i = 0; i < count; ++i) {
+				outvecs[i].iov_base = &decoded[i];
+				outvecs[i].iov_len = sizeof(decoded[i]);
+				outmsgs[i].msg_hdr.msg_iov = &outvecs[i];
+				outmsgs[i].msg_hdr.msg_iovlen = 1;
+			}
+
+			for (uint32_t sent = 0; sent < count && !stop;) {
+				int r = sendmmsg(outfd, outmsgs + sent, count - sent, 0);
+				if (r < 0 && errno != EINTR)
+					break;
+				sent += r > 0 ? r : 0;
+			}
+		} else {
+			// O_APPEND: every batch is appended in one piece
+			if (write(outfd, decoded, count * sizeof(decoded[0])) < 0)
+				perror("write");
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief merge statistics of all workers
+ */
+static void collect(long nworkers, uint64_t *received, uint64_t *decoded_ok, uint64_t *malformed, uint64_t *latency)
+{
+	*received = *decoded_ok = *malformed = 0;
+	memset(latency, 0, LATENCY_BUCKETS * sizeof(uint64_t));
+
+	for (long i = 0; i < nworkers; ++i) {
+		*received += __atomic_load_n(&workers[i].received, __ATOMIC_RELAXED);
+		*decoded_ok += __atomic_load_n(&workers[i].decoded_ok, __ATOMIC_RELAXED);
+		*malformed += __atomic_load_n(&workers[i].malformed, __ATOMIC_RELAXED);
+		for (uint32_t b = 0; b < LATENCY_BUCKETS; ++b)
+			latency[b] += __atomic_load_n(&workers[i].latency[b], __ATOMIC_RELAXED);
+	}
+}
+
+/**
+ * @brief latency percentile in microseconds from (difference of) histograms
+ */
+static uint32_t percentile(const uint64_t *latency, const uint64_t *previous, uint64_t total, double p)
+{
+	uint64_t target = (uint64_t)(total * p + 0.999999);
+	uint64_t sum = 0;
+
+	if (target < 1)
+		target = 1;
+
+	for (uint32_t b = 0; b < LATENCY_BUCKETS; ++b) {
+		sum += latency[b] - (previous ? previous[b] : 0);
+		if (sum >= target)
+			return b;
+	}
+
+	return LATENCY_BUCKETS - 1;
+}
+
+static void report(const char *label, double seconds, uint64_t frames, uint64_t ok, uint64_t malformed, const uint64_t *latency, const uint64_t *previous)
+{
+	if (frames == 0) {
+		fprintf(stderr, "%s: 0 frames/s\n", label);
+		return;
+	}
+
+	fprintf(stderr, "%s: %.0f frames/s, %" PRIu64 " frames (%" PRIu64 " valid, %" PRIu64 " malformed), "
+			"latency p50 %u us, p99 %u us, p99.9 %u us, max %s%u us\n",
+			label, frames / seconds, frames, ok, malformed,
+			percentile(latency, previous, frames, 0.5), percentile(latency, previous, frames, 0.99),
+			percentile(latency, previous, frames, 0.999),
+			percentile(latency, previous, frames, 1.0) == LATENCY_BUCKETS - 1 ? ">" : "",
+			percentile(latency, previous, frames, 1.0));
+}
+
+static double elapsed(struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options]\n", name);
+	fprintf(stderr, "  -a addr     UDP address to listen on (default: 127.0.0.1)\n");
+	fprintf(stderr, "  -p port     UDP port to listen on (default: %d)\n", SFX_INGEST_DEFAULT_PORT);
+	fprintf(stderr, "  -u path     listen on Unix domain datagram socket instead of UDP\n");
+	fprintf(stderr, "  -j workers  number of decoder threads (default: number of CPUs)\n");
+	fprintf(stderr, "  -b batch    maximum number of datagrams per recvmmsg call (default: 64, max: %d)\n", SFX_NET_MAX_BATCH);
+	fprintf(stderr, "  -k keyfile  text file with one \"<devid hex> <NAK hex>\" pair per line, enables MAC checking\n");
+	fprintf(stderr, "  -o file     append decoded records (see tools/decode.h) to file\n");
+	fprintf(stderr, "  -O path     send decoded records as datagrams to Unix domain socket\n");
+	fprintf(stderr, "  -n frames   exit after this many frames\n");
+	fprintf(stderr, "  -i seconds  statistics interval (default: 1)\n");
+}
+
+int main(int argc, char **argv)
+{
+	const char *address = "127.0.0.1";
+	uint16_t port = SFX_INGEST_DEFAULT_PORT;
+	const char *unixpath = NULL;
+	const char *keyfile = NULL;
+	const char *outfile = NULL;
+	const char *outsocket = NULL;
+	long nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+	uint64_t maxframes = 0;
+	double interval = 1.0;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:p:u:j:b:k:o:O:n:i:h")) != -1) {
+		switch (opt) {
+		case 'a': address = optarg; break;
+		case 'p': port = strtoul(optarg, NULL, 0); break;
+		case 'u': unixpath = optarg; break;
+		case 'j': nworkers = strtol(optarg, NULL, 0); break;
+		case 'b': batch = strtoul(optarg, NULL, 0); break;
+		case 'k': keyfile = optarg; break;
+		case 'o': outfile = optarg; break;
+		case 'O': outsocket = optarg; break;
+		case 'n': maxframes = strtoull(optarg, NULL, 0); break;
+		case 'i': interval = strtod(optarg, NULL); break;
+		default: usage(argv[0]); return EXIT_FAILURE;
+		}
+	}
+
+	if (nworkers < 1)
+		nworkers = 1;
+	if (nworkers > MAX_WORKERS)
+		nworkers = MAX_WORKERS;
+	if (batch < 1)
+		batch = 1;
+	if (batch > SFX_NET_MAX_BATCH)
+		batch = SFX_NET_MAX_BATCH;
+	if (interval <= 0)
+		interval = 1.0;
+
+	if (keyfile && !sfx_keytable_load(&keys, keyfile)) {
+		fprintf(stderr, "Could not read key file %s\n", keyfile);
+		return EXIT_FAILURE;
+	}
+
+	/*
+	 * Input socket, receive timeout lets workers notice shutdown
+	 */
+	struct sockaddr_storage addr;
+	socklen_t addrlen = sfx_net_address(&addr, unixpath, address, port);
+	if (addrlen == 0) {
+		fprintf(stderr, "Invalid listen address\n");
+		return EXIT_FAILURE;
+	}
+
+	if (unixpath)
+		unlink(unixpath);
+
+	infd = socket(addr.ss_family, SOCK_DGRAM, 0);
+	int rcvbuf = 8 * 1024 * 1024;
+	struct timeval timeout = { .tv_sec = 0, .tv_usec = 100000 };
+	setsockopt(infd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+	setsockopt(infd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	if (infd < 0 || bind(infd, (struct sockaddr *)&addr, addrlen) != 0) {
+		perror("bind");
+		return EXIT_FAILURE;
+	}
+
+	/*
+	 * Output: file or Unix domain datagram socket
+	 */
+	if (outfile) {
+		outfd = open(outfile, O_WRONLY | O_CREAT | O_APPEND, 0644);
+	} else if (outsocket) {
+		struct sockaddr_storage outaddr;
+		socklen_t outaddrlen = sfx_net_address(&outaddr, outsocket, NULL, 0);
+		outfd = socket(AF_UNIX, SOCK_DGRAM, 0);
+		output_is_socket = true;
+		if (outaddrlen == 0 || connect(outfd, (struct sockaddr *)&outaddr, outaddrlen) != 0) {
+			perror("connect");
+			return EXIT_FAILURE;
+		}
+	}
+
+	if ((outfile || outsocket) && outfd < 0) {
+		perror("output");
+		return EXIT_FAILURE;
+	}
+
+	signal(SIGINT, on_signal);
+	signal(SIGTERM, on_signal);
+
+	for (long i = 0; i < nworkers; ++i)
+		pthread_create(&workers[i].thread, NULL, worker_run, &workers[i]);
+
+	if (unixpath)
+		fprintf(stderr, "listening on %s, %ld workers, batch size %u\n", unixpath, nworkers, batch);
+	else
+		fprintf(stderr, "listening on %s:%u, %ld workers, batch size %u\n", address, port, nworkers, batch);
+
+	/*
+	 * Periodic statistics, measured from first received frame
+	 */
+	static uint64_t latency[LATENCY_BUCKETS];
+	static uint64_t previous_latency[LATENCY_BUCKETS];
+	uint64_t received = 0, decoded_ok = 0, malformed = 0;
+	uint64_t previous_received = 0, previous_ok = 0, previous_malformed = 0;
+	struct timespec start, last;
+	bool started = false;
+
+	while (!stop) {
+		usleep(started ? (useconds_t)(interval * 1e6) : 10000);
+		collect(nworkers, &received, &decoded_ok, &malformed, latency);
+
+		if (!started) {
+			if (received == 0 && malformed == 0)
+				continue;
+			started = true;
+			clock_gettime(CLOCK_MONOTONIC, &start);
+			last = start;
+			continue;
+		}
+
+		report("interval", elapsed(&last), received - previous_received, decoded_ok - previous_ok,
+				malformed - previous_malformed, latency, previous_latency);
+		clock_gettime(CLOCK_MONOTONIC, &last);
+		memcpy(previous_latency, latency, sizeof(latency));
+		previous_received = received;
+		previous_ok = decoded_ok;
+		previous_malformed = malformed;
+
+		if (maxframes > 0 && received >= maxframes)
+			stop = 1;
+	}
+
+	for (long i = 0; i < nworkers; ++i)
+		pthread_join(workers[i].thread, NULL);
+
+	collect(nworkers, &received, &decoded_ok, &malformed, latency);
+	report("total", started ? elapsed(&start) : 1.0, received, decoded_ok, malformed, latency, NULL);
+
+	if (unixpath)
+		unlink(unixpath);
+	sfx_keytable_free(&keys);
+
+	return EXIT_SUCCESS;
+}
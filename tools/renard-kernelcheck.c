@@ -0,0 +1,379 @@
+/*
+ * renard-kernelcheck: bit-exactness tests and execution time comparison of the Thumb assembly kernels (src/thumb/)
+ * against the C implementations, also checks the multi-buffer CRCs (SIMD if available) against the scalar CRCs and
+ * that encoding / decoding dispatches every AES / CRC call through the selected backend (counting backend)
+ *
+ * Meant to run under qemu-arm on a Linux host: build library and tools for a 32-bit ARM Linux target with the
+ * kernels enabled and run `make kernel-check` (see Makefile). Without option, all kernels are compared to the C
+ * implementations over random inputs and execution times per call are reported (nanoseconds, only meaningful
+ * relative to each other under emulation). Option -k runs a single implementation only, so that instructions can be
+ * counted by a qemu plugin; `make kernel-check` does so for every implementation if QEMU_PLUGIN is set.
+ */
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include "sigfox_crc.h"
+#include "ti_aes_128.h"
+#include "thumb_kernels.h"
+#include "backend.h"
+#include "uplink.h"
+#include "downlink.h"
+
+// random inputs per kernel for bit-exactness tests
+#define TEST_INPUTS 100000
+
+// longest CRC / convolutional coder input in the library: uplink packet of frame class 4 with CRC
+#define MAX_LENGTH 22
+
+static uint64_t rng_state = 1;
+
+static uint32_t rng(void)
+{
+	rng_state = rng_state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return rng_state >> 33;
+}
+
+static void rng_fill(uint8_t *buffer, uint8_t length)
+{
+	for (uint8_t i = 0; i < length; ++i)
+		buffer[i] = rng();
+}
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+/*
+ * C reference implementations (uplink_class.c only contains the inlined coder)
+ */
+static void convcode_c(uint8_t *buffer, uint8_t length, uint8_t polynomial)
+{
+	uint16_t window = 0x0000;
+	for (uint8_t i = 0; i < length; ++i) {
+		window = (window << 8) | buffer[i];
+		buffer[i] = window ^ ((polynomial & 0x02) ? window >> 1 : 0) ^ (window >> 2);
+	}
+}
+
+static void aes_c(uint8_t *block, const uint8_t *key)
+{
+	renard_aes_enc_dec(block, key, 0);
+}
+
+static uint16_t crc16_c(uint8_t const data[], uint8_t length)
+{
+	return renard_crc16_software(data, length);
+}
+
+// maximum number of buffers per multi-buffer CRC call, more than the lanes of the widest SIMD unit
+#define MAX_BUFFERS 80
+
+static bool check_crc_multi(void)
+{
+	static uint8_t buffers[MAX_BUFFERS][MAX_LENGTH];
+	uint8_t const *data[MAX_BUFFERS];
+	uint16_t crc16[MAX_BUFFERS];
+	uint8_t crc8[MAX_BUFFERS];
+
+	for (uint32_t n = 0; n < TEST_INPUTS / MAX_BUFFERS; ++n) {
+		uint8_t length = rng() % (MAX_LENGTH + 1);
+		uint16_t count = rng() % (MAX_BUFFERS + 1);
+
+		for (uint16_t i = 0; i < count; ++i) {
+			rng_fill(buffers[i], length);
+			data[i] = buffers[i];
+		}
+
+		renard_crc16_multi(data, length, count, crc16);
+		renard_crc8_multi(data, length, count, crc8);
+
+		for (uint16_t i = 0; i < count; ++i) {
+			if (crc16[i] != renard_crc16_software(buffers[i], length) || crc8[i] != renard_crc8_software(buffers[i], length)) {
+				fprintf(stderr, "crc multi: mismatch for buffer %u of %u, length %u\n", i, count, length);
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+#ifndef RENARD_NO_COUNTING_BACKEND
+static bool check_counts(const char *operation, uint32_t aes_blocks, uint32_t crc16, uint32_t crc8)
+{
+	renard_backend_counters *stats = &renard_backend_counting_stats;
+	bool ok = stats->aes_blocks == aes_blocks && stats->crc16 == crc16 && stats->crc8 == crc8;
+
+	if (!ok)
+		fprintf(stderr, "backend: %s: %u AES blocks, %u CRC-16, %u CRC-8, expected %u, %u, %u\n", operation,
+			stats->aes_blocks, stats->crc16, stats->crc8, aes_blocks, crc16, crc8);
+
+	memset(stats, 0, sizeof(*stats));
+	return ok;
+}
+
+/*
+ * Encode and decode one uplink (12-byte payload: MAC over two AES blocks) and one downlink (MAC over one AES block)
+ * with the counting backend, so that primitives that bypass the backend are noticed
+ */
+static bool check_backend(void)
+{
+	sfx_commoninfo common = { .seqnum = 0x123, .devid = 0x01234567 };
+	sfx_ul_plain uplink = { .payloadlen = 12, .replicas = true };
+	sfx_dl_plain downlink = { .payload = { 0 } };
+	sfx_ul_encoded ul_encoded;
+	sfx_dl_encoded dl_encoded;
+	sfx_ul_plain ul_decoded;
+	sfx_dl_plain dl_decoded;
+	bool ok = true;
+
+	rng_fill(common.key, sizeof(common.key));
+	rng_fill(uplink.payload, uplink.payloadlen);
+	rng_fill(downlink.payload, SFX_DL_PAYLOADLEN);
+
+	renard_backend_set(&renard_backend_counting);
+	memset(&renard_backend_counting_stats, 0, sizeof(renard_backend_counting_stats));
+
+	ok &= sfx_uplink_encode(uplink, common, &ul_encoded) == SFX_ULE_ERR_NONE;
+	ok &= check_counts("uplink encoding", 2, 1, 0);
+	ok &= sfx_uplink_decode(ul_encoded, &ul_decoded, &common, true) == SFX_ULD_ERR_NONE;
+	ok &= check_counts("uplink decoding", 2, 1, 0);
+
+	sfx_downlink_encode(downlink, common, &dl_encoded);
+	ok &= check_counts("downlink encoding", 1, 0, 1);
+	sfx_downlink_decode(dl_encoded, common, &dl_decoded);
+	ok &= dl_decoded.crc_ok && dl_decoded.mac_ok;
+	ok &= check_counts("downlink decoding", 1, 0, 1);
+
+	renard_backend_set(NULL);
+
+	ok &= ul_decoded.payloadlen == uplink.payloadlen && memcmp(ul_decoded.payload, uplink.payload, uplink.payloadlen) == 0;
+	ok &= memcmp(dl_decoded.payload, downlink.payload, SFX_DL_PAYLOADLEN) == 0;
+
+	return ok;
+}
+#endif
+
+#ifdef RENARD_THUMB_KERNELS
+static bool check_crc16(void)
+{
+	uint8_t data[MAX_LENGTH];
+
+	for (uint32_t n = 0; n < TEST_INPUTS; ++n) {
+		uint8_t length = rng() % (MAX_LENGTH + 1);
+		rng_fill(data, length);
+		if (renard_crc16_thumb(data, length) != crc16_c(data, length)) {
+			fprintf(stderr, "crc16: mismatch for length %u\n", length);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool check_convcode(void)
+{
+	uint8_t reference[MAX_LENGTH];
+	uint8_t kernel[MAX_LENGTH];
+
+	for (uint32_t n = 0; n < TEST_INPUTS; ++n) {
+		uint8_t length = rng() % (MAX_LENGTH + 1);
+		uint8_t polynomial = (n & 1) ? 0x07 : 0x05;
+		rng_fill(reference, length);
+		memcpy(kernel, reference, length);
+		convcode_c(reference, length, polynomial);
+		renard_convcode_thumb(kernel, length, polynomial);
+		if (memcmp(reference, kernel, length) != 0) {
+			fprintf(stderr, "convcode: mismatch for polynomial %02x, length %u\n", polynomial, length);
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static bool check_aes(void)
+{
+	// FIPS-197 appendix C.1
+	const uint8_t fips_key[16] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f};
+	const uint8_t fips_cipher[16] = {0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30, 0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a};
+	uint8_t reference[16];
+	uint8_t kernel[16];
+	// unaligned key, the kernel must not assume word alignment
+	uint8_t key[17];
+
+	for (uint8_t i = 0; i < 16; ++i)
+		kernel[i] = i * 0x11;
+	renard_aes_128_encrypt_thumb(kernel, fips_key);
+	if (memcmp(kernel, fips_cipher, 16) != 0) {
+		fprintf(stderr, "aes: FIPS-197 test vector failed\n");
+		return false;
+	}
+
+	for (uint32_t n = 0; n < TEST_INPUTS; ++n) {
+		rng_fill(reference, 16);
+		rng_fill(key, 17);
+		memcpy(kernel, reference, 16);
+		aes_c(reference, key + (n & 1));
+		renard_aes_128_encrypt_thumb(kernel, key + (n & 1));
+		if (memcmp(reference, kernel, 16) != 0) {
+			fprintf(stderr, "aes: mismatch\n");
+			return false;
+		}
+	}
+
+	return true;
+}
+#endif
+
+/*
+ * Benchmarks, every implementation processes the same input `iterations` times
+ */
+typedef struct {
+	const char *name;
+	void (*run)(uint32_t iterations);
+} bench;
+
+static volatile uint16_t sink;
+
+static void bench_crc16(uint16_t (*crc16)(uint8_t const data[], uint8_t length), uint32_t iterations)
+{
+	uint8_t data[MAX_LENGTH];
+	rng_fill(data, sizeof(data));
+	for (uint32_t n = 0; n < iterations; ++n)
+		sink = crc16(data, sizeof(data));
+}
+
+static void bench_convcode(void (*convcode)(uint8_t *buffer, uint8_t length, uint8_t polynomial), uint32_t iterations)
+{
+	uint8_t data[MAX_LENGTH];
+	rng_fill(data, sizeof(data));
+	for (uint32_t n = 0; n < iterations; ++n)
+		convcode(data, sizeof(data), 0x07);
+	sink = data[0];
+}
+
+static void bench_aes(void (*aes)(uint8_t *block, const uint8_t *key), uint32_t iterations)
+{
+	uint8_t block[16];
+	uint8_t key[16];
+	rng_fill(block, 16);
+	rng_fill(key, 16);
+	for (uint32_t n = 0; n < iterations; ++n)
+		aes(block, key);
+	sink = block[0];
+}
+
+static void bench_crc16_c(uint32_t iterations) { bench_crc16(crc16_c, iterations); }
+static void bench_convcode_c(uint32_t iterations) { bench_convcode(convcode_c, iterations); }
+static void bench_aes_c(uint32_t iterations) { bench_aes(aes_c, iterations); }
+
+#ifdef RENARD_THUMB_KERNELS
+static void bench_crc16_thumb(uint32_t iterations) { bench_crc16(renard_crc16_thumb, iterations); }
+static void bench_convcode_thumb(uint32_t iterations) { bench_convcode(renard_convcode_thumb, iterations); }
+static void bench_aes_thumb(uint32_t iterations) { bench_aes(renard_aes_128_encrypt_thumb, iterations); }
+#endif
+
+static const bench benches[] = {
+	{"crc16-c", bench_crc16_c},
+	{"convcode-c", bench_convcode_c},
+	{"aes-c", bench_aes_c},
+#ifdef RENARD_THUMB_KERNELS
+	{"crc16-thumb", bench_crc16_thumb},
+	{"convcode-thumb", bench_convcode_thumb},
+	{"aes-thumb", bench_aes_thumb},
+#endif
+};
+
+#define BENCH_COUNT (sizeof(benches) / sizeof(benches[0]))
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [-n iterations] [-k implementation]\n", name);
+	fprintf(stderr, "  -n: calls per benchmark (default 10000)\n");
+	fprintf(stderr, "  -k: only run benchmark of one implementation (for instruction counting):");
+	for (size_t i = 0; i < BENCH_COUNT; ++i)
+		fprintf(stderr, " %s", benches[i].name);
+	fprintf(stderr, "\n");
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t iterations = 10000;
+	const char *only = NULL;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:k:h")) != -1) {
+		switch (opt) {
+		case 'n':
+			iterations = strtoul(optarg, NULL, 10);
+			break;
+		case 'k':
+			only = optarg;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+	}
+
+	if (iterations == 0) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (only) {
+		for (size_t i = 0; i < BENCH_COUNT; ++i) {
+			if (strcmp(benches[i].name, only) == 0) {
+				benches[i].run(iterations);
+				return EXIT_SUCCESS;
+			}
+		}
+		fprintf(stderr, "Unknown implementation: %s\n", only);
+		return EXIT_FAILURE;
+	}
+
+	bool multi_ok = check_crc_multi();
+	printf("bit-exactness (%u random batches of up to %u inputs): multi-buffer crc16 / crc8 %s\n", TEST_INPUTS / MAX_BUFFERS,
+		MAX_BUFFERS, multi_ok ? "ok" : "FAILED");
+
+#ifndef RENARD_NO_COUNTING_BACKEND
+	bool backend_ok = check_backend();
+	printf("backend dispatch (counting backend, uplink / downlink encoding and decoding): %s\n", backend_ok ? "ok" : "FAILED");
+#else
+	bool backend_ok = true;
+#endif
+
+#ifdef RENARD_THUMB_KERNELS
+	bool crc16_ok = check_crc16();
+	bool convcode_ok = check_convcode();
+	bool aes_ok = check_aes();
+	printf("bit-exactness (%u random inputs each): crc16 %s, convcode %s, aes %s\n", TEST_INPUTS,
+		crc16_ok ? "ok" : "FAILED", convcode_ok ? "ok" : "FAILED", aes_ok ? "ok" : "FAILED");
+#else
+	printf("built without RENARD_THUMB_KERNELS, only C implementations are available\n");
+#endif
+
+	for (size_t i = 0; i < BENCH_COUNT; ++i) {
+		uint64_t start = now_ns();
+		benches[i].run(iterations);
+		printf("%-16s %10.1f ns/call\n", benches[i].name, (double)(now_ns() - start) / iterations);
+	}
+
+#ifdef RENARD_THUMB_KERNELS
+	return multi_ok && backend_ok && crc16_ok && convcode_ok && aes_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+#else
+	return multi_ok && backend_ok ? EXIT_SUCCESS : EXIT_FAILURE;
+#endif
+}
@@ -0,0 +1,166 @@
+/*
+ * renard-replay: replay archived captures (see capture.h) to an ingest daemon (see renard-ingest.c)
+ *
+ * Records are sent as individual datagrams in batches with sendmmsg, paced to a target frame rate.
+ * Each record's timestamp is replaced with the time of sending, so that the daemon can measure latency.
+ */
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <time.h>
+
+#include <sys/socket.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "capture.h"
+#include "net.h"
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options] <capture>\n", name);
+	fprintf(stderr, "  -a addr     UDP destination address (default: 127.0.0.1)\n");
+	fprintf(stderr, "  -p port     UDP destination port (default: %d)\n", SFX_INGEST_DEFAULT_PORT);
+	fprintf(stderr, "  -u path     send to Unix domain datagram socket instead of UDP\n");
+	fprintf(stderr, "  -r rate     target rate in frames per second (default: unlimited)\n");
+	fprintf(stderr, "  -n frames   number of frames to send, capture is repeated if necessary (default: all records once)\n");
+	fprintf(stderr, "  -b batch    number of datagrams per sendmmsg call (default: 64, max: %d)\n", SFX_NET_MAX_BATCH);
+}
+
+static double monotonic(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv)
+{
+	const char *address = "127.0.0.1";
+	uint16_t port = SFX_INGEST_DEFAULT_PORT;
+	const char *unixpath = NULL;
+	double rate = 0;
+	uint64_t frames = 0;
+	uint32_t batch = 64;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "a:p:u:r:n:b:h")) != -1) {
+		switch (opt) {
+		case 'a': address = optarg; break;
+		case 'p': port = strtoul(optarg, NULL, 0); break;
+		case 'u': unixpath = optarg; break;
+		case 'r': rate = strtod(optarg, NULL); break;
+		case 'n': frames = strtoull(optarg, NULL, 0); break;
+		case 'b': batch = strtoul(optarg, NULL, 0); break;
+		default: usage(argv[0]); return EXIT_FAILURE;
+		}
+	}
+
+	if (optind + 1 != argc) {
+		usage(argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	if (batch < 1)
+		batch = 1;
+	if (batch > SFX_NET_MAX_BATCH)
+		batch = SFX_NET_MAX_BATCH;
+
+	/*
+	 * Map capture file
+	 */
+	int infd = open(argv[optind], O_RDONLY);
+	struct stat st;
+	if (infd < 0 || fstat(infd, &st) != 0) {
+		perror(argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	const sfx_capture_header *capture = st.st_size > 0 ? mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, infd, 0) : MAP_FAILED;
+	if (capture == MAP_FAILED || !sfx_capture_header_valid(capture, st.st_size) || capture->record_count == 0) {
+		fprintf(stderr, "%s: not a valid capture file\n", argv[optind]);
+		return EXIT_FAILURE;
+	}
+
+	if (frames == 0)
+		frames = capture->record_count;
+
+	/*
+	 * Connected datagram socket
+	 */
+	struct sockaddr_storage addr;
+	socklen_t addrlen = sfx_net_address(&addr, unixpath, address, port);
+	if (addrlen == 0) {
+		fprintf(stderr, "Invalid destination address\n");
+		return EXIT_FAILURE;
+	}
+
+	int fd = socket(addr.ss_family, SOCK_DGRAM, 0);
+	if (fd < 0 || connect(fd, (struct sockaddr *)&addr, addrlen) != 0) {
+		perror("connect");
+		return EXIT_FAILURE;
+	}
+
+	static sfx_capture_record records[SFX_NET_MAX_BATCH];
+	struct mmsghdr msgs[SFX_NET_MAX_BATCH];
+	struct iovec iovecs[SFX_NET_MAX_BATCH];
+
+	memset(msgs, 0, sizeof(msgs));
+	for (uint32_t i = 0; i < batch; ++i) {
+		iovecs[i].iov_base = &records[i];
+		iovecs[i].iov_len = sizeof(records[i]);
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	/*
+	 * Send batches, frame k is due at start + k / rate
+	 */
+	uint64_t sent = 0;
+	uint64_t failed = 0;
+	uint64_t next = 0;
+	double start = monotonic();
+
+	while (sent + failed < frames) {
+		uint32_t count = frames - sent - failed < batch ? frames - sent - failed : batch;
+
+		if (rate > 0) {
+			double due = start + (sent + failed) / rate;
+			double now = monotonic();
+			if (due > now)
+				usleep((useconds_t)((due - now) * 1e6));
+		}
+
+		uint64_t timestamp = sfx_now_us();
+		for (uint32_t i = 0; i < count; ++i) {
+			records[i] = *sfx_capture_record_get(capture, next);
+			records[i].timestamp = timestamp;
+			next = next + 1 < capture->record_count ? next + 1 : 0;
+		}
+
+		for (uint32_t done = 0; done < count;) {
+			int r = sendmmsg(fd, msgs + done, count - done, 0);
+			if (r > 0) {
+				done += r;
+				sent += r;
+			} else if (errno != EINTR && errno != EAGAIN && errno != ENOBUFS) {
+				// e.g. ECONNREFUSED if daemon is not running yet, drop remainder of batch
+				failed += count - done;
+				break;
+			}
+		}
+	}
+
+	double duration = monotonic() - start;
+	fprintf(stderr, "sent %" PRIu64 " frames in %.3f s (%.0f frames/s), %" PRIu64 " failed\n",
+			sent, duration, duration > 0 ? sent / duration : 0.0, failed);
+
+	return EXIT_SUCCESS;
+}
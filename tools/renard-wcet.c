@@ -0,0 +1,362 @@
+/*
+ * renard-wcet: execution time measurement harness for uplink / downlink decoding and AES over adversarial inputs
+ *
+ * Every case decodes a pool of inputs that are all built to take the same path through the decoder (valid frame,
+ * invalid CRC, MAC mismatch in the first / last compared byte, corrupted frame type, ...). Execution times of the
+ * cases are reported as min / percentiles / max in timestamp counter cycles (x86), counter ticks (AArch64) or
+ * nanoseconds (other targets). With a library built by `make CONSTANT_TIME=1` (see src/renard_config.h), the spread
+ * between the MAC and CRC cases of a frame class shrinks, but does not vanish (the CRC still branches on the data);
+ * the maximum over all cases is the WCET figure.
+ *
+ * The maximum of a single run includes interrupts and preemption of the host, pin the harness to an isolated CPU
+ * (option -c) and compare p99.9 against max to judge the noise.
+ */
+#define _GNU_SOURCE
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <sched.h>
+#include <time.h>
+
+#include <unistd.h>
+
+#include "uplink.h"
+#include "downlink.h"
+#include "ti_aes_128.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TIMER_UNIT "cycles"
+static inline uint64_t timer_read(void)
+{
+	unsigned int aux;
+	return __rdtscp(&aux);
+}
+#elif defined(__aarch64__)
+#define TIMER_UNIT "ticks"
+static inline uint64_t timer_read(void)
+{
+	uint64_t value;
+	__asm__ volatile("isb; mrs %0, cntvct_el0" : "=r"(value));
+	return value;
+}
+#else
+#define TIMER_UNIT "ns"
+static inline uint64_t timer_read(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+#endif
+
+// number of distinct inputs per case, inputs are used round-robin
+#define POOL 64
+
+typedef enum {
+	CASE_UL_VALID,
+	CASE_UL_CRC,
+	CASE_UL_MAC_FIRST,
+	CASE_UL_MAC_LAST,
+	CASE_UL_FTYPE,
+	CASE_DL_VALID,
+	CASE_DL_FEC,
+	CASE_DL_CRC,
+	CASE_DL_MAC,
+	CASE_AES_RANDOM,
+	CASE_AES_ZERO
+} case_kind;
+
+typedef struct {
+	sfx_ul_encoded ul[POOL];
+	sfx_dl_encoded dl[POOL];
+	sfx_commoninfo common[POOL];
+	uint8_t block[POOL][16];
+} case_inputs;
+
+static uint64_t rng_state = 1;
+
+static uint32_t rng(void)
+{
+	// xorshift64*
+	rng_state ^= rng_state >> 12;
+	rng_state ^= rng_state << 25;
+	rng_state ^= rng_state >> 27;
+	return (rng_state * 0x2545f4914f6cdd1dULL) >> 32;
+}
+
+static void random_bytes(uint8_t *buf, size_t len)
+{
+	for (size_t i = 0; i < len; ++i)
+		buf[i] = rng();
+}
+
+static void flip_bit(uint8_t *buf, uint16_t bit)
+{
+	buf[bit / 8] ^= 0x80 >> (bit % 8);
+}
+
+/**
+ * @brief byte of packet in initial transmission frame (packet starts after the 3 frame type nibbles)
+ */
+static uint8_t mac_byte(const uint8_t *frame, uint8_t offset)
+{
+	return (frame[offset + 1] << 4) | (frame[offset + 2] >> 4);
+}
+
+/**
+ * @brief build uplink input for given case, frame class (payload length, 0 = single bit) and replica
+ */
+static void build_uplink(case_kind kind, uint8_t payloadlen, uint8_t replica, sfx_ul_encoded *out, sfx_commoninfo *common)
+{
+	sfx_ul_plain uplink;
+	sfx_ul_encoded encoded;
+
+	memset(&uplink, 0, sizeof(uplink));
+	common->devid = rng();
+	common->seqnum = rng() & 0xfff;
+	random_bytes(common->key, sizeof(common->key));
+
+	uplink.singlebit = payloadlen == 0;
+	uplink.payloadlen = payloadlen;
+	uplink.payload[0] = rng() & 1;
+	if (payloadlen > 0)
+		random_bytes(uplink.payload, payloadlen);
+	uplink.request_downlink = rng() & 1;
+	uplink.replicas = true;
+
+	sfx_uplink_encode(uplink, *common, &encoded);
+	memset(out, 0, sizeof(*out));
+	memcpy(out->frame[0], encoded.frame[replica], SFX_UL_MAX_FRAMELEN);
+	out->framelen_nibbles = encoded.framelen_nibbles;
+
+	switch (kind) {
+	case CASE_UL_CRC:
+		// bit error in last CRC bit, passes all checks up to the CRC comparison
+		flip_bit(out->frame[0], out->framelen_nibbles * 4 - 1);
+		break;
+	case CASE_UL_MAC_FIRST:
+		// different NAK: computed MAC differs from received MAC (almost always) in the first byte
+		common->key[0] ^= 0x01;
+		break;
+	case CASE_UL_MAC_LAST: {
+		// search NAK whose MAC matches the received one in the first byte, so the comparison fails late
+		uint8_t macoffset = 6 + payloadlen;
+		uint8_t original[SFX_UL_MAX_FRAMELEN];
+		sfx_commoninfo trial = *common;
+
+		memcpy(original, encoded.frame[0], sizeof(original));
+		do {
+			random_bytes(trial.key, sizeof(trial.key));
+			sfx_uplink_encode(uplink, trial, &encoded);
+		} while (mac_byte(encoded.frame[0], macoffset) != mac_byte(original, macoffset) || memcmp(encoded.frame[0], original, sizeof(original)) == 0);
+
+		memcpy(common->key, trial.key, sizeof(common->key));
+		break;
+	}
+	case CASE_UL_FTYPE:
+		// two erroneous frame type bits, still classified correctly
+		flip_bit(out->frame[0], rng() % 6);
+		flip_bit(out->frame[0], 6 + rng() % 6);
+		break;
+	default:
+		break;
+	}
+}
+
+static void build_downlink(case_kind kind, sfx_dl_encoded *out, sfx_commoninfo *common)
+{
+	sfx_dl_plain downlink;
+
+	common->devid = rng();
+	common->seqnum = rng() & 0xfff;
+	random_bytes(common->key, sizeof(common->key));
+	random_bytes(downlink.payload, sizeof(downlink.payload));
+	sfx_downlink_encode(downlink, *common, out);
+
+	switch (kind) {
+	case CASE_DL_FEC:
+		// one bit error per interleaved codeword, all corrected by BCH
+		for (uint8_t bit = 0; bit < 8; ++bit)
+			flip_bit(out->frame, (rng() % SFX_DL_FRAMELEN) * 8 + bit);
+		break;
+	case CASE_DL_CRC:
+		// two bit errors in one codeword, not correctable
+		flip_bit(out->frame, 4 * 8);
+		flip_bit(out->frame, 9 * 8);
+		break;
+	case CASE_DL_MAC:
+		common->key[0] ^= 0x01;
+		break;
+	default:
+		break;
+	}
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return x < y ? -1 : x > y;
+}
+
+static uint64_t percentile(const uint64_t *sorted, uint32_t count, double p)
+{
+	uint32_t index = (uint32_t)(p * count);
+	return sorted[index >= count ? count - 1 : index];
+}
+
+static uint64_t measure(case_kind kind, case_inputs *in, uint32_t iterations, uint64_t *samples, const char *label)
+{
+	volatile uint32_t sink = 0;
+
+	for (uint32_t i = 0; i < iterations; ++i) {
+		uint32_t k = i % POOL;
+		sfx_ul_plain ul_plain;
+		sfx_dl_plain dl_plain;
+		sfx_commoninfo common = in->common[k];
+		uint8_t block[16];
+		uint64_t start, end;
+
+		switch (kind) {
+		case CASE_UL_VALID:
+		case CASE_UL_CRC:
+		case CASE_UL_MAC_FIRST:
+		case CASE_UL_MAC_LAST:
+		case CASE_UL_FTYPE:
+			start = timer_read();
+			sink += sfx_uplink_decode(in->ul[k], &ul_plain, &common, true);
+			end = timer_read();
+			break;
+		case CASE_DL_VALID:
+		case CASE_DL_FEC:
+		case CASE_DL_CRC:
+		case CASE_DL_MAC:
+			start = timer_read();
+			sfx_downlink_decode(in->dl[k], common, &dl_plain);
+			end = timer_read();
+			sink += dl_plain.crc_ok + dl_plain.mac_ok;
+			break;
+		default:
+			memcpy(block, in->block[k], sizeof(block));
+			start = timer_read();
+			renard_aes_enc_dec(block, common.key, 0);
+			end = timer_read();
+			sink += block[0];
+			break;
+		}
+
+		samples[i] = end - start;
+	}
+
+	qsort(samples, iterations, sizeof(*samples), compare_u64);
+	printf("%-24s %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 " %10" PRIu64 "\n", label,
+			samples[0], percentile(samples, iterations, 0.5), percentile(samples, iterations, 0.99),
+			percentile(samples, iterations, 0.999), samples[iterations - 1]);
+
+	(void)sink;
+	return percentile(samples, iterations, 0.999);
+}
+
+static void usage(const char *name)
+{
+	fprintf(stderr, "Usage: %s [options]\n", name);
+	fprintf(stderr, "  -n iter     measured executions per case (default: 100000)\n");
+	fprintf(stderr, "  -c cpu      pin harness to CPU\n");
+	fprintf(stderr, "  -s seed     random seed for inputs (default: 1)\n");
+}
+
+int main(int argc, char **argv)
+{
+	static const uint8_t class_payloadlen[] = {0, 1, 4, 8, 12};
+	static const char *ul_names[] = {"valid", "crc", "mac-first", "mac-last", "ftype"};
+	static const char *dl_names[] = {"valid", "fec", "crc", "mac"};
+	uint32_t iterations = 100000;
+	int cpu = -1;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "n:c:s:h")) != -1) {
+		switch (opt) {
+		case 'n': iterations = strtoul(optarg, NULL, 0); break;
+		case 'c': cpu = strtol(optarg, NULL, 0); break;
+		case 's': rng_state = strtoull(optarg, NULL, 0) | 1; break;
+		default: usage(argv[0]); return EXIT_FAILURE;
+		}
+	}
+
+	if (iterations < POOL)
+		iterations = POOL;
+
+	if (cpu >= 0) {
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		if (sched_setaffinity(0, sizeof(set), &set) != 0)
+			perror("sched_setaffinity");
+	}
+
+	case_inputs *in = malloc(sizeof(case_inputs));
+	uint64_t *samples = malloc(iterations * sizeof(uint64_t));
+	if (!in || !samples) {
+		fprintf(stderr, "Out of memory\n");
+		return EXIT_FAILURE;
+	}
+
+	printf("%-24s %10s %10s %10s %10s %10s  (%s)\n", "case", "min", "p50", "p99", "p99.9", "max", TIMER_UNIT);
+
+	/*
+	 * Uplinks: every frame class, inputs of a case alternate between initial transmission and replicas
+	 */
+	for (uint8_t c = 0; c < sizeof(class_payloadlen); ++c) {
+		uint64_t lowest = UINT64_MAX, highest = 0;
+
+		for (case_kind kind = CASE_UL_VALID; kind <= CASE_UL_FTYPE; ++kind) {
+			char label[32];
+
+			for (uint32_t k = 0; k < POOL; ++k)
+				build_uplink(kind, class_payloadlen[c], k % 3, &in->ul[k], &in->common[k]);
+
+			snprintf(label, sizeof(label), "ul class %c %s", 'A' + c, ul_names[kind - CASE_UL_VALID]);
+			uint64_t p999 = measure(kind, in, iterations, samples, label);
+			lowest = p999 < lowest ? p999 : lowest;
+			highest = p999 > highest ? p999 : highest;
+		}
+
+		printf("%-24s %10s %10s %10s %10" PRIu64 "\n", "  spread p99.9", "", "", "", highest - lowest);
+	}
+
+	/*
+	 * Downlinks
+	 */
+	for (case_kind kind = CASE_DL_VALID; kind <= CASE_DL_MAC; ++kind) {
+		char label[32];
+
+		for (uint32_t k = 0; k < POOL; ++k)
+			build_downlink(kind, &in->dl[k], &in->common[k]);
+
+		snprintf(label, sizeof(label), "dl %s", dl_names[kind - CASE_DL_VALID]);
+		measure(kind, in, iterations, samples, label);
+	}
+
+	/*
+	 * AES block encryption: random versus constant inputs (table lookups at the same versus varying indices)
+	 */
+	for (uint32_t k = 0; k < POOL; ++k) {
+		random_bytes(in->block[k], 16);
+		random_bytes(in->common[k].key, 16);
+	}
+	measure(CASE_AES_RANDOM, in, iterations, samples, "aes random");
+
+	for (uint32_t k = 0; k < POOL; ++k) {
+		memset(in->block[k], 0, 16);
+		memset(in->common[k].key, 0, 16);
+	}
+	measure(CASE_AES_ZERO, in, iterations, samples, "aes zero");
+
+	free(samples);
+	free(in);
+
+	return EXIT_SUCCESS;
+}